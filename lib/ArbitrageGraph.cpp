@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "ArbitrageGraph.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <iostream>
+#include <set>
+#include <sstream>
+
+using namespace portopt;
+
+// https://en.wikipedia.org/wiki/Bellman%E2%80%93Ford_algorithm
+// https://en.wikipedia.org/wiki/Shortest_path_faster_algorithm
+// https://stackoverflow.com/questions/2282427/interesting-problem-currency-arbitrage
+
+namespace {
+
+constexpr double epsilon = 1e-12; // ignore relaxations and cycles within rounding error of zero
+
+std::uint64_t edgeKey(std::size_t from, std::size_t to)
+{
+    return (static_cast<std::uint64_t>(from) << 32U) | static_cast<std::uint64_t>(to);
+}
+
+// Cycles of the predecessor graph (each node has at most one incoming edge), as lists of edge indexes in trading order
+std::vector<std::vector<std::size_t>> predecessorCycles(const std::vector<ArbitrageGraph::Edge>& edges, const std::vector<std::size_t>& predEdge)
+{
+    constexpr std::size_t unvisited = ArbitrageGraph::npos;
+    std::vector<std::vector<std::size_t>> result;
+    std::vector<std::size_t> walk(predEdge.size(), unvisited); // id of the walk that first visited each node
+    for (std::size_t start = 0; start < predEdge.size(); ++start) {
+        std::size_t node = start;
+        while (node != ArbitrageGraph::npos && walk[node] == unvisited) {
+            walk[node] = start;
+            node = predEdge[node] == ArbitrageGraph::npos ? ArbitrageGraph::npos : edges[predEdge[node]].from;
+        }
+        if (node == ArbitrageGraph::npos || walk[node] != start) {
+            continue; // reached the source or a walk that was already handled
+        }
+        // node is on a new cycle, collect its edges walking backward
+        std::vector<std::size_t> cycle;
+        std::size_t current = node;
+        do {
+            cycle.push_back(predEdge[current]);
+            current = edges[predEdge[current]].from;
+        } while (current != node);
+        std::reverse(cycle.begin(), cycle.end());
+        result.push_back(std::move(cycle));
+    }
+    return result;
+}
+
+// Queue-based relaxation from a virtual source, stops as soon as the predecessor graph has a cycle
+std::vector<std::vector<std::size_t>> runSpfa(const ArbitrageGraph& graph, const std::vector<bool>& disabled)
+{
+    const std::size_t numNodes = graph.numNodes();
+    const auto& edges = graph.edges();
+
+    std::vector<double> distance(numNodes, 0); // the virtual source reaches every node with weight 0
+    std::vector<std::size_t> predEdge(numNodes, ArbitrageGraph::npos);
+    std::vector<bool> inQueue(numNodes, true);
+    std::deque<std::size_t> queue;
+    for (std::size_t i = 0; i < numNodes; ++i) {
+        queue.push_back(i);
+    }
+
+    std::size_t relaxations {};
+    while (!queue.empty()) {
+        const std::size_t u = queue.front();
+        queue.pop_front();
+        inQueue[u] = false;
+        for (const std::size_t e : graph.outEdges(u)) {
+            if (disabled[e]) {
+                continue;
+            }
+            const auto& edge = edges[e];
+            const double candidate = distance[u] + edge.weight;
+            if (candidate >= distance[edge.to] - epsilon) {
+                continue;
+            }
+            distance[edge.to] = candidate;
+            predEdge[edge.to] = e;
+            // a negative cycle shows up as a cycle of predecessors, checking every numNodes relaxations keeps this O(1) amortized
+            if (++relaxations % numNodes == 0) {
+                auto cycles = predecessorCycles(edges, predEdge);
+                if (!cycles.empty()) {
+                    return cycles;
+                }
+            }
+            if (!inQueue[edge.to]) {
+                inQueue[edge.to] = true;
+                queue.push_back(edge.to);
+            }
+        }
+    }
+    return {}; // converged, no negative cycle
+}
+
+} // anonymous namespace
+
+ArbitrageGraph::ArbitrageGraph(const CsvFile& pairs)
+{
+    for (const auto& row : pairs.data()) {
+        if (row.size() < 3) {
+            continue; // blank line
+        }
+        setRate(row.at(0), row.at(1), std::stod(row.at(2)));
+    }
+}
+
+std::size_t ArbitrageGraph::addNode(const std::string& name)
+{
+    const auto itr = m_nodes.find(name);
+    if (itr != m_nodes.end()) {
+        return itr->second;
+    }
+    m_names.push_back(name);
+    m_outEdges.emplace_back();
+    m_nodes.insert({ name, m_names.size() - 1 });
+    return m_names.size() - 1;
+}
+
+std::size_t ArbitrageGraph::index(const std::string& name) const
+{
+    const auto itr = m_nodes.find(name);
+    return itr == m_nodes.end() ? npos : itr->second;
+}
+
+std::size_t ArbitrageGraph::findEdge(std::size_t from, std::size_t to) const
+{
+    const auto itr = m_edgeIndex.find(edgeKey(from, to));
+    return itr == m_edgeIndex.end() ? npos : itr->second;
+}
+
+bool ArbitrageGraph::setRate(const std::string& from, const std::string& to, double rate)
+{
+    if (!std::isfinite(rate) || rate <= 0 || from == to) {
+        std::cerr << "ArbitrageGraph::setRate [invalid] " << from << " -> " << to << " : " << rate << "\n";
+        return false;
+    }
+    const std::size_t u = addNode(from);
+    const std::size_t v = addNode(to);
+    setEdge(u, v, rate, false);
+
+    // the opposite direction is implied unless it was quoted explicitly
+    const std::size_t reverse = findEdge(v, u);
+    if (reverse == npos || m_edges[reverse].implied) {
+        setEdge(v, u, 1.0 / rate, true);
+    }
+    return true;
+}
+
+void ArbitrageGraph::setEdge(std::size_t from, std::size_t to, double rate, bool implied)
+{
+    const std::size_t e = findEdge(from, to);
+    if (e != npos) {
+        m_edges[e].rate = rate;
+        m_edges[e].weight = -std::log(rate);
+        m_edges[e].implied = implied;
+        return;
+    }
+    m_edges.push_back({ from, to, rate, -std::log(rate), implied });
+    m_outEdges[from].push_back(m_edges.size() - 1);
+    m_edgeIndex.insert({ edgeKey(from, to), m_edges.size() - 1 });
+}
+
+std::vector<ArbitrageGraph::Cycle> ArbitrageGraph::findCycles() const
+{
+    std::vector<Cycle> result;
+    if (m_names.empty()) {
+        return result;
+    }
+
+    // the edges of each cycle found are disabled, then the search runs again until none is left
+    std::vector<bool> disabled(m_edges.size());
+    std::set<std::vector<std::size_t>> seen;
+    while (true) {
+        const auto cycles = runSpfa(*this, disabled);
+        if (cycles.empty()) {
+            break;
+        }
+        for (const auto& edgeList : cycles) {
+            Cycle cycle;
+            double weight {};
+            std::size_t weakest = edgeList.front();
+            for (const std::size_t e : edgeList) {
+                cycle.nodes.push_back(m_edges[e].from);
+                weight += m_edges[e].weight;
+                if (m_edges[e].weight > m_edges[weakest].weight) {
+                    weakest = e;
+                }
+            }
+            if (weight >= -epsilon) {
+                disabled[weakest] = true; // within rounding error of zero, only break it
+                continue;
+            }
+            for (const std::size_t e : edgeList) {
+                disabled[e] = true;
+            }
+            cycle.gain = std::exp(-weight) - 1;
+
+            // same cycle starting from a different node
+            auto key = cycle.nodes;
+            std::rotate(key.begin(), std::min_element(key.begin(), key.end()), key.end());
+            if (seen.insert(key).second) {
+                result.push_back(std::move(cycle));
+            }
+        }
+    }
+    return result;
+}
+
+double ArbitrageGraph::cycleWeight(const Cycle& cycle) const
+{
+    double weight {};
+    for (std::size_t i = 0; i < cycle.nodes.size(); ++i) {
+        const std::size_t e = findEdge(cycle.nodes[i], cycle.nodes[(i + 1) % cycle.nodes.size()]);
+        if (e == npos) {
+            return 0; // the cycle no longer exists
+        }
+        weight += m_edges[e].weight;
+    }
+    return weight;
+}
+
+std::string ArbitrageGraph::to_string(const Cycle& cycle) const
+{
+    std::ostringstream oss;
+    for (const std::size_t node : cycle.nodes) {
+        oss << m_names.at(node) << " -> ";
+    }
+    if (!cycle.nodes.empty()) {
+        oss << m_names.at(cycle.nodes.front());
+    }
+    oss << " : " << cycle.gain * 100 << "%";
+    return oss.str();
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#pragma once
+
+#include "CsvFile.hpp"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace portopt {
+
+// Sparse directed graph of exchange rates, edge weight is -log(rate) so a negative cycle is an arbitrage opportunity
+class ArbitrageGraph {
+public:
+    struct Edge {
+        std::size_t from {};
+        std::size_t to {};
+        double rate {}; // units of "to" received for one unit of "from"
+        double weight {}; // -log(rate)
+        bool implied {}; // true if the rate is the inverse of the opposite pair
+    };
+
+    struct Cycle {
+        std::vector<std::size_t> nodes; // assets in trading order, the last one trades back to the first
+        double gain {}; // product of the rates around the cycle minus one
+    };
+
+    ArbitrageGraph() = default;
+    explicit ArbitrageGraph(const CsvFile& pairs); // rows of {from, to, rate}
+
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    std::size_t addNode(const std::string& name); // returns the index of a new or existing node
+    bool setRate(const std::string& from, const std::string& to, double rate); // adds or updates a pair and its implied inverse, false if invalid
+
+    [[nodiscard]] std::size_t numNodes() const noexcept { return m_names.size(); }
+    [[nodiscard]] std::size_t numEdges() const noexcept { return m_edges.size(); }
+    [[nodiscard]] const std::string& name(std::size_t node) const { return m_names.at(node); }
+    [[nodiscard]] std::size_t index(const std::string& name) const; // index of a node or npos
+    [[nodiscard]] const std::vector<Edge>& edges() const noexcept { return m_edges; }
+    [[nodiscard]] const std::vector<std::size_t>& outEdges(std::size_t node) const { return m_outEdges.at(node); }
+    [[nodiscard]] std::size_t findEdge(std::size_t from, std::size_t to) const; // index of an edge or npos
+
+    // An edge-disjoint subset of the profitable cycles, found with queue-based Bellman-Ford (SPFA) from a virtual
+    // source connected to every node. The edges of each reported cycle are left out of the following searches, so a
+    // cycle sharing a pair with one already reported is not listed (both would trade against the same quote).
+    [[nodiscard]] std::vector<Cycle> findCycles() const;
+
+    [[nodiscard]] double cycleWeight(const Cycle& cycle) const; // sum of the edge weights around a cycle
+    [[nodiscard]] std::string to_string(const Cycle& cycle) const;
+
+private:
+    void setEdge(std::size_t from, std::size_t to, double rate, bool implied);
+
+    std::vector<std::string> m_names; // node index -> asset name
+    std::unordered_map<std::string, std::size_t> m_nodes; // asset name -> node index
+    std::vector<Edge> m_edges;
+    std::vector<std::vector<std::size_t>> m_outEdges; // node index -> indexes of its outgoing edges
+    std::unordered_map<std::uint64_t, std::size_t> m_edgeIndex; // (from << 32 | to) -> edge index
+};
+
+} // namespace portopt
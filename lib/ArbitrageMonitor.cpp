@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "ArbitrageMonitor.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <queue>
+#include <unordered_map>
+
+using namespace portopt;
+
+namespace {
+
+constexpr double epsilon = 1e-12; // same tolerance as ArbitrageGraph
+
+bool containsEdge(const ArbitrageGraph::Cycle& cycle, std::size_t from, std::size_t to)
+{
+    for (std::size_t i = 0; i < cycle.nodes.size(); ++i) {
+        if (cycle.nodes[i] == from && cycle.nodes[(i + 1) % cycle.nodes.size()] == to) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // anonymous namespace
+
+ArbitrageMonitor::ArbitrageMonitor(const ArbitrageGraph& graph)
+{
+    for (const auto& edge : graph.edges()) {
+        if (!edge.implied) {
+            setRate(graph.name(edge.from), graph.name(edge.to), edge.rate);
+        }
+    }
+}
+
+ArbitrageMonitor::Update ArbitrageMonitor::setRate(const CsvFile::RowType& row)
+{
+    if (row.size() < 3) {
+        return {}; // blank line
+    }
+    try {
+        return setRate(row.at(0), row.at(1), std::stod(row.at(2)));
+    } catch (std::exception& e) {
+        std::cerr << "ArbitrageMonitor::setRate [exception] " << e.what() << "\n";
+        return {};
+    }
+}
+
+ArbitrageMonitor::Update ArbitrageMonitor::setRate(const std::string& from, const std::string& to, double rate)
+{
+    const auto start = std::chrono::steady_clock::now();
+    Update update;
+
+    if (!m_graph.setRate(from, to, rate)) {
+        return update; // self edge or a rate that isn't finite and positive, logged by the graph
+    }
+    m_potential.resize(m_graph.numNodes()); // new nodes have no incoming edges yet, 0 is feasible
+
+    const std::size_t u = m_graph.index(from);
+    const std::size_t v = m_graph.index(to);
+    std::vector<std::size_t> changed { m_graph.findEdge(u, v), m_graph.findEdge(v, u) };
+
+    // cycles through an updated edge may have stopped being profitable, their closing edge goes back in
+    for (auto itr = m_cycles.begin(); itr != m_cycles.end();) {
+        if (!containsEdge(itr->cycle, u, v) && !containsEdge(itr->cycle, v, u)) {
+            ++itr;
+            continue;
+        }
+        const double weight = m_graph.cycleWeight(itr->cycle);
+        if (weight < -epsilon) {
+            itr->cycle.gain = std::exp(-weight) - 1;
+            ++itr;
+            continue;
+        }
+        changed.push_back(itr->closingEdge);
+        update.vanished.push_back(std::move(itr->cycle));
+        itr = m_cycles.erase(itr);
+    }
+
+    for (const std::size_t e : changed) {
+        if (e != ArbitrageGraph::npos && !isClosing(e)) {
+            insertEdge(e, update);
+        }
+    }
+
+    update.latency = std::chrono::steady_clock::now() - start;
+    return update;
+}
+
+bool ArbitrageMonitor::isClosing(std::size_t e) const
+{
+    return std::any_of(m_cycles.begin(), m_cycles.end(), [e](const ActiveCycle& item) { return item.closingEdge == e; });
+}
+
+void ArbitrageMonitor::insertEdge(std::size_t e, Update& update)
+{
+    const auto& edges = m_graph.edges();
+    const auto& edge = edges[e];
+    const double delta = m_potential[edge.from] + edge.weight - m_potential[edge.to];
+    if (delta >= -epsilon) {
+        return; // potentials are still feasible
+    }
+
+    // Dijkstra from edge.to on reduced costs, only nodes whose potential would drop are expanded
+    using Item = std::pair<double, std::size_t>; // {potential change, node}
+    std::priority_queue<Item, std::vector<Item>, std::greater<>> heap;
+    std::unordered_map<std::size_t, double> change; // node -> best potential change found so far
+    std::unordered_map<std::size_t, std::size_t> predEdge; // node -> edge used to reach it
+    std::unordered_map<std::size_t, bool> settled;
+
+    change[edge.to] = delta;
+    predEdge[edge.to] = e;
+    heap.emplace(delta, edge.to);
+
+    while (!heap.empty()) {
+        const auto [key, x] = heap.top();
+        heap.pop();
+        if (key >= -epsilon) {
+            break; // the rest of the graph keeps its potentials
+        }
+        if (settled[x]) {
+            continue;
+        }
+        settled[x] = true;
+
+        if (x == edge.from) {
+            // the path edge.to ~> edge.from plus this edge is a negative cycle, keep the old potentials
+            ActiveCycle active;
+            active.closingEdge = e;
+            double weight {};
+            std::size_t node = edge.from;
+            do {
+                const auto& pe = edges[predEdge.at(node)];
+                active.cycle.nodes.push_back(pe.from);
+                weight += pe.weight;
+                node = pe.from;
+            } while (node != edge.from);
+            std::reverse(active.cycle.nodes.begin(), active.cycle.nodes.end());
+            active.cycle.gain = std::exp(-weight) - 1;
+            update.found.push_back(active.cycle);
+            m_cycles.push_back(std::move(active));
+            return;
+        }
+
+        for (const std::size_t f : m_graph.outEdges(x)) {
+            if (f == e || isClosing(f)) {
+                continue;
+            }
+            const auto& next = edges[f];
+            const double reduced = std::max(0.0, m_potential[x] + next.weight - m_potential[next.to]);
+            const double candidate = key + reduced;
+            const auto itr = change.find(next.to);
+            if (candidate < -epsilon && (itr == change.end() || candidate < itr->second)) {
+                change[next.to] = candidate;
+                predEdge[next.to] = f;
+                heap.emplace(candidate, next.to);
+            }
+        }
+    }
+
+    // no cycle, lowering the potentials of the settled nodes makes every edge feasible again
+    for (const auto& [node, isSettled] : settled) {
+        if (isSettled) {
+            m_potential[node] += change.at(node);
+        }
+    }
+}
+
+std::vector<ArbitrageGraph::Cycle> ArbitrageMonitor::cycles() const
+{
+    std::vector<ArbitrageGraph::Cycle> result;
+    result.reserve(m_cycles.size());
+    for (const auto& item : m_cycles) {
+        result.push_back(item.cycle);
+    }
+    return result;
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#pragma once
+
+#include "ArbitrageGraph.hpp"
+
+#include <chrono>
+#include <istream>
+#include <vector>
+
+namespace portopt {
+
+// Keeps arbitrage cycles up to date while exchange rates stream in
+//
+// Node potentials p are kept feasible (p(from) + weight >= p(to)) for every edge except one "closing" edge per
+// reported cycle. A rate update only searches the neighborhood whose potentials would drop, using Dijkstra on
+// reduced costs from the updated edge, so a quiet update costs O(1) and a busy one touches only affected nodes.
+class ArbitrageMonitor {
+public:
+    struct Update {
+        std::vector<ArbitrageGraph::Cycle> found; // cycles that became profitable
+        std::vector<ArbitrageGraph::Cycle> vanished; // cycles that are no longer profitable
+        std::chrono::nanoseconds latency {}; // time spent processing the update
+    };
+
+    ArbitrageMonitor() = default;
+    explicit ArbitrageMonitor(const ArbitrageGraph& graph); // inserts every edge of an initial graph
+
+    Update setRate(const std::string& from, const std::string& to, double rate);
+    Update setRate(const CsvFile::RowType& row); // {from, to, rate}
+
+    [[nodiscard]] const ArbitrageGraph& graph() const noexcept { return m_graph; }
+    [[nodiscard]] std::vector<ArbitrageGraph::Cycle> cycles() const; // currently profitable cycles
+
+private:
+    struct ActiveCycle {
+        ArbitrageGraph::Cycle cycle;
+        std::size_t closingEdge {}; // edge excluded from the potentials while the cycle is profitable
+    };
+
+    void insertEdge(std::size_t e, Update& update); // restore feasibility of one edge or report the cycle it closes
+    [[nodiscard]] bool isClosing(std::size_t e) const;
+
+    ArbitrageGraph m_graph;
+    std::vector<double> m_potential; // node index -> potential
+    std::vector<ActiveCycle> m_cycles;
+};
+
+} // namespace portopt
@@ -82,9 +82,9 @@ Asset::Asset(std::string symbol, double price, AssetInfo info)
     assert(ohlc().size() == 1);
 }
 
-Asset::Asset(std::string symbol, const FilePath& dataDir, AssetInfo info)
+Asset::Asset(std::string symbol, const FilePath& dataDir, AssetInfo info, const DateRange& range)
     : m_symbol { std::move(symbol) }
-    , m_ohlc { OhlcList { CsvFile { dataDir / (m_symbol + ".csv"), true }, OhlcTimeFrame::Daily } }
+    , m_ohlc { OhlcList { CsvFile { dataDir / (m_symbol + ".csv"), true, Utils::to_string(range.minDate) }, OhlcTimeFrame::Daily, range } }
     , m_yahoo(loadJsonFile(dataDir / (m_symbol + ".json")))
     , m_info { std::move(info) }
     , m_tags { getAssetTags(*this) } // must be last to have all the necessary data
@@ -92,6 +92,14 @@ Asset::Asset(std::string symbol, const FilePath& dataDir, AssetInfo info)
     std::cerr << "Asset::Asset " << m_symbol << " ohlc.size: " << m_ohlc.size() << "\n";
 }
 
+Asset::Asset(std::string symbol, OhlcList ohlc, AssetInfo info)
+    : m_symbol { std::move(symbol) }
+    , m_ohlc { std::move(ohlc) }
+    , m_info { std::move(info) }
+    , m_tags { AssetClass::Unclassified }
+{
+}
+
 std::string Asset::tags() const
 {
     std::vector<std::string> result;
@@ -120,8 +128,7 @@ void Asset::save(const FilePath& dataDir) const
 
 double Asset::correlation(const Asset& other, const PriceType priceType, const bool rankify, size_t length, size_t offset) const
 {
-    (void)offset; // TODO: implement offset
-    if (m_symbol == other.m_symbol) {
+    if (m_symbol == other.m_symbol && offset == 0) {
         return 1; // correlation with itself is 1
     }
     if (m_ohlc.size() < 2) {
@@ -132,14 +139,18 @@ double Asset::correlation(const Asset& other, const PriceType priceType, const b
         // if price data is not available, use the correlation from the info
         return other.m_info.correlation.contains(m_symbol) ? other.m_info.correlation.at(m_symbol) : 0;
     }
-    const size_t size = std::min({ m_ohlc.size(), other.m_ohlc.size(), length });
+    if (other.m_ohlc.size() < offset + 2) {
+        return 0; // not enough history before the offset
+    }
+    // the other window starts offset entries into its past, both histories are aligned on their most recent entry
+    const size_t size = std::min({ m_ohlc.size(), other.m_ohlc.size() - offset, length });
     if (!m_ohlc.matchTimePoint(other.m_ohlc, size)) {
         std::cerr << "Asset::correlation [timepoint mismatch] " << m_symbol << " " << other.m_symbol << "\n";
         assert(false);
         return 0;
     }
     const auto vector1 = m_ohlc.toVector(size, 0, priceType);
-    const auto vector2 = other.m_ohlc.toVector(size, 0, priceType);
+    const auto vector2 = other.m_ohlc.toVector(size, offset, priceType);
     return rankify ? Utils::spearmanCorrelation(vector1, vector2) : Utils::pearsonCorrelation(vector1, vector2);
 }
 
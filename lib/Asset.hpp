@@ -35,8 +35,17 @@ public:
      * @param symbol Ticker symbol
      * @param dataDir directory path for SYM.csv and SYM.json files
      * @param info extra asset attributes
+     * @param range dates of the price history to load
      */
-    Asset(std::string symbol, const FilePath& dataDir, AssetInfo info);
+    Asset(std::string symbol, const FilePath& dataDir, AssetInfo info, const DateRange& range = OhlcList::defaultRange());
+
+    /**
+     * @brief Construct an asset from already loaded price history
+     * @param symbol Ticker symbol
+     * @param ohlc price history (first element is the most recent)
+     * @param info extra asset attributes
+     */
+    Asset(std::string symbol, OhlcList ohlc, AssetInfo info);
 
     const std::string& symbol() const noexcept { return m_symbol; }
     const OhlcList& ohlc() const noexcept { return m_ohlc; }
@@ -46,6 +55,7 @@ public:
     std::string yahoo(const std::string& key) const; ///< Returns value from yahoo json
     void save(const FilePath& dataDir) const; ///< save ohlc data to a symbol.csv file
 
+    /// correlation of the last length prices with the other asset's prices offset entries earlier (other leading by offset)
     double correlation(const Asset& other, PriceType priceType, bool rankify, size_t length, size_t offset = 0) const;
     double avgRisk(size_t length) const;
     double avgReturn(size_t length) const;
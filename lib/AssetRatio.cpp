@@ -6,11 +6,114 @@
  */
 
 #include "AssetRatio.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <optional>
 
 using namespace portopt;
 
+struct AssetRatio::Spread {
+    HedgeRatio hedgeRatio;
+    std::vector<double> values; // most recent first
+};
+
+struct AssetRatio::Cache {
+    std::once_flag ratioFlag;
+    std::optional<OhlcList> ratio;
+
+    std::mutex mutex;
+    std::map<std::pair<size_t, PriceType>, Spread> spreads;
+};
+
 AssetRatio::AssetRatio(const Asset& asset1, const Asset& asset2)
     : m_asset1 { asset1 }
     , m_asset2 { asset2 }
+    , m_cache { std::make_shared<Cache>() }
+{
+    const size_t size = std::min(asset1.ohlc().size(), asset2.ohlc().size());
+    m_size = asset1.ohlc().matchTimePoint(asset2.ohlc(), size) ? size : 0;
+}
+
+size_t AssetRatio::size() const noexcept
+{
+    return m_size;
+}
+
+const Ohlc& AssetRatio::at(size_t i) const
+{
+    assert(i < m_size);
+    return ohlc().at(i);
+}
+
+const OhlcList& AssetRatio::ohlc() const
+{
+    std::call_once(m_cache->ratioFlag, [this] {
+        OhlcVector data;
+        data.reserve(m_size);
+        for (size_t i = 0; i < m_size; ++i) {
+            const auto& a = m_asset1.ohlc().at(i);
+            const auto& b = m_asset2.ohlc().at(i);
+            const double open = a.open / b.open;
+            const double close = a.close / b.close;
+            Ohlc item { open, std::max({ a.high / b.high, open, close }), std::min({ a.low / b.low, open, close }), close };
+            item.timepoint = a.timepoint;
+            item.valid = a.valid && b.valid;
+            item.dummy = a.dummy || b.dummy;
+            data.push_back(item);
+        }
+        m_cache->ratio.emplace(std::move(data));
+    });
+    return *m_cache->ratio;
+}
+
+const AssetRatio::Spread& AssetRatio::spreadCache(size_t length, PriceType priceType) const
+{
+    length = std::min(length, m_size);
+    const std::lock_guard<std::mutex> lock { m_cache->mutex };
+    const auto [itr, inserted] = m_cache->spreads.try_emplace({ length, priceType });
+    auto& spread = itr->second;
+    if (inserted && length > 1) {
+        std::vector<double> x(length);
+        std::vector<double> y(length);
+        for (size_t i = 0; i < length; ++i) {
+            y[i] = std::log(m_asset1.ohlc().at(i).get(priceType));
+            x[i] = std::log(m_asset2.ohlc().at(i).get(priceType));
+        }
+        const auto [slope, intercept] = Utils::linearRegression(x, y);
+        spread.hedgeRatio = { intercept, slope };
+        spread.values.resize(length);
+        for (size_t i = 0; i < length; ++i) {
+            spread.values[i] = y[i] - intercept - (slope * x[i]);
+        }
+    }
+    return spread;
+}
+
+AssetRatio::HedgeRatio AssetRatio::hedgeRatio(size_t length, PriceType priceType) const
+{
+    return spreadCache(length, priceType).hedgeRatio;
+}
+
+const std::vector<double>& AssetRatio::spread(size_t length, PriceType priceType) const
+{
+    return spreadCache(length, priceType).values;
+}
+
+CointegrationTest AssetRatio::cointegration(size_t length, PriceType priceType, size_t adfLags) const
 {
+    const auto& spread = spreadCache(length, priceType);
+    const std::vector<double> chronological(spread.values.rbegin(), spread.values.rend());
+    CointegrationTest result;
+    result.alpha = spread.hedgeRatio.alpha;
+    result.beta = spread.hedgeRatio.beta;
+    result.size = chronological.size();
+    result.adfStatistic = Cointegration::adfStatistic(chronological, adfLags);
+    result.criticalValue = Cointegration::criticalValue(result.size);
+    result.halfLife = Cointegration::halfLife(chronological);
+    return result;
 }
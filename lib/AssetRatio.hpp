@@ -8,18 +8,43 @@
 #pragma once
 
 #include "Asset.hpp"
+#include "Cointegration.hpp"
+
+#include <memory>
 
 namespace portopt {
 
+// Price ratio and hedge-ratio spread of two assets over their aligned history (most recent first)
+//
+// Columns are computed on first use and cached, the cache is shared between copies. Both assets must outlive the
+// ratio.
 class AssetRatio {
 public:
     AssetRatio(const Asset& asset1, const Asset& asset2);
-    [[nodiscard]] size_t size() const noexcept;
-    [[nodiscard]] const Ohlc& at(size_t i) const;
+    [[nodiscard]] size_t size() const noexcept; // entries of both histories with matching dates
+    [[nodiscard]] const Ohlc& at(size_t i) const; // asset1 / asset2
+    [[nodiscard]] const OhlcList& ohlc() const; // ratio as a price history, for the OhlcList analytics
+
+    // log price1 = alpha + beta * log price2 + spread over the last length entries (at most size())
+    struct HedgeRatio {
+        double alpha {};
+        double beta {};
+    };
+    [[nodiscard]] HedgeRatio hedgeRatio(size_t length, PriceType priceType) const;
+    [[nodiscard]] const std::vector<double>& spread(size_t length, PriceType priceType) const; // most recent first
+
+    // Engle-Granger test of the spread, asset1 is the dependent variable
+    [[nodiscard]] CointegrationTest cointegration(size_t length, PriceType priceType, size_t adfLags = 1) const;
 
 private:
+    struct Cache;
+    struct Spread;
+    [[nodiscard]] const Spread& spreadCache(size_t length, PriceType priceType) const;
+
     const Asset& m_asset1;
     const Asset& m_asset2;
+    size_t m_size {};
+    const std::shared_ptr<Cache> m_cache;
 };
 
 } // namespace portopt
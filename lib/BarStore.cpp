@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "BarStore.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <system_error>
+
+using namespace portopt;
+
+namespace {
+
+// "YYYY-MM" of a timepoint in UTC, so the chunks don't depend on the time zone of the machine
+std::string monthOf(const TimePoint& tp)
+{
+    const std::chrono::year_month_day date { std::chrono::floor<std::chrono::days>(tp) };
+    const auto year = static_cast<int>(date.year());
+    const auto month = static_cast<unsigned>(date.month());
+    return std::to_string(year) + (month < 10 ? "-0" : "-") + std::to_string(month);
+}
+
+std::uint64_t toSeconds(const TimePoint& tp)
+{
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::seconds>(tp.time_since_epoch()).count());
+}
+
+TimePoint fromSeconds(std::uint64_t seconds)
+{
+    return TimePoint { std::chrono::seconds { static_cast<std::int64_t>(seconds) } };
+}
+
+} // anonymous namespace
+
+BarStore::BarStore(FilePath root)
+    : m_root { std::move(root) }
+{
+}
+
+std::vector<std::string> BarStore::symbols() const
+{
+    std::vector<std::string> result;
+    if (!std::filesystem::exists(m_root)) {
+        return result;
+    }
+    for (const auto& entry : std::filesystem::directory_iterator(m_root)) {
+        if (entry.is_directory()) {
+            result.push_back(entry.path().filename().string());
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+std::vector<std::string> BarStore::months(const std::string& symbol) const
+{
+    std::vector<std::string> result;
+    const FilePath dir = m_root / symbol;
+    if (!std::filesystem::exists(dir)) {
+        return result;
+    }
+    for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".bin") {
+            result.push_back(entry.path().stem().string());
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+bool BarStore::save(const std::string& symbol, const OhlcList& bars) const
+{
+    struct Bar {
+        double open, high, low, close, volume;
+    };
+    using Bars = std::map<std::uint64_t, Bar>; // by time
+    std::map<std::string, Bars> chunks;
+    for (size_t i = 0; i < bars.size(); ++i) {
+        const Ohlc& bar = bars.at(i);
+        if (bar.dummy || !bar.valid) {
+            continue;
+        }
+        chunks[monthOf(bar.timepoint)].try_emplace(toSeconds(bar.timepoint), Bar { bar.open, bar.high, bar.low, bar.close, bar.volume });
+    }
+
+    const FilePath dir = m_root / symbol;
+    std::filesystem::create_directories(dir);
+    for (auto& [month, chunk] : chunks) {
+        const FilePath filePath = dir / (month + ".bin");
+        if (std::filesystem::exists(filePath)) {
+            // the stored bars of the month are kept unless a new bar has the same time
+            const ColumnFile file { filePath };
+            const auto time = file.uint64("time");
+            const auto open = file.float64("open");
+            const auto high = file.float64("high");
+            const auto low = file.float64("low");
+            const auto close = file.float64("close");
+            const auto volume = file.float64("volume");
+            const size_t size = time.size();
+            if (!file.isOpen() || open.size() != size || high.size() != size || low.size() != size || close.size() != size || volume.size() != size) {
+                std::cerr << "BarStore::save [unreadable chunk] " << symbol << " " << month << "\n";
+                return false;
+            }
+            for (size_t i = 0; i < size; ++i) {
+                chunk.try_emplace(time[i], Bar { open[i], high[i], low[i], close[i], volume[i] });
+            }
+        } // the mapping is released before the file is rewritten
+
+        ColumnFileWriter writer;
+        std::vector<std::uint64_t> time;
+        std::vector<double> open, high, low, close, volume;
+        for (const auto& [seconds, bar] : chunk) { // oldest first
+            time.push_back(seconds);
+            open.push_back(bar.open);
+            high.push_back(bar.high);
+            low.push_back(bar.low);
+            close.push_back(bar.close);
+            volume.push_back(bar.volume);
+        }
+        writer.add("time", time);
+        writer.add("open", open);
+        writer.add("high", high);
+        writer.add("low", low);
+        writer.add("close", close);
+        writer.add("volume", volume);
+        // a crash or a reader mapping the chunk meanwhile sees either the old or the new file, never a torn one
+        const FilePath tempPath { filePath.string() + ".tmp" };
+        std::error_code error;
+        if (writer.save(tempPath)) {
+            std::filesystem::rename(tempPath, filePath, error);
+        } else {
+            error = std::make_error_code(std::errc::io_error);
+        }
+        if (error) {
+            std::cerr << "BarStore::save [failed] " << symbol << " " << month << " " << error.message() << "\n";
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+    }
+    return true;
+}
+
+void BarStore::forEachChunk(const std::string& symbol, const DateRange& range, const std::function<void(const Chunk&)>& func) const
+{
+    const std::string minMonth = monthOf(range.minDate);
+    const std::string maxMonth = monthOf(range.maxDate);
+    for (const auto& month : months(symbol)) {
+        if (month < minMonth || month > maxMonth) {
+            continue;
+        }
+        Chunk chunk { month, ColumnFile { m_root / symbol / (month + ".bin") }, {}, {}, {}, {}, {}, {} };
+        if (!chunk.file.isOpen()) {
+            std::cerr << "BarStore::forEachChunk [failed to open] " << symbol << " " << month << "\n";
+            continue;
+        }
+        chunk.time = chunk.file.uint64("time");
+        chunk.open = chunk.file.float64("open");
+        chunk.high = chunk.file.float64("high");
+        chunk.low = chunk.file.float64("low");
+        chunk.close = chunk.file.float64("close");
+        chunk.volume = chunk.file.float64("volume");
+        const size_t size = chunk.time.size();
+        if (chunk.open.size() != size || chunk.high.size() != size || chunk.low.size() != size || chunk.close.size() != size
+            || chunk.volume.size() != size) {
+            std::cerr << "BarStore::forEachChunk [column size mismatch] " << symbol << " " << month << "\n";
+            continue;
+        }
+        func(chunk);
+    }
+}
+
+OhlcList BarStore::load(const std::string& symbol, const DateRange& range, OhlcTimeFrame timeFrame) const
+{
+    const std::uint64_t minTime = toSeconds(range.minDate);
+    const std::uint64_t maxTime = toSeconds(range.maxDate);
+
+    OhlcVector result;
+    forEachChunk(symbol, range, [&](const Chunk& chunk) {
+        // the chunk is sorted by time, only the first and the last month of the range are cut
+        const auto begin = std::lower_bound(chunk.time.begin(), chunk.time.end(), minTime);
+        const auto end = std::upper_bound(begin, chunk.time.end(), maxTime);
+        result.reserve(result.size() + static_cast<size_t>(end - begin));
+        for (auto itr = begin; itr != end; ++itr) {
+            const auto i = static_cast<size_t>(itr - chunk.time.begin());
+            Ohlc bar { chunk.open[i], chunk.high[i], chunk.low[i], chunk.close[i], chunk.volume[i] };
+            bar.timepoint = fromSeconds(*itr);
+            bar.valid = true;
+            result.push_back(bar);
+        }
+    });
+    std::reverse(result.begin(), result.end()); // most recent first
+    return OhlcList { std::move(result), timeFrame };
+}
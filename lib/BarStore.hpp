@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#pragma once
+
+#include "ColumnFile.hpp"
+#include "OhlcList.hpp"
+
+#include <functional>
+
+namespace portopt {
+
+/*
+ * Intraday bars stored as one ColumnFile per symbol and UTC month, root/SYMBOL/YYYY-MM.bin, oldest bar first:
+ *   "time"                                 uint64 seconds since the epoch
+ *   "open", "high", "low", "close", "volume" float64
+ *
+ * A month of minute bars is about 8k rows, so a range only maps the chunks it overlaps and the columns are read
+ * straight from the mapping instead of loading the whole history of a symbol.
+ */
+class BarStore {
+public:
+    struct Chunk {
+        std::string month; // "YYYY-MM"
+        ColumnFile file; // keeps the mapping of the spans alive
+        std::span<const std::uint64_t> time;
+        std::span<const double> open;
+        std::span<const double> high;
+        std::span<const double> low;
+        std::span<const double> close;
+        std::span<const double> volume;
+    };
+
+    explicit BarStore(FilePath root);
+
+    [[nodiscard]] const FilePath& root() const noexcept { return m_root; }
+    [[nodiscard]] std::vector<std::string> symbols() const; // sorted
+    [[nodiscard]] std::vector<std::string> months(const std::string& symbol) const; // sorted "YYYY-MM" of the chunks
+
+    // Merges the bars into the chunks of their months, a new bar replaces a stored one with the same time
+    [[nodiscard]] bool save(const std::string& symbol, const OhlcList& bars) const;
+
+    // Chunks overlapping the range from the oldest to the most recent, the spans hold the whole month
+    void forEachChunk(const std::string& symbol, const DateRange& range, const std::function<void(const Chunk&)>& func) const;
+
+    // Bars within the range (both ends included), most recent first like the daily lists
+    [[nodiscard]] OhlcList load(const std::string& symbol, const DateRange& range, OhlcTimeFrame timeFrame = OhlcTimeFrame::Minute) const;
+
+private:
+    FilePath m_root;
+};
+
+} // namespace portopt
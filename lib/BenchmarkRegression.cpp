@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "BenchmarkRegression.hpp"
+#include "OhlcList.hpp"
+#include "ReportWriter.hpp"
+#include "ReturnMatrix.hpp"
+#include "RollingStats.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+
+using namespace portopt;
+
+namespace {
+
+// Population moments from the sums of x, x^2, y, y^2 and x * y over n periods, x regressed on y
+BenchmarkFit fitSums(std::size_t n, double sumX, double sumXX, double sumY, double sumYY, double sumXY)
+{
+    BenchmarkFit result;
+    result.size = n;
+    if (n == 0) {
+        return result;
+    }
+    const auto size = static_cast<double>(n);
+    const double meanX = sumX / size;
+    const double meanY = sumY / size;
+    const double varianceX = std::max(0.0, (sumXX / size) - (meanX * meanX));
+    const double varianceY = std::max(0.0, (sumYY / size) - (meanY * meanY));
+    const double covariance = (sumXY / size) - (meanX * meanY);
+    result.beta = varianceY > 0 ? covariance / varianceY : 0;
+    result.alpha = meanX - (result.beta * meanY);
+    result.rSquared = varianceX > 0 && varianceY > 0 ? covariance * covariance / (varianceX * varianceY) : 0;
+    result.trackingError = std::sqrt(std::max(0.0, varianceX + varianceY - (2 * covariance)));
+    return result;
+}
+
+BenchmarkFit fitWindow(const RollingWindow& rw)
+{
+    BenchmarkFit result;
+    result.size = rw.count();
+    result.beta = rw.beta();
+    result.alpha = rw.meanX() - (result.beta * rw.meanY());
+    const double correlation = rw.correlation();
+    result.rSquared = correlation * correlation;
+    result.trackingError = std::sqrt(std::max(0.0, rw.varianceX() + rw.varianceY() - (2 * rw.covariance())));
+    return result;
+}
+
+} // anonymous namespace
+
+BenchmarkRegression::BenchmarkRegression(const ReturnMatrix& returns, const std::vector<std::string>& benchmarks, std::size_t length)
+    : m_returns { returns }
+    , m_length { std::min(length, returns.tradingPeriods().size()) }
+    , m_periodsPerYear { static_cast<double>(OhlcList::tradingBarsPerYear(returns.timeFrame())) / static_cast<double>(returns.horizon()) }
+{
+    for (const auto& symbol : benchmarks) {
+        const std::size_t column = returns.index(symbol);
+        if (column == ReturnMatrix::npos) {
+            std::cerr << "BenchmarkRegression::BenchmarkRegression [missing benchmark] " << symbol << "\n";
+            continue;
+        }
+        m_benchmarks.push_back(symbol);
+        m_benchmarkSeries.push_back(returns.tradingSeries(column));
+    }
+
+    const std::size_t numBenchmarks = m_benchmarks.size();
+    std::vector<double> sumB(numBenchmarks);
+    std::vector<double> sumBB(numBenchmarks);
+    for (std::size_t k = 0; k < numBenchmarks; ++k) {
+        const double* b = m_benchmarkSeries[k].data();
+        for (std::size_t t = 0; t < m_length; ++t) {
+            sumB[k] += b[t];
+            sumBB[k] += b[t] * b[t];
+        }
+    }
+
+    m_fits.resize(returns.numAssets() * numBenchmarks);
+    Utils::parallelFor(returns.numAssets(), [&](std::size_t begin, std::size_t end) {
+        std::vector<double> sumRB(numBenchmarks);
+        for (std::size_t a = begin; a < end; ++a) {
+            const std::vector<double> r = returns.tradingSeries(a);
+            double sumR {};
+            double sumRR {};
+            std::fill(sumRB.begin(), sumRB.end(), 0.0);
+            for (std::size_t t = 0; t < m_length; ++t) {
+                const double x = r[t];
+                sumR += x;
+                sumRR += x * x;
+                for (std::size_t k = 0; k < numBenchmarks; ++k) {
+                    sumRB[k] += x * m_benchmarkSeries[k][t];
+                }
+            }
+            for (std::size_t k = 0; k < numBenchmarks; ++k) {
+                m_fits[(a * numBenchmarks) + k] = fitSums(m_length, sumR, sumRR, sumB[k], sumBB[k], sumRB[k]);
+            }
+        }
+    });
+}
+
+const BenchmarkFit& BenchmarkRegression::fit(std::size_t asset, std::size_t benchmark) const
+{
+    assert(asset < m_returns.numAssets() && benchmark < m_benchmarks.size());
+    return m_fits.at((asset * m_benchmarks.size()) + benchmark);
+}
+
+std::vector<BenchmarkFit> BenchmarkRegression::rolling(std::size_t asset, std::size_t benchmark, std::size_t window) const
+{
+    assert(asset < m_returns.numAssets() && benchmark < m_benchmarks.size());
+    const std::vector<double> x = m_returns.tradingSeries(asset);
+    return RollingStats::slide(x.data(), m_benchmarkSeries[benchmark].data(), m_length, window, fitWindow);
+}
+
+void BenchmarkRegression::save(const FilePath& filePath) const
+{
+    ReportWriter writer { filePath };
+    if (!writer.isOpen()) {
+        return;
+    }
+
+    writer << "symbol";
+    for (const auto& benchmark : m_benchmarks) {
+        writer << ",alpha-" << benchmark << ",beta-" << benchmark << ",r2-" << benchmark << ",te-" << benchmark;
+    }
+    writer << '\n';
+
+    const double sqrtPeriods = std::sqrt(m_periodsPerYear);
+    writer.writeRows(m_returns.numAssets(), [&](ReportBuffer& row, std::size_t a) {
+        row.append(m_returns.symbols()[a]);
+        for (std::size_t k = 0; k < m_benchmarks.size(); ++k) {
+            const auto& item = fit(a, k);
+            for (const double value : { item.alpha * m_periodsPerYear, item.beta, item.rSquared, item.trackingError * sqrtPeriods }) {
+                row.append(',');
+                row.append(value);
+            }
+        }
+        row.append('\n');
+    });
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#pragma once
+
+#include "FilePath.hpp"
+
+#include <string>
+#include <vector>
+
+namespace portopt {
+
+class ReturnMatrix;
+
+// Ordinary least squares of the returns of an asset on the returns of a benchmark, per period of the returns
+struct BenchmarkFit {
+    double alpha {}; // intercept, mean return not explained by the benchmark
+    double beta {}; // slope
+    double rSquared {}; // share of the variance explained by the benchmark
+    double trackingError {}; // standard deviation of the return minus the benchmark return
+    std::size_t size {}; // periods used
+};
+
+// Regression of every asset of a ReturnMatrix against a few benchmark columns of the same matrix, over its trading
+// periods (see ReturnMatrix::tradingSeries) so the forward filled days don't dilute the moments. One parallel pass
+// over the assets accumulates the sums of each asset and its cross products with every benchmark, the sums
+// of the benchmarks are shared by all assets.
+class BenchmarkRegression {
+public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    /**
+     * @brief BenchmarkRegression Constructor
+     * @param returns aligned returns of the assets and the benchmarks, kept by reference
+     * @param benchmarks symbols of the benchmarks, those missing from the matrix are skipped
+     * @param length most recent trading periods used, all of them by default
+     */
+    BenchmarkRegression(const ReturnMatrix& returns, const std::vector<std::string>& benchmarks, std::size_t length = npos);
+
+    [[nodiscard]] const std::vector<std::string>& benchmarks() const noexcept { return m_benchmarks; }
+    [[nodiscard]] std::size_t length() const noexcept { return m_length; }
+    [[nodiscard]] double periodsPerYear() const noexcept { return m_periodsPerYear; } // to annualize alpha and tracking error
+
+    // asset is a column of the return matrix, benchmark an index into benchmarks()
+    [[nodiscard]] const BenchmarkFit& fit(std::size_t asset, std::size_t benchmark) const;
+
+    // result[i] is the fit over the trading periods [i, i + window), updated in O(1) per period
+    [[nodiscard]] std::vector<BenchmarkFit> rolling(std::size_t asset, std::size_t benchmark, std::size_t window) const;
+
+    // CSV with the annualized alpha, beta, R^2 and annualized tracking error against every benchmark
+    void save(const FilePath& filePath) const;
+
+private:
+    const ReturnMatrix& m_returns;
+    std::vector<std::string> m_benchmarks;
+    std::vector<std::vector<double>> m_benchmarkSeries; // trading series of each benchmark
+    std::size_t m_length {};
+    double m_periodsPerYear {};
+    std::vector<BenchmarkFit> m_fits; // assets x benchmarks
+};
+
+} // namespace portopt
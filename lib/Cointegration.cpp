@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "Cointegration.hpp"
+
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <numbers>
+#include <vector>
+
+using namespace portopt;
+
+namespace {
+
+// Solves the k x k system a * x = b by Gaussian elimination with partial pivoting, empty if a is singular
+std::vector<double> solve(std::vector<double> a, std::vector<double> b)
+{
+    const std::size_t k = b.size();
+    assert(a.size() == k * k);
+    for (std::size_t col = 0; col < k; ++col) {
+        std::size_t pivot = col;
+        for (std::size_t row = col + 1; row < k; ++row) {
+            if (std::abs(a[(row * k) + col]) > std::abs(a[(pivot * k) + col])) {
+                pivot = row;
+            }
+        }
+        if (std::abs(a[(pivot * k) + col]) < 1e-300) {
+            return {};
+        }
+        for (std::size_t c = 0; c < k; ++c) {
+            std::swap(a[(col * k) + c], a[(pivot * k) + c]);
+        }
+        std::swap(b[col], b[pivot]);
+        for (std::size_t row = col + 1; row < k; ++row) {
+            const double factor = a[(row * k) + col] / a[(col * k) + col];
+            for (std::size_t c = col; c < k; ++c) {
+                a[(row * k) + c] -= factor * a[(col * k) + c];
+            }
+            b[row] -= factor * b[col];
+        }
+    }
+    std::vector<double> x(k);
+    for (std::size_t row = k; row-- > 0;) {
+        double sum = b[row];
+        for (std::size_t c = row + 1; c < k; ++c) {
+            sum -= a[(row * k) + c] * x[c];
+        }
+        x[row] = sum / a[(row * k) + row];
+    }
+    return x;
+}
+
+} // anonymous namespace
+
+double Cointegration::adfStatistic(std::span<const double> series, std::size_t lags)
+{
+    // regressors: constant, y(t-1), dy(t-1) ... dy(t-lags)
+    const std::size_t k = lags + 2;
+    if (series.size() < lags + k + 2) {
+        return 0;
+    }
+    std::vector<double> xtx(k * k);
+    std::vector<double> xty(k);
+    std::vector<double> row(k);
+    double yty {};
+    std::size_t n {};
+    for (std::size_t t = lags + 1; t < series.size(); ++t) {
+        const double dy = series[t] - series[t - 1];
+        row[0] = 1;
+        row[1] = series[t - 1];
+        for (std::size_t i = 1; i <= lags; ++i) {
+            row[i + 1] = series[t - i] - series[t - i - 1];
+        }
+        for (std::size_t r = 0; r < k; ++r) {
+            for (std::size_t c = 0; c < k; ++c) {
+                xtx[(r * k) + c] += row[r] * row[c];
+            }
+            xty[r] += row[r] * dy;
+        }
+        yty += dy * dy;
+        n++;
+    }
+
+    const auto coefficients = solve(xtx, xty);
+    std::vector<double> unit(k);
+    unit[1] = 1;
+    const auto inverse = solve(xtx, unit); // column of (X'X)^-1 for gamma
+    if (coefficients.empty() || inverse.empty()) {
+        return 0;
+    }
+    // residual sum of squares = y'y - b'X'y for the least squares b
+    double rss = yty;
+    for (std::size_t r = 0; r < k; ++r) {
+        rss -= coefficients[r] * xty[r];
+    }
+    const double variance = std::max(rss, 0.0) / static_cast<double>(n - k);
+    const double stdError = std::sqrt(variance * inverse[1]);
+    return stdError > 0 ? coefficients[1] / stdError : 0;
+}
+
+double Cointegration::criticalValue(std::size_t size)
+{
+    const double t = static_cast<double>(size);
+    return -3.33613 - (6.1101 / t) - (6.823 / (t * t));
+}
+
+double Cointegration::halfLife(std::span<const double> spread)
+{
+    if (spread.size() < 3) {
+        return std::numeric_limits<double>::infinity();
+    }
+    // slope of ds(t) on s(t-1)
+    const auto n = static_cast<double>(spread.size() - 1);
+    double sx {};
+    double sy {};
+    double sxx {};
+    double sxy {};
+    for (std::size_t t = 1; t < spread.size(); ++t) {
+        const double x = spread[t - 1];
+        const double y = spread[t] - spread[t - 1];
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        sxy += x * y;
+    }
+    const double denominator = (n * sxx) - (sx * sx);
+    const double lambda = denominator > 0 ? ((n * sxy) - (sx * sy)) / denominator : 0;
+    if (lambda >= 0 || lambda <= -1) {
+        return lambda <= -1 ? 0 : std::numeric_limits<double>::infinity(); // no reversion, or within one period
+    }
+    return -std::numbers::ln2 / std::log1p(lambda);
+}
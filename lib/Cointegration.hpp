@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <span>
+
+namespace portopt {
+
+// Engle-Granger test of two log price series: log price1 = alpha + beta * log price2 + spread
+struct CointegrationTest {
+    double alpha {};
+    double beta {}; // hedge ratio
+    double adfStatistic {}; // augmented Dickey-Fuller t statistic of the spread
+    double criticalValue {}; // 5% Engle-Granger critical value for the sample size
+    double halfLife {}; // periods for a deviation of the spread to halve, infinity if it doesn't revert
+    std::size_t size {}; // prices used
+
+    [[nodiscard]] bool cointegrated() const noexcept { return adfStatistic < criticalValue; }
+};
+
+namespace Cointegration {
+
+    // Series are in chronological order (oldest first), unlike OhlcList
+
+    // t statistic of gamma in dy(t) = a + gamma * y(t-1) + sum of phi(i) * dy(t-i) for i in [1, lags]
+    double adfStatistic(std::span<const double> series, std::size_t lags);
+
+    // MacKinnon (2010) response surface for two variables with a constant, 5% level
+    double criticalValue(std::size_t size);
+
+    // From the AR(1) fit ds(t) = a + lambda * s(t-1): -ln(2) / ln(1 + lambda)
+    double halfLife(std::span<const double> spread);
+
+} // namespace Cointegration
+} // namespace portopt
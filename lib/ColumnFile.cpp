@@ -0,0 +1,378 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "ColumnFile.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <bit>
+#include <cassert>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <numeric>
+
+using namespace portopt;
+
+static_assert(std::endian::native == std::endian::little, "ColumnFile stores little-endian values");
+
+namespace {
+
+constexpr std::string_view magic { "PORTOPT1" };
+constexpr std::size_t alignment = 64;
+constexpr std::size_t headerSize = 16; // magic and schema size
+
+std::size_t align(std::size_t offset)
+{
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+// Appends bytes at the next aligned offset and returns that offset
+std::size_t appendAligned(std::vector<char>& buffer, const void* data, std::size_t size)
+{
+    const std::size_t offset = align(buffer.size());
+    buffer.resize(offset + size);
+    if (size > 0) {
+        std::memcpy(buffer.data() + offset, data, size);
+    }
+    return offset;
+}
+
+ColumnFile::Type parseType(const std::string& str)
+{
+    for (const auto type : { ColumnFile::Type::Float64, ColumnFile::Type::Float32, ColumnFile::Type::UInt64, ColumnFile::Type::Bitmap, ColumnFile::Type::String }) {
+        if (str == ColumnFile::to_string(type)) {
+            return type;
+        }
+    }
+    throw std::runtime_error("unknown column type " + str);
+}
+
+// The byte range of a column lies in the file and holds exactly count() values of its type
+bool validColumn(const ColumnFile::Column& column, std::string_view view)
+{
+    const auto inFile = [&view](std::size_t offset, std::size_t size) { return offset <= view.size() && size <= view.size() - offset; };
+    if (!inFile(column.offset, column.size) || !inFile(column.dataOffset, column.dataSize)) {
+        return false;
+    }
+    const std::size_t count = column.count();
+    if (count > view.size() * 8) {
+        return false; // more values than bits, the size below would overflow
+    }
+    switch (column.type) {
+    case ColumnFile::Type::Float64:
+    case ColumnFile::Type::Float32:
+    case ColumnFile::Type::UInt64: {
+        const std::size_t valueSize = ColumnFile::valueSize(column.type);
+        return column.size == count * valueSize && column.offset % valueSize == 0;
+    }
+    case ColumnFile::Type::Bitmap:
+        return column.size == (count + 7) / 8;
+    case ColumnFile::Type::String: {
+        if (column.size != (count + 1) * sizeof(std::uint64_t) || column.offset % sizeof(std::uint64_t) != 0) {
+            return false;
+        }
+        // offsets must be increasing and end inside the characters
+        std::uint64_t previous {};
+        for (std::size_t i = 0; i <= count; ++i) {
+            std::uint64_t offset {};
+            std::memcpy(&offset, view.data() + column.offset + (i * sizeof(offset)), sizeof(offset));
+            if (offset < previous || offset > column.dataSize) {
+                return false;
+            }
+            previous = offset;
+        }
+        return true;
+    }
+    }
+    return false;
+}
+
+std::string schema(const std::vector<ColumnFile::Column>& columns, std::size_t base)
+{
+    nlohmann::json json;
+    json["format"] = "portopt-columns";
+    json["version"] = 1;
+    json["columns"] = nlohmann::json::array();
+    for (const auto& column : columns) {
+        nlohmann::json item {
+            { "name", column.name },
+            { "type", ColumnFile::to_string(column.type) },
+            { "shape", column.shape },
+            { "offset", base + column.offset },
+            { "size", column.size },
+        };
+        if (column.type == ColumnFile::Type::String) {
+            item["dataOffset"] = base + column.dataOffset;
+            item["dataSize"] = column.dataSize;
+        }
+        json["columns"].push_back(item);
+    }
+    return json.dump();
+}
+
+} // anonymous namespace
+
+std::size_t ColumnFile::Column::count() const
+{
+    return std::accumulate(shape.begin(), shape.end(), std::size_t { 1 }, std::multiplies<>());
+}
+
+std::size_t ColumnFile::valueSize(Type type)
+{
+    switch (type) {
+    case Type::Float64:
+    case Type::UInt64:
+        return 8;
+    case Type::Float32:
+        return 4;
+    case Type::Bitmap:
+    case Type::String:
+        break;
+    }
+    assert(false && "not a numeric type");
+    return 0;
+}
+
+const char* ColumnFile::to_string(Type type)
+{
+    switch (type) {
+    case Type::Float64:
+        return "float64";
+    case Type::Float32:
+        return "float32";
+    case Type::UInt64:
+        return "uint64";
+    case Type::Bitmap:
+        return "bitmap";
+    case Type::String:
+        return "string";
+    }
+    return "unknown";
+}
+
+ColumnFile::ColumnFile(const FilePath& path)
+    : m_file { std::make_shared<const MappedFile>(path) }
+{
+    if (!m_file->isOpen()) {
+        return;
+    }
+    const auto view = m_file->view();
+    if (view.size() < headerSize || view.substr(0, magic.size()) != magic) {
+        std::cerr << "ColumnFile::ColumnFile [not a column file] " << path << "\n";
+        return;
+    }
+    std::uint64_t schemaSize {};
+    std::memcpy(&schemaSize, view.data() + magic.size(), sizeof(schemaSize));
+    if (headerSize + schemaSize > view.size()) {
+        std::cerr << "ColumnFile::ColumnFile [truncated schema] " << path << "\n";
+        return;
+    }
+
+    try {
+        const auto json = nlohmann::json::parse(view.substr(headerSize, schemaSize));
+        for (const auto& item : json.at("columns")) {
+            Column column;
+            column.name = item.at("name").get<std::string>();
+            column.type = parseType(item.at("type").get<std::string>());
+            column.shape = item.at("shape").get<std::vector<std::size_t>>();
+            column.offset = item.at("offset").get<std::size_t>();
+            column.size = item.at("size").get<std::size_t>();
+            if (column.type == Type::String) {
+                column.dataOffset = item.at("dataOffset").get<std::size_t>();
+                column.dataSize = item.at("dataSize").get<std::size_t>();
+            }
+            if (!validColumn(column, view)) {
+                std::cerr << "ColumnFile::ColumnFile [invalid column] " << column.name << "\n";
+                m_columns.clear();
+                return;
+            }
+            m_columns.push_back(std::move(column));
+        }
+    } catch (std::exception& e) {
+        std::cerr << "ColumnFile::ColumnFile [exception] " << path << " " << e.what() << "\n";
+        m_columns.clear();
+        return;
+    }
+    m_open = true;
+}
+
+const ColumnFile::Column* ColumnFile::find(const std::string& name) const
+{
+    for (const auto& column : m_columns) {
+        if (column.name == name) {
+            return &column;
+        }
+    }
+    return nullptr;
+}
+
+const char* ColumnFile::columnData(const std::string& name, Type type) const
+{
+    const auto* column = find(name);
+    if (column == nullptr || column->type != type) {
+        std::cerr << "ColumnFile::columnData [missing column] " << name << " " << to_string(type) << "\n";
+        return nullptr;
+    }
+    return m_file->data() + column->offset;
+}
+
+std::span<const double> ColumnFile::float64(const std::string& name) const
+{
+    const char* data = columnData(name, Type::Float64);
+    return data == nullptr ? std::span<const double> {} : std::span { reinterpret_cast<const double*>(data), find(name)->count() };
+}
+
+std::span<const float> ColumnFile::float32(const std::string& name) const
+{
+    const char* data = columnData(name, Type::Float32);
+    return data == nullptr ? std::span<const float> {} : std::span { reinterpret_cast<const float*>(data), find(name)->count() };
+}
+
+std::span<const std::uint64_t> ColumnFile::uint64(const std::string& name) const
+{
+    const char* data = columnData(name, Type::UInt64);
+    return data == nullptr ? std::span<const std::uint64_t> {} : std::span { reinterpret_cast<const std::uint64_t*>(data), find(name)->count() };
+}
+
+std::vector<bool> ColumnFile::bitmap(const std::string& name) const
+{
+    const char* data = columnData(name, Type::Bitmap);
+    if (data == nullptr) {
+        return {};
+    }
+    std::vector<bool> result(find(name)->count());
+    for (std::size_t i = 0; i < result.size(); ++i) {
+        result[i] = ((static_cast<unsigned char>(data[i / 8]) >> (i % 8)) & 1) != 0;
+    }
+    return result;
+}
+
+std::vector<std::string_view> ColumnFile::strings(const std::string& name) const
+{
+    const char* data = columnData(name, Type::String);
+    if (data == nullptr) {
+        return {};
+    }
+    const auto* column = find(name);
+    const auto* offsets = reinterpret_cast<const std::uint64_t*>(data);
+    const char* chars = m_file->data() + column->dataOffset;
+    std::vector<std::string_view> result;
+    result.reserve(column->count());
+    for (std::size_t i = 0; i < column->count(); ++i) {
+        assert(offsets[i] <= offsets[i + 1] && offsets[i + 1] <= column->dataSize);
+        result.emplace_back(chars + offsets[i], offsets[i + 1] - offsets[i]);
+    }
+    return result;
+}
+
+void ColumnFileWriter::addColumn(ColumnFile::Column column, const void* data, std::size_t size)
+{
+    column.offset = appendAligned(m_data, data, size);
+    column.size = size;
+    m_columns.push_back(std::move(column));
+}
+
+void ColumnFileWriter::add(const std::string& name, const std::vector<double>& values, std::size_t cols)
+{
+    assert(cols == 0 || values.size() % cols == 0);
+    std::vector<std::size_t> shape { values.size() };
+    if (cols > 0) {
+        shape = { values.size() / cols, cols };
+    }
+    addColumn({ name, ColumnFile::Type::Float64, shape }, values.data(), values.size() * sizeof(double));
+}
+
+void ColumnFileWriter::add(const std::string& name, const std::vector<float>& values, std::size_t cols)
+{
+    assert(cols == 0 || values.size() % cols == 0);
+    std::vector<std::size_t> shape { values.size() };
+    if (cols > 0) {
+        shape = { values.size() / cols, cols };
+    }
+    addColumn({ name, ColumnFile::Type::Float32, shape }, values.data(), values.size() * sizeof(float));
+}
+
+void ColumnFileWriter::add(const std::string& name, const std::vector<std::uint64_t>& values)
+{
+    addColumn({ name, ColumnFile::Type::UInt64, { values.size() } }, values.data(), values.size() * sizeof(std::uint64_t));
+}
+
+void ColumnFileWriter::add(const std::string& name, const std::vector<bool>& values)
+{
+    std::vector<unsigned char> bits((values.size() + 7) / 8);
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        if (values[i]) {
+            bits[i / 8] |= static_cast<unsigned char>(1U << (i % 8));
+        }
+    }
+    addColumn({ name, ColumnFile::Type::Bitmap, { values.size() } }, bits.data(), bits.size());
+}
+
+void ColumnFileWriter::add(const std::string& name, const std::vector<std::string>& values)
+{
+    std::vector<std::uint64_t> offsets { 0 };
+    std::string chars;
+    for (const auto& value : values) {
+        chars += value;
+        offsets.push_back(chars.size());
+    }
+    ColumnFile::Column column { name, ColumnFile::Type::String, { values.size() } };
+    column.dataOffset = appendAligned(m_data, chars.data(), chars.size());
+    column.dataSize = chars.size();
+    addColumn(std::move(column), offsets.data(), offsets.size() * sizeof(std::uint64_t));
+}
+
+void ColumnFileWriter::reserve(const std::string& name, ColumnFile::Type type, std::vector<std::size_t> shape)
+{
+    ColumnFile::Column column { name, type, std::move(shape) };
+    column.size = column.count() * ColumnFile::valueSize(type);
+    m_reserved.push_back(std::move(column));
+}
+
+bool ColumnFileWriter::save(const FilePath& path) const
+{
+    auto columns = m_columns;
+    std::size_t end = m_data.size();
+    for (auto column : m_reserved) {
+        column.offset = align(end);
+        end = column.offset + column.size;
+        columns.push_back(std::move(column));
+    }
+
+    // the schema holds absolute offsets, which depend on the size of the schema itself
+    std::size_t base = align(headerSize);
+    std::string text = schema(columns, base);
+    while (align(headerSize + text.size()) > base) {
+        base = align(headerSize + text.size());
+        text = schema(columns, base);
+    }
+
+    std::ofstream file(path, std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "ColumnFileWriter::save [FAILED TO OPEN FILE] " << path << "\n";
+        return false;
+    }
+    const std::uint64_t schemaSize = text.size();
+    std::vector<char> header(base, '\0');
+    std::memcpy(header.data(), magic.data(), magic.size());
+    std::memcpy(header.data() + magic.size(), &schemaSize, sizeof(schemaSize));
+    std::memcpy(header.data() + headerSize, text.data(), text.size());
+    file.write(header.data(), static_cast<std::streamsize>(header.size()));
+    file.write(m_data.data(), static_cast<std::streamsize>(m_data.size()));
+    file.close();
+    if (!file.good()) {
+        std::cerr << "ColumnFileWriter::save [FAILED TO WRITE FILE] " << path << "\n";
+        return false;
+    }
+    if (end > m_data.size()) {
+        std::filesystem::resize_file(path, base + end); // sparse zeros for the reserved columns
+    }
+    return true;
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#pragma once
+
+#include "FilePath.hpp"
+#include "MappedFile.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace portopt {
+
+/*
+ * Columnar binary file, little-endian:
+ *   bytes 0-7   magic "PORTOPT1"
+ *   bytes 8-15  uint64 size of the schema
+ *   bytes 16-   schema as JSON text, then every column starts at a multiple of 64 bytes
+ *
+ * The schema lists each column with its name, type, shape, offset and size in bytes. Strings store uint64 offsets
+ * (one more than the number of strings) at "offset" followed by the characters at "dataOffset". Bitmaps store one bit
+ * per value, least significant bit first. With numpy a column is np.frombuffer(data, dtype, count, offset).
+ */
+class ColumnFile {
+public:
+    enum class Type : std::uint8_t { Float64, Float32, UInt64, Bitmap, String };
+
+    struct Column {
+        std::string name;
+        Type type {};
+        std::vector<std::size_t> shape; // number of values, or {rows, cols} for a matrix
+        std::size_t offset {}; // from the start of the file
+        std::size_t size {}; // bytes
+        std::size_t dataOffset {}; // characters of a string column
+        std::size_t dataSize {};
+
+        [[nodiscard]] std::size_t count() const; // product of the shape
+    };
+
+    explicit ColumnFile(const FilePath& path); // maps the file and reads its schema
+
+    [[nodiscard]] bool isOpen() const noexcept { return m_open; }
+    [[nodiscard]] const std::vector<Column>& columns() const noexcept { return m_columns; }
+    [[nodiscard]] const Column* find(const std::string& name) const; // nullptr if missing
+
+    // Values of a numeric column straight from the mapping, empty if the column is missing or has another type
+    [[nodiscard]] std::span<const double> float64(const std::string& name) const;
+    [[nodiscard]] std::span<const float> float32(const std::string& name) const;
+    [[nodiscard]] std::span<const std::uint64_t> uint64(const std::string& name) const;
+
+    [[nodiscard]] std::vector<bool> bitmap(const std::string& name) const;
+    [[nodiscard]] std::vector<std::string_view> strings(const std::string& name) const; // views into the mapping
+
+    static const char* to_string(Type type);
+    static std::size_t valueSize(Type type); // bytes per value of a numeric type
+
+private:
+    [[nodiscard]] const char* columnData(const std::string& name, Type type) const;
+
+    std::shared_ptr<const MappedFile> m_file;
+    std::vector<Column> m_columns;
+    bool m_open {};
+};
+
+// Builds a ColumnFile in memory and saves it
+class ColumnFileWriter {
+public:
+    void add(const std::string& name, const std::vector<double>& values, std::size_t cols = 0); // cols > 0 for a row-major matrix
+    void add(const std::string& name, const std::vector<float>& values, std::size_t cols = 0); // cols > 0 for a row-major matrix
+    void add(const std::string& name, const std::vector<std::uint64_t>& values);
+    void add(const std::string& name, const std::vector<bool>& values); // bitmap
+    void add(const std::string& name, const std::vector<std::string>& values);
+
+    // Zero filled numeric column placed after the others without being held in memory, filled later through a
+    // writable MappedFile at the offset listed in the schema
+    void reserve(const std::string& name, ColumnFile::Type type, std::vector<std::size_t> shape);
+
+    [[nodiscard]] bool save(const FilePath& path) const;
+
+private:
+    void addColumn(ColumnFile::Column column, const void* data, std::size_t size);
+
+    std::vector<ColumnFile::Column> m_columns; // offsets are relative to the first column until saved
+    std::vector<ColumnFile::Column> m_reserved; // placed after m_data when saved
+    std::vector<char> m_data; // column data, each column 64 byte aligned
+};
+
+} // namespace portopt
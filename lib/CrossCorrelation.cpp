@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "CrossCorrelation.hpp"
+#include "Fft.hpp"
+#include "ReportWriter.hpp"
+#include "ReturnMatrix.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <tuple>
+
+using namespace portopt;
+
+namespace {
+
+using Complex = Fft::Complex;
+
+// Demeaned series with its prefix sums and zero padded spectrum
+struct Series {
+    std::vector<double> sum; // sum[i] of the first i values
+    std::vector<double> sumSq;
+    std::vector<Complex> spectrum;
+
+    Series(std::span<const double> values, const Fft& fft)
+        : sum(values.size() + 1)
+        , sumSq(values.size() + 1)
+        , spectrum(fft.size())
+    {
+        double mean {};
+        for (const double value : values) {
+            mean += value;
+        }
+        mean /= static_cast<double>(values.size());
+        for (std::size_t t = 0; t < values.size(); ++t) {
+            const double value = values[t] - mean; // correlations don't change, products lose less precision
+            sum[t + 1] = sum[t] + value;
+            sumSq[t + 1] = sumSq[t] + (value * value);
+            spectrum[t] = value;
+        }
+        fft.transform(spectrum, false);
+    }
+};
+
+std::size_t clampLag(std::size_t length, std::size_t maxLag)
+{
+    return length < 2 ? 0 : std::min(maxLag, length - 2);
+}
+
+// Pearson correlation at every lag from the circular cross-correlation products[k] = Σ x[t] y[t + k]
+void correlations(const Series& x, const Series& y, std::size_t length, std::size_t maxLag, const std::vector<Complex>& products, bool imag,
+    std::vector<double>& result)
+{
+    const std::size_t size = products.size();
+    result.resize((2 * maxLag) + 1);
+    for (std::size_t k = 0; k <= 2 * maxLag; ++k) {
+        const bool negative = k < maxLag;
+        const std::size_t lag = negative ? maxLag - k : k - maxLag;
+        const std::size_t n = length - lag;
+        // overlap of x and y, x[xBegin, xBegin + n) with y[yBegin, yBegin + n)
+        const std::size_t xBegin = negative ? lag : 0;
+        const std::size_t yBegin = negative ? 0 : lag;
+        const Complex& product = products[negative ? size - lag : lag];
+        const double sxy = imag ? product.imag() : product.real();
+        const double sx = x.sum[xBegin + n] - x.sum[xBegin];
+        const double sy = y.sum[yBegin + n] - y.sum[yBegin];
+        const double sxx = x.sumSq[xBegin + n] - x.sumSq[xBegin] - (sx * sx / static_cast<double>(n));
+        const double syy = y.sumSq[yBegin + n] - y.sumSq[yBegin] - (sy * sy / static_cast<double>(n));
+        const double sxyc = sxy - (sx * sy / static_cast<double>(n));
+        result[k] = sxx > 0 && syy > 0 ? std::clamp(sxyc / std::sqrt(sxx * syy), -1.0, 1.0) : 0;
+    }
+}
+
+} // anonymous namespace
+
+std::vector<double> CrossCorrelation::pearson(std::span<const double> x, std::span<const double> y, std::size_t maxLag)
+{
+    assert(x.size() == y.size());
+    const std::size_t length = std::min(x.size(), y.size());
+    maxLag = clampLag(length, maxLag);
+    if (length < 2) {
+        return { 0 };
+    }
+    const Fft fft { Fft::paddedSize(2 * length) }; // no wrap around at any lag
+    const Series seriesX { x.first(length), fft };
+    const Series seriesY { y.first(length), fft };
+
+    std::vector<Complex> products(fft.size());
+    for (std::size_t i = 0; i < fft.size(); ++i) {
+        products[i] = std::conj(seriesX.spectrum[i]) * seriesY.spectrum[i];
+    }
+    fft.transform(products, true);
+
+    std::vector<double> result;
+    correlations(seriesX, seriesY, length, maxLag, products, false, result);
+    return result;
+}
+
+std::vector<LeadLag> CrossCorrelation::leadLag(const ReturnMatrix& returns, std::size_t maxLag, double minCorrelation)
+{
+    const std::size_t numAssets = returns.numAssets();
+    const std::size_t length = returns.tradingPeriods().size();
+    maxLag = clampLag(length, maxLag);
+    if (numAssets < 2 || maxLag == 0) {
+        return {};
+    }
+    std::cerr << "CrossCorrelation::leadLag [assets] " << numAssets << " [periods] " << length << " [maxLag] " << maxLag << "\n";
+
+    const Fft fft { Fft::paddedSize(2 * length) }; // no wrap around at any lag
+    std::vector<Series> series;
+    series.reserve(numAssets);
+    for (std::size_t a = 0; a < numAssets; ++a) {
+        series.emplace_back(returns.tradingSeries(a), fft); // a lag is one trading day, not one calendar day
+    }
+
+    // the best lag of a pair, the zero lag wins ties and smaller lags win over larger ones
+    const auto bestLag = [&](std::size_t first, std::size_t second, const std::vector<double>& lags, std::vector<LeadLag>& result) {
+        std::size_t best = maxLag;
+        for (std::size_t lag = 1; lag <= maxLag; ++lag) {
+            for (const std::size_t k : { maxLag - lag, maxLag + lag }) {
+                if (std::abs(lags[k]) > std::abs(lags[best])) {
+                    best = k;
+                }
+            }
+        }
+        if (best != maxLag && std::abs(lags[best]) >= minCorrelation) {
+            result.push_back({ first, second, static_cast<int>(best) - static_cast<int>(maxLag), lags[best], lags[maxLag] });
+        }
+    };
+
+    // row i has numAssets - 1 - i pairs, so rows f and numAssets - 1 - f together have the same work for every f
+    const std::size_t numFolded = (numAssets + 1) / 2;
+    std::vector<std::vector<LeadLag>> found(numFolded);
+    Utils::parallelFor(numFolded, [&](std::size_t begin, std::size_t end) {
+        std::vector<Complex> products(fft.size());
+        std::vector<double> lags1;
+        std::vector<double> lags2;
+        const auto row = [&](std::size_t i, std::vector<LeadLag>& result) {
+            // two pairs per inverse transform: their cross-correlations are real, one goes in the imaginary part
+            const auto& x = series[i].spectrum;
+            for (std::size_t j = i + 1; j < numAssets; j += 2) {
+                const bool two = j + 1 < numAssets;
+                for (std::size_t k = 0; k < fft.size(); ++k) {
+                    const Complex product = std::conj(x[k]) * series[j].spectrum[k];
+                    products[k] = two ? product + (Complex { 0, 1 } * std::conj(x[k]) * series[j + 1].spectrum[k]) : product;
+                }
+                fft.transform(products, true);
+                correlations(series[i], series[j], length, maxLag, products, false, lags1);
+                bestLag(i, j, lags1, result);
+                if (two) {
+                    correlations(series[i], series[j + 1], length, maxLag, products, true, lags2);
+                    bestLag(i, j + 1, lags2, result);
+                }
+            }
+        };
+        for (std::size_t f = begin; f < end; ++f) {
+            row(f, found[f]);
+            if (numAssets - 1 - f != f) { // the middle row of an odd number of assets has no partner
+                row(numAssets - 1 - f, found[f]);
+            }
+        }
+    });
+
+    std::vector<LeadLag> result;
+    for (auto& list : found) {
+        result.insert(result.end(), list.begin(), list.end());
+    }
+    std::sort(result.begin(), result.end(), [](const LeadLag& a, const LeadLag& b) {
+        const double absA = std::abs(a.correlation);
+        const double absB = std::abs(b.correlation);
+        return absA != absB ? absA > absB : std::tie(a.first, a.second) < std::tie(b.first, b.second);
+    });
+    return result;
+}
+
+void CrossCorrelation::saveLeadLag(const std::vector<LeadLag>& pairs, const ReturnMatrix& returns, const FilePath& filePath)
+{
+    ReportWriter writer { filePath };
+    if (!writer.isOpen()) {
+        return;
+    }
+    writer << "first,second,lag,correlation,zeroLagCorrelation\n";
+    writer.writeRows(pairs.size(), [&](ReportBuffer& buffer, std::size_t i) {
+        const auto& pair = pairs[i];
+        buffer.append(returns.symbols()[pair.first]);
+        buffer.append(',');
+        buffer.append(returns.symbols()[pair.second]);
+        buffer.append(',');
+        buffer.append(pair.lag);
+        buffer.append(',');
+        buffer.append(pair.correlation);
+        buffer.append(',');
+        buffer.append(pair.zeroLagCorrelation);
+        buffer.append('\n');
+    });
+}
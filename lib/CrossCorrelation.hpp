@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#pragma once
+
+#include "FilePath.hpp"
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace portopt {
+
+class ReturnMatrix;
+
+struct LeadLag {
+    std::size_t first {}; // assets of the ReturnMatrix
+    std::size_t second {};
+    int lag {}; // positive when second leads first by lag trading periods, negative when first leads
+    double correlation {}; // at lag
+    double zeroLagCorrelation {};
+};
+
+namespace CrossCorrelation {
+
+    /**
+     * @brief pearson Correlation of x[t] with y[t + lag] over their overlap, for every lag in [-maxLag, maxLag]
+     * @param x series, most recent first like OhlcList and ReturnMatrix
+     * @param y series of the same size, a positive lag compares x with earlier values of y
+     * @param maxLag largest lag, limited to leave at least two overlapping values
+     * @return 2 * maxLag + 1 correlations, element lag + maxLag
+     *
+     * The sums of products at every lag come from one FFT in O(L log L), the means and variances of each overlap
+     * from prefix sums, so every lag is an exact Pearson correlation.
+     */
+    std::vector<double> pearson(std::span<const double> x, std::span<const double> y, std::size_t maxLag);
+
+    // Pairs of assets whose strongest absolute correlation is at a non-zero lag of at most maxLag and reaches
+    // minCorrelation, by descending absolute correlation. Each spectrum is computed once and the pairs in parallel.
+    // The series are ReturnMatrix::tradingSeries, so the lags count trading periods (trading days of a daily matrix)
+    // and the forward filled weekends don't show up as a lag across the Friday to Monday gap.
+    std::vector<LeadLag> leadLag(const ReturnMatrix& returns, std::size_t maxLag, double minCorrelation);
+    void saveLeadLag(const std::vector<LeadLag>& pairs, const ReturnMatrix& returns, const FilePath& filePath);
+
+} // namespace CrossCorrelation
+} // namespace portopt
@@ -6,15 +6,38 @@
  */
 
 #include "CsvFile.hpp"
+#include "MappedFile.hpp"
 
 #include <algorithm> // For: std::remove
 #include <cassert>
 #include <fstream> // For: std::ifstream
 #include <iostream> // For: std::cerr
 #include <sstream> // For: std::istringstream
+#include <string_view>
 
 using namespace portopt;
 
+void CsvFile::parseLine(std::string_view line, RowType& row)
+{
+    row.clear();
+    while (!line.empty()) {
+        const auto pos = line.find(',');
+        const auto cellView = line.substr(0, pos);
+        std::string cell;
+        cell.reserve(cellView.size());
+        for (const char ch : cellView) {
+            if (ch != '"' && ch != '\r' && ch != '\n') { // remove quotation marks, carriage return and newline
+                cell.push_back(ch);
+            }
+        }
+        row.push_back(std::move(cell));
+        if (pos == std::string_view::npos) {
+            break;
+        }
+        line.remove_prefix(pos + 1);
+    }
+}
+
 CsvFile::CsvFile(const FilePath& path, bool hasHeader)
 {
     std::cerr << "CsvFile::CsvFile [path] " << path << "\n";
@@ -58,3 +81,44 @@ CsvFile::CsvFile(const FilePath& path, bool hasHeader)
         }
     }
 }
+
+CsvFile::CsvFile(const FilePath& path, bool hasHeader, const std::string& minKey)
+{
+    std::cerr << "CsvFile::CsvFile [path] " << path << " [minKey] " << minKey << "\n";
+
+    const MappedFile file { path };
+    assert(file.isOpen());
+    const std::string_view text = file.view();
+
+    // header is the first line of the file
+    std::size_t bodyBegin = 0;
+    if (hasHeader) {
+        const auto eol = text.find('\n');
+        bodyBegin = eol == std::string_view::npos ? text.size() : eol + 1;
+        parseLine(text.substr(0, bodyBegin), m_header);
+    }
+
+    // scan lines backward from the tail and stop once the first column is older than minKey
+    std::vector<std::string_view> lines;
+    std::size_t end = text.size();
+    if (end > bodyBegin && text[end - 1] == '\n') {
+        end--; // no empty row after the trailing newline
+    }
+    while (end > bodyBegin) {
+        const auto nl = text.rfind('\n', end - 1);
+        const std::size_t begin = (nl == std::string_view::npos || nl < bodyBegin) ? bodyBegin : nl + 1;
+        const auto line = text.substr(begin, end - begin);
+        const auto key = line.starts_with('"') ? line.substr(1) : line;
+        if (!key.empty() && key.substr(0, minKey.size()) < minKey) {
+            break;
+        }
+        lines.push_back(line);
+        end = begin > bodyBegin ? begin - 1 : bodyBegin;
+    }
+
+    // rows are stored in the same order as in the file
+    m_data.resize(lines.size());
+    for (std::size_t i = 0; i < lines.size(); ++i) {
+        parseLine(lines[lines.size() - 1 - i], m_data[i]);
+    }
+}
@@ -10,6 +10,7 @@
 #include "FilePath.hpp"
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace portopt {
@@ -19,12 +20,23 @@ class CsvFile {
 public:
     CsvFile(const FilePath& path, bool hasHeader);
 
+    /**
+     * @brief Load only the trailing rows of a CSV file sorted by its first column
+     * @param path path to the CSV file
+     * @param hasHeader whether the first row is a header row
+     * @param minKey rows are read backward from the end of the file until the first column is less than minKey
+     */
+    CsvFile(const FilePath& path, bool hasHeader, const std::string& minKey);
+
     using RowType = std::vector<std::string>; // list of columns in a row
     using TableType = std::vector<RowType>; // list of rows (each row is a list of columns)
 
     [[nodiscard]] const RowType& header() const noexcept { return m_header; }
     [[nodiscard]] const TableType& data() const noexcept { return m_data; }
 
+    // Split a line into cells (same rules as std::getline with ',' as the delimiter), for rows read from a stream
+    static void parseLine(std::string_view line, RowType& row);
+
 private:
     RowType m_header; // list of columns in the header row
     TableType m_data; // list of rows (each row is a list of columns)
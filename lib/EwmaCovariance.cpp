@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "EwmaCovariance.hpp"
+#include "ColumnFile.hpp"
+#include "ReturnMatrix.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+
+using namespace portopt;
+
+namespace {
+
+constexpr std::size_t parallelThreshold = 256; // smaller states are updated on the calling thread
+
+std::uint64_t toSeconds(TimePoint tp)
+{
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::seconds>(tp.time_since_epoch()).count());
+}
+
+TimePoint fromSeconds(std::uint64_t seconds)
+{
+    return TimePoint { std::chrono::seconds { static_cast<std::int64_t>(seconds) } };
+}
+
+// S(i,:) = λ S(i,:) + (1 - λ) r(i) rᵀ for the rows [begin, end)
+void rankOneUpdate(Matrix& sum, const double* returns, double lambda, std::size_t begin, std::size_t end)
+{
+    const std::size_t n = sum.cols();
+    for (std::size_t i = begin; i < end; ++i) {
+        double* row = sum.row(i);
+        const double scaled = (1 - lambda) * returns[i];
+        for (std::size_t j = 0; j < n; ++j) {
+            row[j] = (lambda * row[j]) + (scaled * returns[j]);
+        }
+    }
+}
+
+} // anonymous namespace
+
+EwmaCovariance::EwmaCovariance(const ReturnMatrix& returns, double lambda)
+    : m_symbols { returns.symbols() }
+    , m_lambda { lambda }
+    , m_sum { returns.numAssets(), returns.numAssets() }
+{
+    assert(lambda > 0 && lambda < 1);
+    apply(returns, returns.numPeriods());
+    std::cerr << "EwmaCovariance::EwmaCovariance [assets] " << size() << " [bars] " << m_count << "\n";
+}
+
+std::size_t EwmaCovariance::apply(const ReturnMatrix& returns, std::size_t numPeriods)
+{
+    // the forward filled days of a daily matrix would count as flat bars, their moves go into the next trading day
+    const Matrix bars = returns.tradingReturns(numPeriods);
+    if (bars.rows() == 0) {
+        return 0;
+    }
+    // every row of S evolves on its own, so each thread runs all the bars over its block of rows
+    Utils::parallelFor(size(), [&](std::size_t begin, std::size_t end) {
+        for (std::size_t t = bars.rows(); t-- > 0;) {
+            rankOneUpdate(m_sum, bars.row(t), m_lambda, begin, end);
+        }
+    });
+    m_count += bars.rows();
+    m_lastTime = returns.timepoints()[returns.tradingPeriods().front()];
+    return bars.rows();
+}
+
+void EwmaCovariance::update(const std::vector<double>& returns, TimePoint time)
+{
+    assert(returns.size() == size());
+    if (size() < parallelThreshold) {
+        rankOneUpdate(m_sum, returns.data(), m_lambda, 0, size());
+    } else {
+        Utils::parallelFor(size(), [&](std::size_t begin, std::size_t end) {
+            rankOneUpdate(m_sum, returns.data(), m_lambda, begin, end);
+        });
+    }
+    ++m_count;
+    m_lastTime = time;
+}
+
+std::size_t EwmaCovariance::update(const ReturnMatrix& returns)
+{
+    if (returns.symbols() != m_symbols) {
+        std::cerr << "EwmaCovariance::update [symbols mismatch] " << returns.numAssets() << " != " << size() << "\n";
+        return 0;
+    }
+    const auto& timepoints = returns.timepoints();
+    if (timepoints.empty()) {
+        return 0;
+    }
+    if (timepoints.back() > m_lastTime) {
+        // the bars between lastTime and the oldest period are missing, start over from the whole matrix
+        std::cerr << "EwmaCovariance::update [gap, rebuilding] " << Utils::to_string(m_lastTime) << "\n";
+        m_sum = Matrix { size(), size() };
+        m_count = 0;
+        return apply(returns, returns.numPeriods());
+    }
+    // timepoints are most recent first, the new periods are the prefix that ends after lastTime
+    const auto first = std::find_if(timepoints.begin(), timepoints.end(), [this](TimePoint tp) { return tp <= m_lastTime; });
+    return apply(returns, static_cast<std::size_t>(first - timepoints.begin()));
+}
+
+double EwmaCovariance::covariance(std::size_t i, std::size_t j) const
+{
+    if (m_count == 0) {
+        return 0;
+    }
+    return m_sum(i, j) / (1 - std::pow(m_lambda, static_cast<double>(m_count)));
+}
+
+Matrix EwmaCovariance::covariance() const
+{
+    Matrix result { size(), size() };
+    for (std::size_t i = 0; i < size(); ++i) {
+        for (std::size_t j = 0; j < size(); ++j) {
+            result(i, j) = covariance(i, j);
+        }
+    }
+    return result;
+}
+
+std::vector<double> EwmaCovariance::volatilities() const
+{
+    std::vector<double> result(size());
+    for (std::size_t i = 0; i < size(); ++i) {
+        result[i] = std::sqrt(std::max(0.0, covariance(i, i)));
+    }
+    return result;
+}
+
+double EwmaCovariance::risk(const std::vector<double>& weights) const
+{
+    assert(weights.size() == size());
+    if (m_count == 0) {
+        return 0;
+    }
+    // wᵀSw, then the bias correction once
+    double variance {};
+    for (std::size_t i = 0; i < size(); ++i) {
+        if (weights[i] == 0) {
+            continue;
+        }
+        const double* row = m_sum.row(i);
+        double dot {};
+        for (std::size_t j = 0; j < size(); ++j) {
+            dot += row[j] * weights[j];
+        }
+        variance += weights[i] * dot;
+    }
+    variance /= 1 - std::pow(m_lambda, static_cast<double>(m_count));
+    return std::sqrt(std::max(0.0, variance));
+}
+
+bool EwmaCovariance::save(const FilePath& filePath) const
+{
+    ColumnFileWriter writer;
+    writer.add("symbols", m_symbols);
+    writer.add("lambda", std::vector<double> { m_lambda });
+    writer.add("state", std::vector<std::uint64_t> { m_count, toSeconds(m_lastTime) });
+    writer.add("covariance", m_sum.data(), size());
+    return writer.save(filePath);
+}
+
+EwmaCovariance EwmaCovariance::load(const FilePath& filePath)
+{
+    EwmaCovariance result;
+    const ColumnFile file { filePath };
+    if (!file.isOpen()) {
+        return result;
+    }
+    const auto symbols = file.strings("symbols");
+    const auto lambda = file.float64("lambda");
+    const auto state = file.uint64("state");
+    const auto covariance = file.float64("covariance");
+    if (lambda.size() != 1 || state.size() != 2 || covariance.size() != symbols.size() * symbols.size()) {
+        std::cerr << "EwmaCovariance::load [column size mismatch] " << filePath << "\n";
+        return result;
+    }
+    result.m_symbols.assign(symbols.begin(), symbols.end());
+    result.m_lambda = lambda[0];
+    result.m_count = state[0];
+    result.m_lastTime = fromSeconds(state[1]);
+    result.m_sum = Matrix { symbols.size(), symbols.size() };
+    std::copy(covariance.begin(), covariance.end(), result.m_sum.row(0));
+    return result;
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#pragma once
+
+#include "FilePath.hpp"
+#include "Matrix.hpp"
+#include "RiskEstimator.hpp"
+#include "TimePoint.hpp"
+
+namespace portopt {
+
+class ReturnMatrix;
+
+/*
+ * Exponentially weighted covariance of the returns of a market (RiskMetrics style, zero mean):
+ *     S(t) = λ S(t-1) + (1 - λ) r(t) r(t)ᵀ,    Σ(t) = S(t) / (1 - λᵗ)
+ * where the division removes the bias of starting from S(0) = 0. Each new bar is one rank-1 update of the N x N
+ * state in O(N²), so a saved model is brought up to date with the new periods of a return matrix instead of being
+ * rebuilt from the whole history. The bars are the trading periods of the matrix (see ReturnMatrix::tradingReturns),
+ * weekends and holidays don't decay the weights nor add flat days.
+ */
+class EwmaCovariance : public RiskEstimator {
+public:
+    static constexpr double defaultLambda = 0.94; // decay of daily returns, a half-life of about 11 trading days
+
+    /**
+     * @brief EwmaCovariance Constructor
+     * @param returns aligned returns of every asset, applied from the oldest period, the risk is per period
+     * @param lambda decay of the weights in (0, 1), larger values remember longer
+     */
+    explicit EwmaCovariance(const ReturnMatrix& returns, double lambda = defaultLambda);
+    static EwmaCovariance load(const FilePath& filePath); // file written by save, empty if it can't be read
+
+    [[nodiscard]] const std::vector<std::string>& symbols() const noexcept override { return m_symbols; }
+    [[nodiscard]] double lambda() const noexcept { return m_lambda; }
+    [[nodiscard]] std::size_t count() const noexcept { return m_count; } // bars applied so far
+    [[nodiscard]] TimePoint lastTime() const noexcept { return m_lastTime; } // end of the most recent bar applied
+
+    [[nodiscard]] double covariance(std::size_t i, std::size_t j) const; // Σ(i,j)
+    [[nodiscard]] Matrix covariance() const; // Σ, N x N
+    [[nodiscard]] std::vector<double> volatilities() const; // sqrt(Σ(i,i))
+
+    [[nodiscard]] double risk(const std::vector<double>& weights) const override;
+
+    void update(const std::vector<double>& returns, TimePoint time); // one bar, returns in symbols() order
+
+    /**
+     * @brief update apply the trading periods of returns that end after lastTime(), oldest first. The model is rebuilt
+     *        from the whole matrix if its oldest period ends after lastTime(), the bars in between would be missing
+     * @param returns return matrix over the same symbols (e.g. Market::returns(1) of a newer snapshot)
+     * @return number of bars applied, 0 if the symbols differ
+     */
+    std::size_t update(const ReturnMatrix& returns);
+
+    // ColumnFile with "symbols", "lambda", "state" (count, last time in seconds) and the row-major "covariance" state
+    bool save(const FilePath& filePath) const;
+
+private:
+    EwmaCovariance() = default;
+    std::size_t apply(const ReturnMatrix& returns, std::size_t numPeriods); // trading periods of the most recent numPeriods, oldest first
+
+    std::vector<std::string> m_symbols;
+    double m_lambda { defaultLambda };
+    std::size_t m_count {};
+    TimePoint m_lastTime {};
+    Matrix m_sum; // S(t), N x N
+};
+
+} // namespace portopt
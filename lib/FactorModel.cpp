@@ -0,0 +1,290 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "FactorModel.hpp"
+#include "ColumnFile.hpp"
+#include "ReturnMatrix.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include <random>
+
+using namespace portopt;
+
+namespace {
+
+constexpr std::size_t oversampling = 10; // extra columns of the random subspace
+constexpr std::uint64_t seed = 42; // the same returns always give the same model
+
+// Σ Q with Σ = (A - μ1ᵀ)(A - μ1ᵀ)ᵀ / T for the asset-major returns A (N x T), its transpose and their means μ
+Matrix covarianceTimes(const Matrix& assetMajor, const Matrix& timeMajor, const std::vector<double>& means, const Matrix& q)
+{
+    const std::size_t numAssets = q.rows();
+    const std::size_t cols = q.cols();
+
+    // Z = (A - μ1ᵀ)ᵀ Q = AᵀQ - 1(μᵀQ)
+    Matrix z = Matrix::multiply(timeMajor, q);
+    std::vector<double> meanQ(cols);
+    for (std::size_t i = 0; i < numAssets; ++i) {
+        for (std::size_t j = 0; j < cols; ++j) {
+            meanQ[j] += means[i] * q(i, j);
+        }
+    }
+    for (std::size_t t = 0; t < z.rows(); ++t) {
+        double* row = z.row(t);
+        for (std::size_t j = 0; j < cols; ++j) {
+            row[j] -= meanQ[j];
+        }
+    }
+
+    // (A - μ1ᵀ) Z / T, the rows of Z are centered so μ(1ᵀZ) only removes rounding
+    Matrix result = Matrix::multiply(assetMajor, z);
+    std::vector<double> sumZ(cols);
+    for (std::size_t t = 0; t < z.rows(); ++t) {
+        for (std::size_t j = 0; j < cols; ++j) {
+            sumZ[j] += z(t, j);
+        }
+    }
+    const auto size = static_cast<double>(z.rows());
+    for (std::size_t i = 0; i < numAssets; ++i) {
+        double* row = result.row(i);
+        for (std::size_t j = 0; j < cols; ++j) {
+            row[j] = (row[j] - (means[i] * sumZ[j])) / size;
+        }
+    }
+    return result;
+}
+
+// Modified Gram-Schmidt on the columns, applied twice for orthogonality to working precision
+void orthonormalize(Matrix& q)
+{
+    for (int pass = 0; pass < 2; ++pass) {
+        for (std::size_t j = 0; j < q.cols(); ++j) {
+            for (std::size_t k = 0; k < j; ++k) {
+                double dot {};
+                for (std::size_t i = 0; i < q.rows(); ++i) {
+                    dot += q(i, j) * q(i, k);
+                }
+                for (std::size_t i = 0; i < q.rows(); ++i) {
+                    q(i, j) -= dot * q(i, k);
+                }
+            }
+            double norm {};
+            for (std::size_t i = 0; i < q.rows(); ++i) {
+                norm += q(i, j) * q(i, j);
+            }
+            norm = std::sqrt(norm);
+            for (std::size_t i = 0; i < q.rows(); ++i) {
+                q(i, j) = norm > 0 ? q(i, j) / norm : 0;
+            }
+        }
+    }
+}
+
+// Cyclic Jacobi rotations of a small symmetric matrix: a becomes diagonal (the eigenvalues), v the eigenvectors by column
+void jacobiEigen(Matrix& a, Matrix& v)
+{
+    const std::size_t n = a.rows();
+    v = Matrix { n, n };
+    for (std::size_t i = 0; i < n; ++i) {
+        v(i, i) = 1;
+    }
+    for (int sweep = 0; sweep < 100; ++sweep) {
+        double off {};
+        double diagonal {};
+        for (std::size_t p = 0; p < n; ++p) {
+            diagonal += a(p, p) * a(p, p);
+            for (std::size_t q = p + 1; q < n; ++q) {
+                off += a(p, q) * a(p, q);
+            }
+        }
+        if (off <= 1e-30 * diagonal) {
+            return;
+        }
+        for (std::size_t p = 0; p < n; ++p) {
+            for (std::size_t q = p + 1; q < n; ++q) {
+                if (a(p, q) == 0) {
+                    continue;
+                }
+                const double theta = (a(q, q) - a(p, p)) / (2 * a(p, q));
+                const double t = (theta >= 0 ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt((theta * theta) + 1));
+                const double c = 1 / std::sqrt((t * t) + 1);
+                const double s = t * c;
+                for (std::size_t k = 0; k < n; ++k) {
+                    const double akp = a(k, p);
+                    const double akq = a(k, q);
+                    a(k, p) = (c * akp) - (s * akq);
+                    a(k, q) = (s * akp) + (c * akq);
+                }
+                for (std::size_t k = 0; k < n; ++k) {
+                    const double apk = a(p, k);
+                    const double aqk = a(q, k);
+                    a(p, k) = (c * apk) - (s * aqk);
+                    a(q, k) = (s * apk) + (c * aqk);
+                }
+                for (std::size_t k = 0; k < n; ++k) {
+                    const double vkp = v(k, p);
+                    const double vkq = v(k, q);
+                    v(k, p) = (c * vkp) - (s * vkq);
+                    v(k, q) = (s * vkp) + (c * vkq);
+                }
+            }
+        }
+    }
+    std::cerr << "FactorModel::jacobiEigen [not converged]\n";
+}
+
+} // anonymous namespace
+
+FactorModel::FactorModel(const ReturnMatrix& returns, std::size_t numFactors, std::size_t powerIterations)
+    : m_symbols { returns.symbols() }
+{
+    // the trading periods only, the forward filled days of a daily matrix would add flat returns
+    const Matrix timeMajor = returns.tradingReturns(returns.numPeriods());
+    const Matrix assetMajor = timeMajor.transposed();
+    const std::size_t numAssets = returns.numAssets();
+    const std::size_t numPeriods = timeMajor.rows();
+    numFactors = std::min(numFactors, numAssets);
+    std::cerr << "FactorModel::FactorModel [assets] " << numAssets << " [factors] " << numFactors << "\n";
+    if (numFactors == 0 || numPeriods == 0) {
+        m_loadings = Matrix { numAssets, 0 };
+        m_specificVariances.resize(numAssets);
+        return;
+    }
+
+    std::vector<double> means(numAssets);
+    std::vector<double> variances(numAssets);
+    for (std::size_t i = 0; i < numAssets; ++i) {
+        const double* series = assetMajor.row(i);
+        means[i] = std::accumulate(series, series + numPeriods, 0.0) / static_cast<double>(numPeriods);
+        for (std::size_t t = 0; t < numPeriods; ++t) {
+            variances[i] += (series[t] - means[i]) * (series[t] - means[i]);
+        }
+        variances[i] /= static_cast<double>(numPeriods);
+    }
+
+    // random subspace, sharpened by power iterations toward the largest components
+    const std::size_t cols = std::min(numFactors + oversampling, numAssets);
+    Matrix q { numAssets, cols };
+    std::mt19937_64 engine { seed };
+    std::normal_distribution<double> normal;
+    for (std::size_t i = 0; i < numAssets; ++i) {
+        for (std::size_t j = 0; j < cols; ++j) {
+            q(i, j) = normal(engine);
+        }
+    }
+    orthonormalize(q);
+    for (std::size_t iteration = 0; iteration < powerIterations; ++iteration) {
+        q = covarianceTimes(assetMajor, timeMajor, means, q);
+        orthonormalize(q);
+    }
+
+    // Rayleigh-Ritz: eigenvectors of the small QᵀΣQ mapped back by Q
+    const Matrix sigmaQ = covarianceTimes(assetMajor, timeMajor, means, q);
+    Matrix small = Matrix::multiply(q.transposed(), sigmaQ);
+    for (std::size_t i = 0; i < cols; ++i) {
+        for (std::size_t j = i + 1; j < cols; ++j) {
+            small(i, j) = small(j, i) = (small(i, j) + small(j, i)) / 2;
+        }
+    }
+    Matrix vectors;
+    jacobiEigen(small, vectors);
+    std::vector<std::size_t> order(cols);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&small](std::size_t a, std::size_t b) { return small(a, a) > small(b, b); });
+
+    m_loadings = Matrix { numAssets, numFactors };
+    m_factorVariances.resize(numFactors);
+    m_specificVariances = variances;
+    for (std::size_t f = 0; f < numFactors; ++f) {
+        const std::size_t k = order[f];
+        const double variance = std::max(0.0, small(k, k));
+        const double scale = std::sqrt(variance);
+        m_factorVariances[f] = variance;
+        for (std::size_t i = 0; i < numAssets; ++i) {
+            double component {}; // (Q v)(i)
+            for (std::size_t j = 0; j < cols; ++j) {
+                component += q(i, j) * vectors(j, k);
+            }
+            m_loadings(i, f) = component * scale;
+            m_specificVariances[i] -= m_loadings(i, f) * m_loadings(i, f);
+        }
+    }
+    for (auto& variance : m_specificVariances) {
+        variance = std::max(0.0, variance);
+    }
+}
+
+double FactorModel::explainedVariance() const
+{
+    const double factors = std::accumulate(m_factorVariances.begin(), m_factorVariances.end(), 0.0);
+    const double total = factors + std::accumulate(m_specificVariances.begin(), m_specificVariances.end(), 0.0);
+    return total > 0 ? factors / total : 0;
+}
+
+std::vector<double> FactorModel::exposures(const std::vector<double>& weights) const
+{
+    assert(weights.size() == m_symbols.size());
+    std::vector<double> result(numFactors());
+    for (std::size_t i = 0; i < weights.size(); ++i) {
+        const double* row = m_loadings.row(i);
+        for (std::size_t f = 0; f < result.size(); ++f) {
+            result[f] += weights[i] * row[f];
+        }
+    }
+    return result;
+}
+
+double FactorModel::risk(const std::vector<double>& weights) const
+{
+    // wᵀ(BBᵀ + D)w = |Bᵀw|² + Σ D(i) w(i)²
+    double variance {};
+    for (const double exposure : exposures(weights)) {
+        variance += exposure * exposure;
+    }
+    for (std::size_t i = 0; i < weights.size(); ++i) {
+        variance += m_specificVariances[i] * weights[i] * weights[i];
+    }
+    return std::sqrt(std::max(0.0, variance));
+}
+
+bool FactorModel::save(const FilePath& filePath) const
+{
+    ColumnFileWriter writer;
+    writer.add("symbols", m_symbols);
+    writer.add("factorVariances", m_factorVariances);
+    writer.add("specificVariances", m_specificVariances);
+    writer.add("loadings", m_loadings.data(), numFactors());
+    return writer.save(filePath);
+}
+
+FactorModel FactorModel::load(const FilePath& filePath)
+{
+    FactorModel result;
+    const ColumnFile file { filePath };
+    if (!file.isOpen()) {
+        return result;
+    }
+    const auto symbols = file.strings("symbols");
+    const auto factorVariances = file.float64("factorVariances");
+    const auto specificVariances = file.float64("specificVariances");
+    const auto loadings = file.float64("loadings");
+    if (specificVariances.size() != symbols.size() || loadings.size() != symbols.size() * factorVariances.size()) {
+        std::cerr << "FactorModel::load [column size mismatch] " << filePath << "\n";
+        return result;
+    }
+    result.m_symbols.assign(symbols.begin(), symbols.end());
+    result.m_factorVariances.assign(factorVariances.begin(), factorVariances.end());
+    result.m_specificVariances.assign(specificVariances.begin(), specificVariances.end());
+    result.m_loadings = Matrix { symbols.size(), factorVariances.size() };
+    std::copy(loadings.begin(), loadings.end(), result.m_loadings.row(0));
+    return result;
+}
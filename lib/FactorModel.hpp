@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#pragma once
+
+#include "FilePath.hpp"
+#include "Matrix.hpp"
+#include "RiskEstimator.hpp"
+
+namespace portopt {
+
+class ReturnMatrix;
+
+/*
+ * Statistical factor model of the returns of a market: Σ ≈ BBᵀ + D, where the columns of B (N x k) are the top k
+ * principal components scaled by the square root of their variance and D holds the variance left to each asset.
+ *
+ * The components come from a randomized subspace iteration on the sample covariance, which is never formed: each
+ * product Σ Q is two passes over the return matrix (N x T) with the centering applied as a rank-1 correction. The
+ * model takes O(N k) memory and a portfolio's risk sqrt(|Bᵀw|² + Σ D(i) w(i)²) takes O(N k) time.
+ */
+class FactorModel : public RiskEstimator {
+public:
+    /**
+     * @brief FactorModel Constructor
+     * @param returns aligned returns of every asset, over their trading periods (see ReturnMatrix::tradingReturns), the
+     *        risk is per trading period
+     * @param numFactors principal components kept (at most the number of assets)
+     * @param powerIterations products with Σ used to sharpen the subspace, 2 is enough unless the spectrum is flat
+     */
+    FactorModel(const ReturnMatrix& returns, std::size_t numFactors, std::size_t powerIterations = 2);
+    static FactorModel load(const FilePath& filePath); // file written by save, empty if it can't be read
+
+    [[nodiscard]] const std::vector<std::string>& symbols() const noexcept override { return m_symbols; }
+    [[nodiscard]] std::size_t numFactors() const noexcept { return m_loadings.cols(); }
+    [[nodiscard]] const Matrix& loadings() const noexcept { return m_loadings; } // B, N x k
+    [[nodiscard]] const std::vector<double>& factorVariances() const noexcept { return m_factorVariances; } // eigenvalues, largest first
+    [[nodiscard]] const std::vector<double>& specificVariances() const noexcept { return m_specificVariances; } // D(i)
+    [[nodiscard]] double explainedVariance() const; // share of the total variance captured by the factors
+
+    [[nodiscard]] double risk(const std::vector<double>& weights) const override;
+    [[nodiscard]] std::vector<double> exposures(const std::vector<double>& weights) const; // Bᵀw, the portfolio's risk along each factor
+
+    // ColumnFile with "symbols", "factorVariances", "specificVariances" and the row-major "loadings"
+    bool save(const FilePath& filePath) const;
+
+private:
+    FactorModel() = default;
+
+    std::vector<std::string> m_symbols;
+    Matrix m_loadings;
+    std::vector<double> m_factorVariances;
+    std::vector<double> m_specificVariances;
+};
+
+} // namespace portopt
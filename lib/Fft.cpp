@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "Fft.hpp"
+
+#include <cassert>
+#include <numbers>
+
+using namespace portopt;
+
+Fft::Fft(std::size_t size)
+    : m_size { size }
+    , m_twiddles(size / 2)
+    , m_reversed(size)
+{
+    assert(size > 0 && (size & (size - 1)) == 0);
+    for (std::size_t k = 0; k < size / 2; ++k) {
+        m_twiddles[k] = std::polar(1.0, -2 * std::numbers::pi * static_cast<double>(k) / static_cast<double>(size));
+    }
+    for (std::size_t i = 1, j = 0; i < size; ++i) {
+        std::size_t bit = size >> 1;
+        for (; (j & bit) != 0; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        m_reversed[i] = j;
+    }
+}
+
+std::size_t Fft::paddedSize(std::size_t length)
+{
+    std::size_t size = 1;
+    while (size < length) {
+        size <<= 1;
+    }
+    return size;
+}
+
+void Fft::transform(std::vector<Complex>& data, bool inverse) const
+{
+    assert(data.size() == m_size);
+    for (std::size_t i = 0; i < m_size; ++i) {
+        if (i < m_reversed[i]) {
+            std::swap(data[i], data[m_reversed[i]]);
+        }
+    }
+    for (std::size_t length = 2; length <= m_size; length <<= 1) {
+        const std::size_t step = m_size / length;
+        for (std::size_t begin = 0; begin < m_size; begin += length) {
+            for (std::size_t k = 0; k < length / 2; ++k) {
+                const Complex twiddle = inverse ? std::conj(m_twiddles[k * step]) : m_twiddles[k * step];
+                const Complex odd = data[begin + k + (length / 2)] * twiddle;
+                data[begin + k + (length / 2)] = data[begin + k] - odd;
+                data[begin + k] += odd;
+            }
+        }
+    }
+    if (inverse) {
+        for (auto& value : data) {
+            value /= static_cast<double>(m_size);
+        }
+    }
+}
@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+namespace portopt {
+
+// Iterative radix-2 FFT of one power of two size, with precomputed twiddles and bit reversal
+class Fft {
+public:
+    using Complex = std::complex<double>;
+
+    explicit Fft(std::size_t size);
+
+    static std::size_t paddedSize(std::size_t length); // smallest power of two >= length
+
+    [[nodiscard]] std::size_t size() const noexcept { return m_size; }
+    void transform(std::vector<Complex>& data, bool inverse) const; // in place, the inverse is scaled by 1 / size
+
+private:
+    std::size_t m_size;
+    std::vector<Complex> m_twiddles;
+    std::vector<std::size_t> m_reversed;
+};
+
+} // namespace portopt
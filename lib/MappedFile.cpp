@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "MappedFile.hpp"
+
+#include <cassert>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace portopt;
+
+MappedFile::MappedFile(const FilePath& path, Mode mode)
+    : m_writable { mode == Mode::ReadWrite }
+{
+    const int fd = ::open(path.c_str(), m_writable ? O_RDWR : O_RDONLY); // NOLINT(cppcoreguidelines-pro-type-vararg)
+    if (fd < 0) {
+        std::cerr << "MappedFile::MappedFile [failed to open] " << path << "\n";
+        return;
+    }
+
+    struct stat st {};
+    if (::fstat(fd, &st) != 0) {
+        std::cerr << "MappedFile::MappedFile [failed to stat] " << path << "\n";
+        ::close(fd);
+        return;
+    }
+
+    if (st.st_size > 0) {
+        const int protection = m_writable ? PROT_READ | PROT_WRITE : PROT_READ;
+        void* ptr = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), protection, m_writable ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+        if (ptr == MAP_FAILED) {
+            std::cerr << "MappedFile::MappedFile [failed to map] " << path << "\n";
+            ::close(fd);
+            return;
+        }
+        m_data = static_cast<char*>(ptr);
+        m_size = static_cast<std::size_t>(st.st_size);
+    }
+    ::close(fd); // the mapping stays valid after closing the descriptor
+    m_open = true;
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_data != nullptr) {
+        ::munmap(m_data, m_size);
+    }
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#pragma once
+
+#include "FilePath.hpp"
+
+#include <cstdint>
+#include <string_view>
+
+namespace portopt {
+
+// File mapped into memory, read only unless opened with Mode::ReadWrite
+class MappedFile {
+public:
+    enum class Mode : std::uint8_t { ReadOnly, ReadWrite };
+
+    explicit MappedFile(const FilePath& path, Mode mode = Mode::ReadOnly); // ReadWrite changes are written back to the file
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    [[nodiscard]] bool isOpen() const noexcept { return m_open; }
+    [[nodiscard]] std::size_t size() const noexcept { return m_size; }
+    [[nodiscard]] const char* data() const noexcept { return m_data; }
+    [[nodiscard]] std::string_view view() const noexcept { return { m_data, m_size }; }
+    [[nodiscard]] char* writableData() noexcept { return m_writable ? m_data : nullptr; }
+
+private:
+    char* m_data {}; // start of the mapping (nullptr for empty or missing files)
+    std::size_t m_size {}; // size of the mapping in bytes
+    bool m_open {}; // false if the file could not be opened or mapped
+    bool m_writable {}; // shared writable mapping
+};
+
+} // namespace portopt
@@ -6,7 +6,12 @@
  */
 
 #include "Market.hpp"
-#include "EnumUtils.hpp"
+#include "EwmaCovariance.hpp"
+#include "FactorModel.hpp"
+#include "MarketInfo.hpp"
+#include "ReturnMatrix.hpp"
+#include "RiskModel.hpp"
+#include "SimilarityIndex.hpp"
 #include "Utils.hpp"
 
 #include <algorithm> // std::min
@@ -14,12 +19,22 @@
 #include <fstream>
 #include <iomanip> // std::setprecision
 #include <iostream>
+#include <mutex>
 #include <set>
 #include <sstream> // std::stringstream
+#include <tuple>
 #include <unordered_map>
 
 using namespace portopt;
 
+struct Market::Cache {
+    std::mutex mutex;
+    std::map<std::tuple<size_t, PriceType, ReturnType, OhlcTimeFrame, PriceAdjustment>, std::unique_ptr<const ReturnMatrix>> returns;
+    std::unique_ptr<const RiskModel> riskModel;
+    std::map<std::size_t, std::unique_ptr<const FactorModel>> factorModels;
+    std::map<double, std::unique_ptr<const EwmaCovariance>> ewmaCovariances;
+};
+
 namespace {
 
 auto loadAssetInfo(const CsvFile& infoCsv)
@@ -49,7 +64,7 @@ auto getAssetInfo(const CsvFile::RowType& info)
     return result;
 }
 
-auto loadAssetsFromFile(const FilePath& dataDir, const CsvFile& infoCsv, const std::set<std::string>& symbols)
+auto loadAssetsFromFile(const FilePath& dataDir, const CsvFile& infoCsv, const std::set<std::string>& symbols, const DateRange& range)
 {
     std::map<std::string, Asset> result;
 
@@ -76,9 +91,9 @@ auto loadAssetsFromFile(const FilePath& dataDir, const CsvFile& infoCsv, const s
                 continue;
             }
             if (infoMap.contains(symbol)) {
-                result.insert({ symbol, Asset { symbol, dataDir, getAssetInfo(infoMap.at(symbol)) } });
+                result.insert({ symbol, Asset { symbol, dataDir, getAssetInfo(infoMap.at(symbol)), range } });
             } else {
-                result.insert({ symbol, Asset { symbol, dataDir, AssetInfo {} } });
+                result.insert({ symbol, Asset { symbol, dataDir, AssetInfo {}, range } });
             }
         }
     }
@@ -100,14 +115,16 @@ auto loadAssetsFromVector(const std::vector<Asset>& assets)
 
 } // anonymous namespace
 
-Market::Market(const FilePath& symbolsDir, const CsvFile& infoCsv, const std::set<std::string>& symbols)
-    : m_assets { loadAssetsFromFile(symbolsDir, infoCsv, symbols) }
+Market::Market(const FilePath& symbolsDir, const CsvFile& infoCsv, const std::set<std::string>& symbols, const DateRange& range)
+    : m_assets { loadAssetsFromFile(symbolsDir, infoCsv, symbols, range) }
+    , m_cache { std::make_shared<Cache>() }
 {
     std::cerr << "\nMarket::Market assets.size: " << m_assets.size() << "\n";
 }
 
 Market::Market(const std::vector<Asset>& assets)
     : m_assets { loadAssetsFromVector(assets) }
+    , m_cache { std::make_shared<Cache>() }
 {
     std::cerr << "\nMarket::Market assets.size: " << m_assets.size() << "\n";
 }
@@ -136,6 +153,68 @@ double Market::correlation(const std::string& symbol1, const std::string& symbol
     return asset1.correlation(asset2, PriceType::HL2, false, 400);
 }
 
+std::map<std::string, double> Market::maxDrawdown(std::size_t begin, std::size_t end) const
+{
+    std::vector<const Asset*> assets;
+    for (const auto& [symbol, asset] : m_assets) {
+        if (begin < std::min(end, asset.ohlc().size())) {
+            assets.push_back(&asset);
+        }
+    }
+    std::vector<double> values(assets.size());
+    Utils::parallelFor(assets.size(), [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; ++i) {
+            values[i] = assets[i]->ohlc().maxDrawdown(begin, end); // builds the table of each list once
+        }
+    });
+    std::map<std::string, double> result;
+    for (std::size_t i = 0; i < assets.size(); ++i) {
+        result.emplace(assets[i]->symbol(), values[i]);
+    }
+    return result;
+}
+
+const ReturnMatrix& Market::returns(size_t horizon, PriceType priceType, ReturnType returnType, OhlcTimeFrame timeFrame, PriceAdjustment adjustment) const
+{
+    const std::lock_guard<std::mutex> lock { m_cache->mutex };
+    auto& item = m_cache->returns[{ horizon, priceType, returnType, timeFrame, adjustment }];
+    if (!item) {
+        item = std::make_unique<const ReturnMatrix>(*this, horizon, priceType, returnType, timeFrame, adjustment);
+    }
+    return *item;
+}
+
+const RiskModel& Market::riskModel() const
+{
+    const std::lock_guard<std::mutex> lock { m_cache->mutex };
+    if (!m_cache->riskModel) {
+        m_cache->riskModel = std::make_unique<const RiskModel>(*this);
+    }
+    return *m_cache->riskModel;
+}
+
+const FactorModel& Market::factorModel(std::size_t numFactors) const
+{
+    const ReturnMatrix& daily = returns(1); // locks the cache itself
+    const std::lock_guard<std::mutex> lock { m_cache->mutex };
+    auto& item = m_cache->factorModels[numFactors];
+    if (!item) {
+        item = std::make_unique<const FactorModel>(daily, numFactors);
+    }
+    return *item;
+}
+
+const EwmaCovariance& Market::ewmaCovariance(double lambda) const
+{
+    const ReturnMatrix& daily = returns(1); // locks the cache itself
+    const std::lock_guard<std::mutex> lock { m_cache->mutex };
+    auto& item = m_cache->ewmaCovariances[lambda];
+    if (!item) {
+        item = std::make_unique<const EwmaCovariance>(daily, lambda);
+    }
+    return *item;
+}
+
 void Market::saveAssets(const FilePath& symbolsDir) const
 {
     for (const auto& asset : m_assets) {
@@ -143,49 +222,92 @@ void Market::saveAssets(const FilePath& symbolsDir) const
     }
 }
 
-void Market::saveCorrelationList(const FilePath& filePath) const
+void Market::saveCorrelationList(const FilePath& filePath, size_t shard, size_t numShards) const
 {
+    assert(shard < numShards);
     std::cerr << "\nMarket::saveCorrelationList [begin]\n";
     std::ofstream outFile(filePath, std::ios::out | std::ios::trunc);
     assert(outFile.is_open());
 
-    for (const auto& item1 : m_assets) {
-        const auto& asset = item1.second;
+    constexpr size_t length = 400; // days of prices compared
+    constexpr size_t maxSize = 10; // top 10 with highest correlation
+    constexpr double threshold = 0.95;
+
+    // ETFs with a full window of aligned prices are indexed, the others are compared one pair at a time
+    std::vector<const Asset*> etfs;
+    std::vector<std::string> symbols;
+    std::vector<std::vector<double>> series;
+    for (const auto& [symbol, asset] : m_assets) {
         if (!asset.isETF()) {
             continue;
         }
+        etfs.push_back(&asset);
+        if (asset.ohlc().size() >= length && (series.empty() || asset.ohlc().matchTimePoint(m_assets.at(symbols.front()).ohlc(), length))) {
+            symbols.push_back(symbol);
+            series.push_back(asset.ohlc().toVector(length, 0, PriceType::HL2));
+        }
+    }
+    const SimilarityIndex index { symbols, series };
+
+    // the shard writes the entries of its slice of the ETFs, compared with every other ETF
+    const size_t first = etfs.size() * shard / numShards;
+    const size_t last = etfs.size() * (shard + 1) / numShards;
+    std::vector<std::vector<SimilarityIndex::Match>> topK(index.size());
+    if (numShards == 1) {
+        topK = index.allTopK(maxSize, threshold);
+    } else {
+        Utils::parallelFor(last - first, [&](size_t begin, size_t end) {
+            for (size_t k = first + begin; k < first + end; ++k) {
+                const size_t i = index.index(etfs[k]->symbol());
+                if (i != SimilarityIndex::npos) {
+                    topK[i] = index.topK(i, maxSize, threshold);
+                }
+            }
+        });
+    }
+
+    for (size_t k = first; k < last; ++k) {
+        const Asset* etf = etfs[k];
+        const auto& asset = *etf;
         std::cerr << "Market::saveCorrelationList [sym] " << asset.symbol() << "\n";
 
-        outFile << item1.first
+        outFile << asset.symbol()
                 << " (" << asset.yahoo("longName") << ") [" << asset.info().expenseRatio << "] "
                 << asset.tags() << "\n";
 
-        std::vector<std::pair<double, std::string>> list; // list of correlations with other ETFs (correlation, symbol)
-
-        for (const auto& item2 : m_assets) {
-            if (item1.first == item2.first || !item2.second.isETF()) {
-                continue; // skip the same asset and non-ETF assets
+        // candidates from the index, plus every pair the index can't answer
+        const size_t i = index.index(asset.symbol());
+        std::vector<std::pair<double, const Asset*>> list; // list of correlations with other ETFs (correlation, asset)
+        if (i != SimilarityIndex::npos) {
+            for (const auto& match : topK[i]) {
+                const auto& other = m_assets.at(symbols[match.index]);
+                list.emplace_back(asset.correlation(other, PriceType::HL2, false, length), &other);
+            }
+        }
+        for (const Asset* other : etfs) {
+            if (other == etf || (i != SimilarityIndex::npos && index.index(other->symbol()) != SimilarityIndex::npos)) {
+                continue; // skip the same asset and pairs already answered by the index
+            }
+            const auto correlation = asset.correlation(*other, PriceType::HL2, false, length);
+            if (correlation > threshold) {
+                list.emplace_back(correlation, other);
             }
-
-            const auto correlation1 = asset.correlation(item2.second, PriceType::HL2, false, 400);
-            const auto correlation2 = asset.correlation(item2.second, PriceType::HL2, true, 400);
-
-            std::stringstream ss;
-            ss << std::setprecision(3) << correlation1 << "\t" << correlation2 << "\t"
-               << item2.first
-               << " (" << item2.second.yahoo("longName") << ") [" << item2.second.info().expenseRatio << "] "
-               << item2.second.tags();
-
-            list.emplace_back(correlation1, ss.str());
         }
 
-        std::sort(list.rbegin(), list.rend()); // sort in descending order
+        std::sort(list.begin(), list.end(), [](const auto& a, const auto& b) { return a.first > b.first; }); // descending order
+        list.resize(std::min(maxSize, list.size()));
 
-        const size_t maxSize = std::min(static_cast<size_t>(10), list.size()); // top 10 with highest correlation
-        for (size_t i = 0; i < maxSize; ++i) {
-            if (list[i].first > 0.95) {
-                outFile << "\t" << list[i].second << "\n";
+        for (const auto& [correlation, other] : list) {
+            if (correlation <= threshold) {
+                continue;
             }
+            // Spearman only for the printed pairs
+            std::stringstream ss;
+            ss << std::setprecision(3) << correlation << "\t" << asset.correlation(*other, PriceType::HL2, true, length) << "\t"
+               << other->symbol()
+               << " (" << other->yahoo("longName") << ") [" << other->info().expenseRatio << "] "
+               << other->tags();
+            outFile << "\t" << ss.str() << "\n";
         }
         outFile << "\n";
     }
@@ -195,75 +317,7 @@ void Market::saveCorrelationList(const FilePath& filePath) const
 void Market::saveMarketInfo(const FilePath& filePath) const
 {
     std::cerr << "\nMarket::saveMarketInfo [begin]\n";
-    std::ofstream outFile(filePath, std::ios::out | std::ios::trunc);
-    assert(outFile.is_open());
-
-    // Header   1      2    3        4             5            6              7            8           9            10            11        12
-    outFile << "symbol,name,category,dividendYield,expenseRatio,percentFromAth,percentToAth,historySize,return30days,return365days,avgReturn,avgRisk";
-
-    // Tags
-    for (AssetClass tag = AssetClass::ETF; tag <= AssetClass::Unclassified; tag = static_cast<AssetClass>(static_cast<int>(tag) + 1)) {
-        outFile << ",is-" << EnumUtils::to_string(tag);
-    }
-
-    // Pearson Correlations
-    for (const auto& item : m_assets) {
-        if (!item.second.isETF()) {
-            continue;
-        }
-        outFile << ",PC-" << item.first;
-    }
-
-    // Spearman Correlations
-    for (const auto& item : m_assets) {
-        if (!item.second.isETF()) {
-            continue;
-        }
-        outFile << ",SC-" << item.first;
-    }
-
-    outFile << "\n";
-
-    for (const auto& item1 : m_assets) {
-        const auto& asset = item1.second;
-        std::cerr << "Market::saveMarketInfo [sym] " << asset.symbol() << "\n";
-
-        outFile << item1.first << "," // 1
-                << asset.yahoo("longName") << "," // 2
-                << asset.yahoo("category") << asset.yahoo("sector") << "," // 3
-                << asset.info().dividendYield << "," // 4
-                << asset.info().expenseRatio << "," // 5
-                << asset.ohlc().percentFromAth(0) << "," // 6
-                << asset.ohlc().percentToAth(0) << "," // 7
-                << asset.ohlc().size() << "," // 8
-                << asset.ohlc().priceChange(0, 30, PriceType::HL2) << "," // 9
-                << asset.ohlc().priceChange(0, 365, PriceType::HL2) << "," // 10
-                << asset.ohlc().avgReturn(365) << "," // 11
-                << asset.ohlc().avgRisk(365); // 12
-
-        // Tags
-        for (AssetClass tag = AssetClass::ETF; tag <= AssetClass::Unclassified; tag = static_cast<AssetClass>(static_cast<int>(tag) + 1)) {
-            outFile << "," << asset.hasTag(tag);
-        }
-
-        // Pearson Correlation
-        for (const auto& item2 : m_assets) {
-            if (!item2.second.isETF()) {
-                continue;
-            }
-            outFile << "," << item1.second.correlation(item2.second, PriceType::OHLC4, false, 400);
-        }
-
-        // Spearman Correlation
-        for (const auto& item2 : m_assets) {
-            if (!item2.second.isETF()) {
-                continue;
-            }
-            outFile << "," << item1.second.correlation(item2.second, PriceType::OHLC4, true, 400);
-        }
-
-        outFile << "\n";
-    }
+    MarketInfo { *this }.saveCsv(filePath);
     std::cerr << "Market::saveMarketInfo [end]\n";
 }
 
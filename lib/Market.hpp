@@ -10,9 +10,15 @@
 #include "Asset.hpp"
 
 #include <map>
+#include <memory>
 
 namespace portopt {
 
+class EwmaCovariance;
+class FactorModel;
+class ReturnMatrix;
+class RiskModel;
+
 class Market {
 public:
     /**
@@ -20,8 +26,9 @@ public:
      * @param symbolsDir path to SYM.csv and SYM.json files
      * @param infoCsv loaded market.csv file
      * @param symbols list of symbols to load (default: all)
+     * @param range dates of the price history to load for each asset
      */
-    Market(const FilePath& symbolsDir, const CsvFile& infoCsv, const std::set<std::string>& symbols = {});
+    Market(const FilePath& symbolsDir, const CsvFile& infoCsv, const std::set<std::string>& symbols = {}, const DateRange& range = OhlcList::defaultRange());
 
     /**
      * @brief Market Constructor
@@ -36,6 +43,12 @@ public:
      */
     [[nodiscard]] const Asset& get(const std::string& symbol) const;
 
+    /**
+     * @brief assets
+     * @return all loaded assets ordered by symbol
+     */
+    [[nodiscard]] const std::map<std::string, Asset>& assets() const noexcept { return m_assets; }
+
     /**
      * @brief correlation
      * @param symbol1
@@ -44,13 +57,56 @@ public:
      */
     [[nodiscard]] double correlation(const std::string& symbol1, const std::string& symbol2) const;
 
+    /**
+     * @brief maxDrawdown Largest peak to trough decline of every asset over the same entries, O(1) per asset
+     * @param begin most recent entry of the window
+     * @param end one past the oldest entry of the window, clamped to the history of each asset
+     * @return symbol to max drawdown in percent, assets without an entry in the window are left out
+     */
+    [[nodiscard]] std::map<std::string, double> maxDrawdown(std::size_t begin, std::size_t end) const;
+
+    /**
+     * @brief returns Aligned returns of all assets, built once per set of arguments and shared by all analytics
+     * @param horizon number of bars between the two prices of each return
+     * @param priceType price used from each OHLC entry
+     * @param returnType simple or log returns
+     * @param timeFrame bars of the returns, coarser ones come from OhlcList::resample
+     * @param adjustment raw or adjusted prices, both series come from the loaded lists
+     * @return const reference to the cached return matrix
+     */
+    [[nodiscard]] const ReturnMatrix& returns(size_t horizon, PriceType priceType = PriceType::HL2, ReturnType returnType = ReturnType::Simple,
+        OhlcTimeFrame timeFrame = OhlcTimeFrame::Daily, PriceAdjustment adjustment = PriceAdjustment::None) const;
+
+    /**
+     * @brief riskModel Dense covariance model of all assets, built on first use
+     * @return const reference to the cached risk model
+     */
+    [[nodiscard]] const RiskModel& riskModel() const;
+
+    /**
+     * @brief factorModel Principal component model of the daily returns, an O(N k) alternative to riskModel()
+     * @param numFactors components kept
+     * @return const reference to the cached model, one per number of factors
+     */
+    [[nodiscard]] const FactorModel& factorModel(std::size_t numFactors) const;
+
+    /**
+     * @brief ewmaCovariance Exponentially weighted covariance of the daily returns, recent bars weigh more
+     * @param lambda decay of the weights, see EwmaCovariance::defaultLambda
+     * @return const reference to the cached model, one per decay
+     */
+    [[nodiscard]] const EwmaCovariance& ewmaCovariance(double lambda) const;
+
     void saveAssets(const FilePath& symbolsDir) const; // Save ohlc data
-    void saveCorrelationList(const FilePath& filePath) const;
+    void saveCorrelationList(const FilePath& filePath, size_t shard = 0, size_t numShards = 1) const; // entries of one shard of the ETFs
     void saveMarketInfo(const FilePath& filePath) const;
     void saveSymbols(const FilePath& filePath) const; // Save symbols array
 
 private:
+    struct Cache; ///< Lazily computed analytics, shared between copies
+
     const std::map<std::string, Asset> m_assets; ///< Symbol to Asset hashmap
+    const std::shared_ptr<Cache> m_cache;
 };
 
 } // namespace portopt
@@ -0,0 +1,351 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "MarketInfo.hpp"
+#include "ColumnFile.hpp"
+#include "EnumUtils.hpp"
+#include "Market.hpp"
+#include "ReportWriter.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+
+using namespace portopt;
+
+namespace {
+
+constexpr auto numTags = static_cast<std::size_t>(AssetClass::LastTag);
+
+std::vector<float> toFloat(const Matrix& matrix)
+{
+    return { matrix.data().begin(), matrix.data().end() };
+}
+
+} // anonymous namespace
+
+MarketInfo::MarketInfo(const Market& market, std::size_t shard, std::size_t numShards)
+{
+    assert(shard < numShards);
+    std::vector<const Asset*> assets;
+    std::vector<const Asset*> etfs;
+    for (const auto& [symbol, asset] : market.assets()) {
+        assets.push_back(&asset);
+        if (asset.isETF()) {
+            etfs.push_back(&asset);
+            m_etfs.push_back(symbol);
+        }
+    }
+    const std::size_t count = assets.size();
+    assets.erase(assets.begin() + static_cast<std::ptrdiff_t>(count * (shard + 1) / numShards), assets.end());
+    assets.erase(assets.begin(), assets.begin() + static_cast<std::ptrdiff_t>(count * shard / numShards));
+
+    m_rows.resize(assets.size());
+    m_pearson = Matrix(assets.size(), etfs.size());
+    m_spearman = Matrix(assets.size(), etfs.size());
+
+    Utils::parallelFor(assets.size(), [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            const auto& asset = *assets[i];
+            std::cerr << "MarketInfo::MarketInfo [sym] " + asset.symbol() + "\n";
+
+            auto& row = m_rows[i];
+            row.symbol = asset.symbol();
+            row.name = asset.yahoo("longName");
+            row.category = asset.yahoo("category") + asset.yahoo("sector");
+            row.dividendYield = asset.info().dividendYield;
+            row.expenseRatio = asset.info().expenseRatio;
+            row.percentFromAth = asset.ohlc().percentFromAth(0);
+            row.percentToAth = asset.ohlc().percentToAth(0);
+            row.historySize = asset.ohlc().size();
+            row.return30days = asset.ohlc().priceChange(0, 30, PriceType::HL2);
+            row.return365days = asset.ohlc().priceChange(0, 365, PriceType::HL2);
+            row.avgReturn = asset.ohlc().avgReturn(365);
+            row.avgRisk = asset.ohlc().avgRisk(365);
+            row.risk = RiskMetrics::compute(asset.ohlc());
+            for (std::size_t tag = 0; tag < numTags; ++tag) {
+                row.tags[tag] = asset.hasTag(static_cast<AssetClass>(tag));
+            }
+
+            for (std::size_t j = 0; j < etfs.size(); ++j) {
+                m_pearson(i, j) = asset.correlation(*etfs[j], PriceType::OHLC4, false, 400);
+                m_spearman(i, j) = asset.correlation(*etfs[j], PriceType::OHLC4, true, 400);
+            }
+        }
+    });
+}
+
+MarketInfo MarketInfo::merge(const std::vector<MarketInfo>& shards)
+{
+    MarketInfo result;
+    if (shards.empty()) {
+        return result;
+    }
+    std::size_t size {};
+    const std::string* previous {};
+    for (const auto& shard : shards) {
+        if (shard.m_etfs != shards.front().m_etfs) {
+            std::cerr << "MarketInfo::merge [etfs mismatch]\n";
+            return result;
+        }
+        // the rows of consecutive shards continue the symbol order, overlaps or swapped shards break it
+        if (!shard.m_rows.empty() && previous != nullptr && *previous >= shard.m_rows.front().symbol) {
+            std::cerr << "MarketInfo::merge [rows out of order] " << shard.m_rows.front().symbol << "\n";
+            return result;
+        }
+        if (!shard.m_rows.empty()) {
+            previous = &shard.m_rows.back().symbol;
+        }
+        size += shard.m_rows.size();
+    }
+
+    result.m_etfs = shards.front().m_etfs;
+    result.m_rows.reserve(size);
+    result.m_pearson = Matrix(size, result.m_etfs.size());
+    result.m_spearman = Matrix(size, result.m_etfs.size());
+    for (const auto& shard : shards) {
+        for (std::size_t i = 0; i < shard.m_rows.size(); ++i) {
+            std::copy_n(shard.m_pearson.row(i), result.m_etfs.size(), result.m_pearson.row(result.m_rows.size()));
+            std::copy_n(shard.m_spearman.row(i), result.m_etfs.size(), result.m_spearman.row(result.m_rows.size()));
+            result.m_rows.push_back(shard.m_rows[i]);
+        }
+    }
+    return result;
+}
+
+std::size_t MarketInfo::index(const std::string& symbol) const
+{
+    const auto itr = std::lower_bound(m_rows.begin(), m_rows.end(), symbol, [](const Row& row, const std::string& value) { return row.symbol < value; });
+    return (itr == m_rows.end() || itr->symbol != symbol) ? npos : static_cast<std::size_t>(itr - m_rows.begin());
+}
+
+void MarketInfo::saveCsv(const FilePath& filePath) const
+{
+    ReportWriter writer { filePath };
+    assert(writer.isOpen());
+
+    // Header   1      2    3        4             5            6              7            8           9            10            11        12
+    writer << "symbol,name,category,dividendYield,expenseRatio,percentFromAth,percentToAth,historySize,return30days,return365days,avgReturn,avgRisk";
+
+    // Risk   13 ...
+    for (const auto& name : RiskStats::names()) {
+        writer << ',' << name;
+    }
+
+    // Tags
+    for (std::size_t tag = 0; tag < numTags; ++tag) {
+        writer << ",is-" << EnumUtils::to_string(static_cast<AssetClass>(tag));
+    }
+
+    // Pearson Correlations
+    for (const auto& etf : m_etfs) {
+        writer << ",PC-" << etf;
+    }
+
+    // Spearman Correlations
+    for (const auto& etf : m_etfs) {
+        writer << ",SC-" << etf;
+    }
+
+    writer << '\n';
+
+    writer.writeRows(m_rows.size(), [&](ReportBuffer& buffer, std::size_t i) {
+        const auto& row = m_rows[i];
+        buffer.append(row.symbol); // 1
+        buffer.append(',');
+        buffer.append(row.name); // 2
+        buffer.append(',');
+        buffer.append(row.category); // 3
+        for (const double value : { row.dividendYield, row.expenseRatio, row.percentFromAth, row.percentToAth }) { // 4-7
+            buffer.append(',');
+            buffer.append(value);
+        }
+        buffer.append(',');
+        buffer.append(row.historySize); // 8
+        for (const double value : { row.return30days, row.return365days, row.avgReturn, row.avgRisk }) { // 9-12
+            buffer.append(',');
+            buffer.append(value);
+        }
+        for (const double value : row.risk.values()) { // 13 ...
+            buffer.append(',');
+            buffer.append(value);
+        }
+
+        // Tags
+        for (std::size_t tag = 0; tag < numTags; ++tag) {
+            buffer.append(',');
+            buffer.append(row.tags[tag]);
+        }
+
+        // Pearson Correlation
+        for (std::size_t j = 0; j < m_etfs.size(); ++j) {
+            buffer.append(',');
+            buffer.append(m_pearson(i, j));
+        }
+
+        // Spearman Correlation
+        for (std::size_t j = 0; j < m_etfs.size(); ++j) {
+            buffer.append(',');
+            buffer.append(m_spearman(i, j));
+        }
+
+        buffer.append('\n');
+    });
+}
+
+bool MarketInfo::saveBinary(const FilePath& filePath, ColumnFile::Type correlationType) const
+{
+    assert(correlationType == ColumnFile::Type::Float32 || correlationType == ColumnFile::Type::Float64);
+    const auto column = [this](auto member) {
+        std::vector<std::decay_t<decltype(m_rows.front().*member)>> result;
+        result.reserve(m_rows.size());
+        for (const auto& row : m_rows) {
+            result.push_back(row.*member);
+        }
+        return result;
+    };
+
+    ColumnFileWriter writer;
+    writer.add("symbol", column(&Row::symbol));
+    writer.add("name", column(&Row::name));
+    writer.add("category", column(&Row::category));
+    writer.add("dividendYield", column(&Row::dividendYield));
+    writer.add("expenseRatio", column(&Row::expenseRatio));
+    writer.add("percentFromAth", column(&Row::percentFromAth));
+    writer.add("percentToAth", column(&Row::percentToAth));
+    const auto historySize = column(&Row::historySize);
+    writer.add("historySize", std::vector<std::uint64_t> { historySize.begin(), historySize.end() });
+    writer.add("return30days", column(&Row::return30days));
+    writer.add("return365days", column(&Row::return365days));
+    writer.add("avgReturn", column(&Row::avgReturn));
+    writer.add("avgRisk", column(&Row::avgRisk));
+
+    const auto riskNames = RiskStats::names();
+    std::vector<std::vector<double>> risk(riskNames.size(), std::vector<double>(m_rows.size()));
+    for (std::size_t i = 0; i < m_rows.size(); ++i) {
+        const auto values = m_rows[i].risk.values();
+        for (std::size_t j = 0; j < values.size(); ++j) {
+            risk[j][i] = values[j];
+        }
+    }
+    for (std::size_t j = 0; j < riskNames.size(); ++j) {
+        writer.add(riskNames[j], risk[j]);
+    }
+
+    for (std::size_t tag = 0; tag < numTags; ++tag) {
+        std::vector<bool> bits(m_rows.size());
+        for (std::size_t i = 0; i < m_rows.size(); ++i) {
+            bits[i] = m_rows[i].tags[tag];
+        }
+        writer.add("is-" + EnumUtils::to_string(static_cast<AssetClass>(tag)), bits);
+    }
+
+    writer.add("etfs", m_etfs);
+    if (correlationType == ColumnFile::Type::Float64) {
+        writer.add("pearson", m_pearson.data(), m_etfs.size());
+        writer.add("spearman", m_spearman.data(), m_etfs.size());
+    } else {
+        writer.add("pearson", toFloat(m_pearson), m_etfs.size());
+        writer.add("spearman", toFloat(m_spearman), m_etfs.size());
+    }
+    return writer.save(filePath);
+}
+
+MarketInfo MarketInfo::load(const FilePath& filePath)
+{
+    MarketInfo result;
+    const ColumnFile file { filePath };
+    if (!file.isOpen()) {
+        return result;
+    }
+
+    const auto symbols = file.strings("symbol");
+    const auto names = file.strings("name");
+    const auto categories = file.strings("category");
+    const auto historySize = file.uint64("historySize");
+    const auto dividendYield = file.float64("dividendYield");
+    const auto expenseRatio = file.float64("expenseRatio");
+    const auto percentFromAth = file.float64("percentFromAth");
+    const auto percentToAth = file.float64("percentToAth");
+    const auto return30days = file.float64("return30days");
+    const auto return365days = file.float64("return365days");
+    const auto avgReturn = file.float64("avgReturn");
+    const auto avgRisk = file.float64("avgRisk");
+
+    const std::size_t size = symbols.size();
+    for (const std::size_t columnSize : { names.size(), categories.size(), historySize.size(), dividendYield.size(), expenseRatio.size(),
+             percentFromAth.size(), percentToAth.size(), return30days.size(), return365days.size(), avgReturn.size(), avgRisk.size() }) {
+        if (columnSize != size) {
+            std::cerr << "MarketInfo::load [column size mismatch] " << filePath << "\n";
+            return result;
+        }
+    }
+
+    result.m_rows.resize(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        auto& row = result.m_rows[i];
+        row.symbol = symbols[i];
+        row.name = names[i];
+        row.category = categories[i];
+        row.dividendYield = dividendYield[i];
+        row.expenseRatio = expenseRatio[i];
+        row.percentFromAth = percentFromAth[i];
+        row.percentToAth = percentToAth[i];
+        row.historySize = historySize[i];
+        row.return30days = return30days[i];
+        row.return365days = return365days[i];
+        row.avgReturn = avgReturn[i];
+        row.avgRisk = avgRisk[i];
+    }
+
+    // risk columns, missing in files written before they were added
+    const auto riskNames = RiskStats::names();
+    std::vector<std::span<const double>> risk;
+    for (const auto& name : riskNames) {
+        const auto* column = file.find(name);
+        risk.push_back(column != nullptr ? file.float64(name) : std::span<const double> {});
+    }
+    if (std::all_of(risk.begin(), risk.end(), [size](const auto& values) { return values.size() == size; })) {
+        std::vector<double> values(riskNames.size());
+        for (std::size_t i = 0; i < size; ++i) {
+            for (std::size_t j = 0; j < values.size(); ++j) {
+                values[j] = risk[j][i];
+            }
+            result.m_rows[i].risk = RiskStats::fromValues(values);
+        }
+    } else if (!risk.front().empty()) {
+        std::cerr << "MarketInfo::load [risk size mismatch] " << filePath << "\n";
+    }
+    for (std::size_t tag = 0; tag < numTags; ++tag) {
+        const auto bits = file.bitmap("is-" + EnumUtils::to_string(static_cast<AssetClass>(tag)));
+        for (std::size_t i = 0; i < bits.size() && i < size; ++i) {
+            result.m_rows[i].tags[tag] = bits[i];
+        }
+    }
+
+    for (const auto etf : file.strings("etfs")) {
+        result.m_etfs.emplace_back(etf);
+    }
+    result.m_pearson = Matrix(size, result.m_etfs.size());
+    result.m_spearman = Matrix(size, result.m_etfs.size());
+    const auto loadMatrix = [&](const std::string& name, Matrix& matrix) {
+        const auto copy = [&](auto values) {
+            if (values.size() != matrix.data().size()) {
+                return false;
+            }
+            std::copy(values.begin(), values.end(), matrix.row(0));
+            return true;
+        };
+        const auto* column = file.find(name);
+        return column != nullptr && (column->type == ColumnFile::Type::Float64 ? copy(file.float64(name)) : copy(file.float32(name)));
+    };
+    if (!loadMatrix("pearson", result.m_pearson) || !loadMatrix("spearman", result.m_spearman)) {
+        std::cerr << "MarketInfo::load [correlation size mismatch] " << filePath << "\n";
+    }
+    return result;
+}
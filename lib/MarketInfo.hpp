@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#pragma once
+
+#include "AssetEnums.hpp"
+#include "ColumnFile.hpp"
+#include "FilePath.hpp"
+#include "Matrix.hpp"
+#include "RiskMetrics.hpp"
+
+#include <bitset>
+#include <string>
+#include <vector>
+
+namespace portopt {
+
+class Market;
+
+// Summary of every asset of a Market and the correlations with every ETF, computed once and saved as CSV or binary
+class MarketInfo {
+public:
+    using Tags = std::bitset<static_cast<std::size_t>(AssetClass::LastTag)>;
+
+    struct Row {
+        std::string symbol;
+        std::string name;
+        std::string category; // category and sector
+        double dividendYield {};
+        double expenseRatio {};
+        double percentFromAth {};
+        double percentToAth {};
+        std::size_t historySize {};
+        double return30days {};
+        double return365days {};
+        double avgReturn {};
+        double avgRisk {};
+        RiskStats risk; // of the daily closes, columns named by RiskStats::names()
+        Tags tags;
+    };
+
+    // Rows of one shard (a contiguous range of the symbols) computed in parallel, every shard has all the ETF columns
+    explicit MarketInfo(const Market& market, std::size_t shard = 0, std::size_t numShards = 1);
+    static MarketInfo load(const FilePath& filePath); // file written by saveBinary, empty if it can't be read
+    static MarketInfo merge(const std::vector<MarketInfo>& shards); // shards in order, empty if their ETFs differ or their rows overlap
+
+    [[nodiscard]] const std::vector<Row>& rows() const noexcept { return m_rows; }
+    [[nodiscard]] const std::vector<std::string>& etfs() const noexcept { return m_etfs; } // correlation columns
+    [[nodiscard]] const Matrix& pearson() const noexcept { return m_pearson; } // rows x etfs
+    [[nodiscard]] const Matrix& spearman() const noexcept { return m_spearman; } // rows x etfs
+
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+    [[nodiscard]] std::size_t index(const std::string& symbol) const; // row of a symbol or npos
+
+    void saveCsv(const FilePath& filePath) const; // same layout as Market::saveMarketInfo
+    // ColumnFile with correlation matrices and tag bitmaps, shards keep Float64 correlations so merging them is exact
+    bool saveBinary(const FilePath& filePath, ColumnFile::Type correlationType = ColumnFile::Type::Float32) const;
+
+private:
+    MarketInfo() = default;
+
+    std::vector<Row> m_rows; // ordered by symbol
+    std::vector<std::string> m_etfs;
+    Matrix m_pearson;
+    Matrix m_spearman;
+};
+
+} // namespace portopt
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "Matrix.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+
+using namespace portopt;
+
+namespace {
+
+constexpr std::size_t blockSize = 64; // 64 x 64 doubles = 32 KiB per tile
+
+} // anonymous namespace
+
+Matrix::Matrix(std::size_t rows, std::size_t cols, double value)
+    : m_rows { rows }
+    , m_cols { cols }
+    , m_data(rows * cols, value)
+{
+}
+
+Matrix Matrix::transposed() const
+{
+    Matrix result { m_cols, m_rows };
+    for (std::size_t r0 = 0; r0 < m_rows; r0 += blockSize) {
+        for (std::size_t c0 = 0; c0 < m_cols; c0 += blockSize) {
+            const std::size_t r1 = std::min(r0 + blockSize, m_rows);
+            const std::size_t c1 = std::min(c0 + blockSize, m_cols);
+            for (std::size_t r = r0; r < r1; ++r) {
+                for (std::size_t c = c0; c < c1; ++c) {
+                    result(c, r) = (*this)(r, c);
+                }
+            }
+        }
+    }
+    return result;
+}
+
+std::vector<double> Matrix::multiply(const std::vector<double>& vector) const
+{
+    assert(vector.size() == m_cols);
+    std::vector<double> result(m_rows);
+    for (std::size_t r = 0; r < m_rows; ++r) {
+        const double* rowPtr = row(r);
+        double sum {};
+        for (std::size_t c = 0; c < m_cols; ++c) {
+            sum += rowPtr[c] * vector[c];
+        }
+        result[r] = sum;
+    }
+    return result;
+}
+
+Matrix Matrix::multiply(const Matrix& a, const Matrix& b)
+{
+    assert(a.cols() == b.rows());
+    Matrix result { a.rows(), b.cols() };
+    const std::size_t numBlocks = (a.rows() + blockSize - 1) / blockSize;
+
+    // each thread owns a band of result rows, tiles over k and j keep b's tile in cache
+    Utils::parallelFor(numBlocks, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t block = begin; block < end; ++block) {
+            const std::size_t i0 = block * blockSize;
+            const std::size_t i1 = std::min(i0 + blockSize, a.rows());
+            for (std::size_t k0 = 0; k0 < a.cols(); k0 += blockSize) {
+                const std::size_t k1 = std::min(k0 + blockSize, a.cols());
+                for (std::size_t j0 = 0; j0 < b.cols(); j0 += blockSize) {
+                    const std::size_t j1 = std::min(j0 + blockSize, b.cols());
+                    for (std::size_t i = i0; i < i1; ++i) {
+                        double* out = result.row(i);
+                        for (std::size_t k = k0; k < k1; ++k) {
+                            const double aik = a(i, k);
+                            const double* bRow = b.row(k);
+                            for (std::size_t j = j0; j < j1; ++j) {
+                                out[j] += aik * bRow[j];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    });
+    return result;
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#pragma once
+
+#include <cassert>
+#include <vector>
+
+namespace portopt {
+
+// Dense row-major matrix of doubles stored in one contiguous buffer
+class Matrix {
+public:
+    Matrix() = default;
+    Matrix(std::size_t rows, std::size_t cols, double value = 0);
+
+    [[nodiscard]] std::size_t rows() const noexcept { return m_rows; }
+    [[nodiscard]] std::size_t cols() const noexcept { return m_cols; }
+    [[nodiscard]] bool empty() const noexcept { return m_data.empty(); }
+
+    [[nodiscard]] double& operator()(std::size_t r, std::size_t c) noexcept
+    {
+        assert(r < m_rows && c < m_cols);
+        return m_data[(r * m_cols) + c];
+    }
+    [[nodiscard]] double operator()(std::size_t r, std::size_t c) const noexcept
+    {
+        assert(r < m_rows && c < m_cols);
+        return m_data[(r * m_cols) + c];
+    }
+
+    [[nodiscard]] double* row(std::size_t r) noexcept { return m_data.data() + (r * m_cols); }
+    [[nodiscard]] const double* row(std::size_t r) const noexcept { return m_data.data() + (r * m_cols); }
+    [[nodiscard]] const std::vector<double>& data() const noexcept { return m_data; }
+
+    [[nodiscard]] Matrix transposed() const;
+    [[nodiscard]] std::vector<double> multiply(const std::vector<double>& vector) const; // this * vector
+    [[nodiscard]] static Matrix multiply(const Matrix& a, const Matrix& b); // a * b, blocked and multithreaded
+
+private:
+    std::size_t m_rows {};
+    std::size_t m_cols {};
+    std::vector<double> m_data;
+};
+
+} // namespace portopt
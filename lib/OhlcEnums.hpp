@@ -32,10 +32,24 @@ enum class PriceType : std::uint8_t {
     OHLC4,
 };
 
-enum class OhlcTimeFrame : std::uint8_t {
+enum class ReturnType : std::uint8_t {
+    Simple, // (today - yesterday) / yesterday
+    Log, // log(today / yesterday)
+};
+
+enum class PriceAdjustment : std::uint8_t {
+    None, // prices as loaded
+    Splits, // earlier prices divided by the later split ratios, comparable to today's shares
+    Total, // splits, dividends and capital gains reinvested on the ex-date (total return)
+};
+
+enum class OhlcTimeFrame : std::uint8_t { // from the finest to the coarsest
+    Minute,
     Hourly,
     Daily,
     Weekly,
+    Monthly,
+    Quarterly,
 };
 
 } // namespace portopt
@@ -6,17 +6,51 @@
  */
 
 #include "OhlcList.hpp"
+#include "RangeQuery.hpp"
+#include "ReportWriter.hpp"
 #include "Utils.hpp"
 
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <cassert>
-#include <fstream>
+#include <ctime>
 #include <iostream>
+#include <mutex>
+#include <optional>
+#include <string_view>
 
 using namespace portopt;
 
+struct OhlcList::Cache {
+    std::once_flag athFlag;
+    std::vector<double> ath; // highest high in [i, size)
+    std::vector<size_t> athIndex; // most recent index of ath[i]
+
+    std::once_flag rangeFlag;
+    std::optional<RangeQuery> highs; // range maximum of high
+    std::optional<RangeQuery> lows; // range minimum of low
+
+    std::once_flag drawdownFlag;
+    std::vector<std::vector<double>> drawdowns; // drawdowns[k][i] is the largest low / peak - 1 in [i, i + 2^k)
+
+    std::once_flag adjustmentFlag;
+    std::vector<double> splitFactor; // PriceAdjustment::Splits of entry i
+    std::vector<double> totalFactor; // PriceAdjustment::Total of entry i
+
+    static constexpr auto numAdjustments = static_cast<size_t>(PriceAdjustment::Total) + 1;
+    std::array<std::once_flag, numAdjustments> adjustedFlags;
+    std::array<std::optional<OhlcList>, numAdjustments> adjusted;
+
+    static constexpr auto numTimeFrames = static_cast<size_t>(OhlcTimeFrame::Quarterly) + 1;
+    std::array<std::once_flag, numTimeFrames> resampleFlags;
+    std::array<std::optional<OhlcList>, numTimeFrames> resampled;
+};
+
 namespace {
 
-OhlcVector loadOhlcCsv(const CsvFile& csv)
+// Daily rows are forward filled to one entry per calendar day, intraday bars keep their timestamps without filling
+OhlcVector loadOhlcCsv(const CsvFile& csv, OhlcTimeFrame timeFrame, const DateRange& range)
 {
     std::cerr << "OhlcList::loadData\n";
     const auto& data = csv.data();
@@ -24,23 +58,35 @@ OhlcVector loadOhlcCsv(const CsvFile& csv)
     OhlcVector result;
     result.reserve(data.size());
 
-    const auto maxDate = Utils::toTimePoint("2024-12-13"); // TODO(faraz): parameterize
-    const auto minDate = Utils::toTimePoint("2010-01-01"); // TODO(faraz): parameterize
+    // "YYYY-MM-DD" keys, compared against the date prefix of each row before parsing it
+    const auto maxKey = Utils::to_string(range.maxDate);
+    const auto minKey = Utils::to_string(range.minDate);
+    const bool intraday = timeFrame < OhlcTimeFrame::Daily;
 
     for (auto itr = data.rbegin(); itr != data.rend(); ++itr) {
-        const Ohlc item { *itr };
-
-        if (!item.valid) {
+        if (itr->empty()) {
             continue;
         }
-        if (item.timepoint > maxDate) {
+        const std::string_view date = std::string_view { itr->at(0) }.substr(0, maxKey.size());
+        if (date > maxKey) {
             // std::cerr << "OhlcList::loadData [ignoring] " << itr->at(0) << "\n";
             continue;
         }
-        if (item.timepoint < minDate) {
+        if (date < minKey) {
             break;
         }
 
+        Ohlc item { *itr };
+
+        if (!item.valid) {
+            continue;
+        }
+        if (intraday) {
+            item.timepoint = Utils::toDateTime(itr->at(0));
+            result.push_back(item);
+            continue;
+        }
+
         // Fill missing dates with last record
         const std::chrono::duration<int, std::ratio<86400>> one_day(1);
         if (!result.empty()) {
@@ -65,24 +111,153 @@ OhlcVector loadOhlcCsv(const CsvFile& csv)
     return result;
 }
 
+// Start of the period of an intraday timepoint in UTC, intraday bars are exact instants (see Utils::toDateTime)
+TimePoint utcPeriodStart(const TimePoint& timepoint, OhlcTimeFrame timeFrame)
+{
+    using namespace std::chrono;
+    const auto day = floor<days>(timepoint);
+    const year_month_day date { day };
+    switch (timeFrame) {
+    case OhlcTimeFrame::Minute:
+        return floor<minutes>(timepoint);
+    case OhlcTimeFrame::Hourly:
+        return floor<hours>(timepoint);
+    case OhlcTimeFrame::Daily:
+        return day;
+    case OhlcTimeFrame::Weekly:
+        return day - days { (weekday { day }.c_encoding() + 6) % 7 }; // back to Monday
+    case OhlcTimeFrame::Monthly:
+        return sys_days { date.year() / date.month() / 1 };
+    case OhlcTimeFrame::Quarterly:
+        return sys_days { date.year() / month { ((static_cast<unsigned>(date.month()) - 1) / 3 * 3) + 1 } / 1 };
+    }
+    return timepoint;
+}
+
+// Start of the period of a timepoint in local time, like Utils::toTimePoint
+TimePoint periodStart(const TimePoint& timepoint, OhlcTimeFrame timeFrame)
+{
+    if (timeFrame == OhlcTimeFrame::Minute) {
+        return std::chrono::floor<std::chrono::minutes>(timepoint);
+    }
+    const auto tt = std::chrono::system_clock::to_time_t(timepoint);
+    std::tm tm {};
+    localtime_r(&tt, &tm);
+    tm.tm_sec = 0;
+    tm.tm_min = 0;
+    tm.tm_isdst = -1;
+    if (timeFrame != OhlcTimeFrame::Hourly) {
+        tm.tm_hour = 0;
+    }
+    if (timeFrame == OhlcTimeFrame::Weekly) {
+        tm.tm_mday -= (tm.tm_wday + 6) % 7; // back to Monday
+    }
+    if (timeFrame == OhlcTimeFrame::Monthly || timeFrame == OhlcTimeFrame::Quarterly) {
+        tm.tm_mday = 1;
+    }
+    if (timeFrame == OhlcTimeFrame::Quarterly) {
+        tm.tm_mon -= tm.tm_mon % 3;
+    }
+    return std::chrono::system_clock::from_time_t(std::mktime(&tm));
+}
+
+// One bar per period from the oldest entry to the most recent one: first open, highest high, lowest low, last
+// close, total volume, dividends and capital gains, and the combined split ratio
+OhlcVector resampleData(const OhlcVector& data, OhlcTimeFrame from, OhlcTimeFrame timeFrame)
+{
+    // daily entries are local midnights and keep the local calendar, intraday bars use the UTC one
+    const auto start = from < OhlcTimeFrame::Daily ? utcPeriodStart : periodStart;
+    OhlcVector result;
+    TimePoint period {};
+    for (auto itr = data.rbegin(); itr != data.rend(); ++itr) {
+        if (itr->dummy) {
+            continue;
+        }
+        const TimePoint begin = start(itr->timepoint, timeFrame);
+        if (result.empty() || begin != period) {
+            period = begin;
+            Ohlc bar { itr->open, itr->high, itr->low, itr->close, itr->volume };
+            bar.timepoint = begin;
+            bar.valid = true;
+            bar.dividends = itr->dividends;
+            bar.splits = itr->splits;
+            bar.capitalGains = itr->capitalGains;
+            result.push_back(bar);
+            continue;
+        }
+        auto& bar = result.back();
+        bar.high = std::max(bar.high, itr->high);
+        bar.low = std::min(bar.low, itr->low);
+        bar.close = itr->close;
+        bar.volume += itr->volume;
+        bar.dividends += itr->dividends;
+        bar.capitalGains += itr->capitalGains;
+        if (itr->splits != 0) { // 0 means no split
+            bar.splits = bar.splits != 0 ? bar.splits * itr->splits : itr->splits;
+        }
+    }
+    std::reverse(result.begin(), result.end()); // most recent first
+    return result;
+}
+
 } // anonymous namespace
 
 OhlcList::OhlcList(double price)
     : m_data { Ohlc { price } }
     , m_timeFrame { OhlcTimeFrame::Daily }
+    , m_cache { std::make_shared<Cache>() }
 {
 }
 
-OhlcList::OhlcList(OhlcVector data)
+OhlcList::OhlcList(OhlcVector data, OhlcTimeFrame timeFrame)
     : m_data { std::move(data) }
-    , m_timeFrame { OhlcTimeFrame::Daily }
+    , m_timeFrame { timeFrame }
+    , m_cache { std::make_shared<Cache>() }
 {
 }
 
-OhlcList::OhlcList(const CsvFile& csv, OhlcTimeFrame timeFrame)
-    : m_data { loadOhlcCsv(csv) }
+OhlcList::OhlcList(const CsvFile& csv, OhlcTimeFrame timeFrame, const DateRange& range)
+    : m_data { loadOhlcCsv(csv, timeFrame, range) }
     , m_timeFrame { timeFrame }
+    , m_cache { std::make_shared<Cache>() }
+{
+}
+
+DateRange OhlcList::defaultRange()
+{
+    static const DateRange range { Utils::toTimePoint("2010-01-01"), Utils::toTimePoint("2024-12-13") };
+    return range;
+}
+
+DateRange OhlcList::recentRange(std::size_t days)
 {
+    const auto maxDate = defaultRange().maxDate;
+    return DateRange { std::max(defaultRange().minDate, maxDate - std::chrono::days { days }), maxDate };
+}
+
+std::size_t OhlcList::barsPerYear(OhlcTimeFrame timeFrame)
+{
+    switch (timeFrame) {
+    case OhlcTimeFrame::Minute:
+        return 252 * 390; // regular sessions of 6.5 hours
+    case OhlcTimeFrame::Hourly:
+        return 252 * 7; // 9:30 to 16:00 in seven bars
+    case OhlcTimeFrame::Daily:
+        return 365;
+    case OhlcTimeFrame::Weekly:
+        return 52;
+    case OhlcTimeFrame::Monthly:
+        return 12;
+    case OhlcTimeFrame::Quarterly:
+        return 4;
+    }
+    assert(false);
+    return 365;
+}
+
+std::size_t OhlcList::tradingBarsPerYear(OhlcTimeFrame timeFrame)
+{
+    return timeFrame == OhlcTimeFrame::Daily ? 252 : barsPerYear(timeFrame);
 }
 
 size_t OhlcList::size() const noexcept
@@ -101,36 +276,35 @@ const Ohlc& OhlcList::at(size_t i) const
 
 void OhlcList::save(const FilePath& filePath) const
 {
-    std::ofstream outFile(filePath, std::ios::out | std::ios::trunc);
-    assert(outFile.is_open());
-
-    outFile << "Date,Open,High,Low,Close,Volume,Dividends,Stock Splits,dummy,";
-    outFile << "priceChange,allTimeHigh,percentFromAth,percentToAth\n";
+    ReportWriter writer { filePath };
+    assert(writer.isOpen());
 
-    outFile.setf(std::ios::fixed);
-    outFile.precision(2);
-    // outFile << std::fixed << std::setprecision(2);
+    writer << "Date,Open,High,Low,Close,Volume,Dividends,Stock Splits,dummy,";
+    writer << "priceChange,allTimeHigh,percentFromAth,percentToAth\n";
 
-    const auto ath = allTimeHigh();
+    const auto& ath = allTimeHigh();
     const auto pfAth = percentFrom(ath);
     const auto ptAth = percentTo(ath);
 
-    for (size_t i = 0; i < m_data.size(); ++i) {
+    writer.writeRows(m_data.size(), [&](ReportBuffer& row, size_t i) {
         const auto& itr = m_data.at(i);
-        outFile << Utils::to_string(itr.timepoint) << ",";
-        outFile << itr.open << ",";
-        outFile << itr.high << ",";
-        outFile << itr.low << ",";
-        outFile << itr.close << ",";
-        outFile << std::fixed << std::noshowpoint << itr.volume << ",";
-        outFile << std::noshowpoint << itr.dividends << ",";
-        outFile << std::noshowpoint << itr.splits << ",";
-        outFile << itr.dummy << ",";
-        outFile << priceChange(i) << ",";
-        outFile << ath.at(i) << ",";
-        outFile << pfAth.at(i) << ",";
-        outFile << ptAth.at(i) << "\n";
-    }
+        if (m_timeFrame < OhlcTimeFrame::Daily) {
+            row.appendDateTime(itr.timepoint);
+        } else {
+            row.appendDate(itr.timepoint);
+        }
+        for (const double value : { itr.open, itr.high, itr.low, itr.close, itr.volume, itr.dividends, itr.splits }) {
+            row.append(',');
+            row.appendFixed(value, 2);
+        }
+        row.append(',');
+        row.append(itr.dummy);
+        for (const double value : { priceChange(i), ath.at(i), pfAth.at(i), ptAth.at(i) }) {
+            row.append(',');
+            row.appendFixed(value, 2);
+        }
+        row.append('\n');
+    });
 }
 
 PriceDirection OhlcList::priceDirection(size_t i, size_t offset) const
@@ -205,27 +379,237 @@ std::vector<double> OhlcList::toVector(size_t size, size_t offset, PriceType typ
     return result;
 }
 
-double OhlcList::allTimeHigh(const size_t skip) const
+const OhlcList::Cache& OhlcList::athCache() const
+{
+    std::call_once(m_cache->athFlag, [this] {
+        auto& ath = m_cache->ath;
+        auto& athIndex = m_cache->athIndex;
+        ath.resize(m_data.size());
+        athIndex.resize(m_data.size());
+        double high {};
+        size_t highIndex {};
+        for (int64_t i = static_cast<int64_t>(m_data.size()) - 1; i >= 0; --i) {
+            if (m_data[i].high >= high) {
+                high = m_data[i].high;
+                highIndex = i;
+            }
+            ath[i] = high;
+            athIndex[i] = highIndex;
+        }
+    });
+    return *m_cache;
+}
+
+const OhlcList::Cache& OhlcList::rangeCache() const
+{
+    std::call_once(m_cache->rangeFlag, [this] {
+        std::vector<double> highs;
+        std::vector<double> lows;
+        highs.reserve(m_data.size());
+        lows.reserve(m_data.size());
+        for (const auto& item : m_data) {
+            highs.push_back(item.high);
+            lows.push_back(item.low);
+        }
+        m_cache->highs.emplace(std::move(highs), RangeQuery::Mode::Max);
+        m_cache->lows.emplace(std::move(lows), RangeQuery::Mode::Min);
+    });
+    return *m_cache;
+}
+
+const OhlcList::Cache& OhlcList::drawdownCache() const
 {
-    double result {};
-    for (size_t i = skip; i < m_data.size(); ++i) {
-        result = std::max(result, m_data[i].high);
+    std::call_once(m_cache->drawdownFlag, [this] {
+        const auto& range = rangeCache();
+        auto& table = m_cache->drawdowns;
+        const size_t n = m_data.size();
+        table.emplace_back(n);
+        for (size_t i = 0; i < n; ++i) {
+            table[0][i] = m_data[i].low / m_data[i].high - 1; // the high of a bar comes before its low
+        }
+        // [i, i + 2^k) is the recent half [i, mid) and the older half [mid, i + 2^k), a cross decline has its peak in
+        // the older half and its trough in the recent one
+        for (size_t k = 1; (size_t { 1 } << k) <= n; ++k) {
+            const size_t half = size_t { 1 } << (k - 1);
+            const auto& prev = table[k - 1];
+            std::vector<double> level(n - (2 * half) + 1);
+            for (size_t i = 0; i < level.size(); ++i) {
+                const double cross = range.lows->value(i, i + half) / range.highs->value(i + half, i + (2 * half)) - 1;
+                level[i] = std::min({ prev[i], prev[i + half], cross });
+            }
+            table.push_back(std::move(level));
+        }
+    });
+    return *m_cache;
+}
+
+const OhlcList::Cache& OhlcList::adjustmentCache() const
+{
+    std::call_once(m_cache->adjustmentFlag, [this] {
+        auto& splitFactor = m_cache->splitFactor;
+        auto& totalFactor = m_cache->totalFactor;
+        splitFactor.resize(m_data.size());
+        totalFactor.resize(m_data.size());
+        double split = 1;
+        double total = 1;
+        double eventSplit = 1; // events of the last real entry, applied from the entry before it
+        double distribution = 0;
+        for (size_t i = 0; i < m_data.size(); ++i) { // most recent to oldest
+            const Ohlc& item = m_data[i];
+            if (!item.dummy) {
+                // a distribution is a fraction of the close before the ex-date, in shares after the split
+                const double remaining = item.close > 0 ? 1 - (distribution * eventSplit / item.close) : 1;
+                if (remaining <= 0) {
+                    std::cerr << "OhlcList::adjustmentCache [invalid distribution] " << item.to_string() << "\n";
+                }
+                split /= eventSplit;
+                total *= (remaining > 0 ? remaining : 1) / eventSplit;
+                eventSplit = item.splits != 0 ? item.splits : 1; // 0 means no split
+                distribution = item.dividends + item.capitalGains;
+            }
+            splitFactor[i] = split;
+            totalFactor[i] = total;
+        }
+    });
+    return *m_cache;
+}
+
+double OhlcList::adjustmentFactor(size_t i, PriceAdjustment adjustment) const
+{
+    assert(i < m_data.size());
+    switch (adjustment) {
+    case PriceAdjustment::None:
+        return 1;
+    case PriceAdjustment::Splits:
+        return adjustmentCache().splitFactor[i];
+    case PriceAdjustment::Total:
+        return adjustmentCache().totalFactor[i];
+    }
+    assert(false);
+    return 1;
+}
+
+double OhlcList::adjustedPrice(size_t i, PriceType type, PriceAdjustment adjustment) const
+{
+    return m_data.at(i).get(type) * adjustmentFactor(i, adjustment);
+}
+
+std::vector<double> OhlcList::totalReturnIndex() const
+{
+    assert(!m_data.empty());
+    const auto& factors = adjustmentCache().totalFactor;
+    const double base = m_data.back().close * factors.back();
+    assert(base > 0);
+    std::vector<double> result(m_data.size());
+    for (size_t i = 0; i < m_data.size(); ++i) {
+        result[i] = m_data[i].close * factors[i] / base;
     }
     return result;
 }
 
-std::vector<double> OhlcList::allTimeHigh() const
+const OhlcList& OhlcList::adjusted(PriceAdjustment adjustment) const
+{
+    if (adjustment == PriceAdjustment::None) {
+        return *this;
+    }
+    const auto index = static_cast<size_t>(adjustment);
+    std::call_once(m_cache->adjustedFlags[index], [&] {
+        const auto& cache = adjustmentCache();
+        const auto& factors = adjustment == PriceAdjustment::Splits ? cache.splitFactor : cache.totalFactor;
+        OhlcVector data = m_data;
+        for (size_t i = 0; i < data.size(); ++i) {
+            auto& item = data[i];
+            item.open *= factors[i];
+            item.high *= factors[i];
+            item.low *= factors[i];
+            item.close *= factors[i];
+            item.volume /= cache.splitFactor[i];
+            item.dividends = 0;
+            item.splits = 0;
+            item.capitalGains = 0;
+        }
+        m_cache->adjusted[index].emplace(std::move(data), m_timeFrame);
+    });
+    return *m_cache->adjusted[index];
+}
+
+std::vector<double> OhlcList::returns(size_t offset, PriceType type) const
 {
-    double ath {};
+    if (offset >= m_data.size()) {
+        return {};
+    }
     std::vector<double> result;
-    result.resize(m_data.size());
-    for (int64_t i = static_cast<int64_t>(m_data.size()) - 1; i >= 0; --i) {
-        ath = std::max(ath, m_data[i].high);
-        result[i] = ath;
+    result.reserve(m_data.size() - offset);
+    for (size_t i = 0; i + offset < m_data.size(); ++i) {
+        if (offset == 0) { // Same day case
+            result.push_back(priceChange(i));
+            continue;
+        }
+        const auto today = m_data[i].get(type);
+        const auto yesterday = m_data[i + offset].get(type);
+        assert(yesterday > 0);
+        result.push_back((today - yesterday) / yesterday);
     }
     return result;
 }
 
+double OhlcList::allTimeHigh(const size_t skip) const
+{
+    if (skip >= m_data.size()) {
+        return 0;
+    }
+    return athCache().ath[skip];
+}
+
+const std::vector<double>& OhlcList::allTimeHigh() const
+{
+    return athCache().ath;
+}
+
+double OhlcList::highestHigh(size_t begin, size_t end) const
+{
+    end = std::min(end, m_data.size());
+    assert(begin < end);
+    return rangeCache().highs->value(begin, end);
+}
+
+double OhlcList::lowestLow(size_t begin, size_t end) const
+{
+    end = std::min(end, m_data.size());
+    assert(begin < end);
+    return rangeCache().lows->value(begin, end);
+}
+
+double OhlcList::drawdown(const size_t i, const size_t window) const
+{
+    const double lastPrice = m_data.at(i).low;
+    const double high = highestHigh(i, i + std::max<size_t>(window, 1));
+    assert(high > 0);
+    return (lastPrice - high) / high * 100;
+}
+
+size_t OhlcList::timeUnderWater(const size_t i) const
+{
+    assert(i < m_data.size());
+    return athCache().athIndex[i] - i;
+}
+
+double OhlcList::maxDrawdown(size_t begin, size_t end) const
+{
+    end = std::min(end, m_data.size());
+    assert(begin < end);
+    const auto& cache = drawdownCache();
+    // two overlapping blocks [begin, begin + 2^k) and [end - 2^k, end), the declines across them have their trough
+    // in the recent part of the first block and their peak in the older part of the second one
+    const size_t k = std::bit_width(end - begin) - 1;
+    const size_t block = size_t { 1 } << k;
+    double result = std::min(cache.drawdowns[k][begin], cache.drawdowns[k][end - block]);
+    if (begin + block < end) {
+        result = std::min(result, lowestLow(begin, end - block) / highestHigh(begin + block, end) - 1);
+    }
+    return std::min(0.0, result) * 100;
+}
+
 double OhlcList::percentFromAth(const size_t i) const
 {
     const double lastPrice = m_data.at(i).low;
@@ -268,33 +652,35 @@ std::vector<double> OhlcList::percentTo(const std::vector<double>& ath) const
     return result;
 }
 
+const OhlcList& OhlcList::resample(OhlcTimeFrame timeFrame) const
+{
+    if (timeFrame == m_timeFrame) {
+        return *this;
+    }
+    const auto index = static_cast<size_t>(timeFrame);
+    std::call_once(m_cache->resampleFlags[index], [&] {
+        if (timeFrame < m_timeFrame) { // bars can't be split into finer ones
+            std::cerr << "OhlcList::resample [finer time frame] " << static_cast<int>(timeFrame) << " < " << static_cast<int>(m_timeFrame) << "\n";
+            m_cache->resampled[index].emplace(OhlcVector {}, timeFrame);
+        } else {
+            m_cache->resampled[index].emplace(resampleData(m_data, m_timeFrame, timeFrame), timeFrame);
+        }
+    });
+    return *m_cache->resampled[index];
+}
+
 double OhlcList::avgReturn(size_t length) const
 {
     assert(!m_data.empty());
     length = std::min(length, m_data.size() - 1);
-
-    double result {};
-    const size_t size = m_data.size() - length;
-    for (size_t i = 0; i < size; ++i) {
-        result += priceChange(i, length, PriceType::HL2);
-    }
-    return result / static_cast<double>(size);
+    return Utils::mean(returns(length, PriceType::HL2));
 }
 
 double OhlcList::avgRisk(size_t length) const
 {
     assert(!m_data.empty());
     length = std::min(length, m_data.size() - 1);
-
-    const size_t size = m_data.size() - length;
-    std::vector<double> vector;
-    vector.reserve(size);
-
-    for (size_t i = 0; i < size; ++i) {
-        vector.push_back(priceChange(i, length, PriceType::HL2));
-    }
-
-    return Utils::stdDev(vector);
+    return Utils::stdDev(returns(length, PriceType::HL2));
 }
 
 bool OhlcList::matchTimePoint(const OhlcList& other, size_t maxSize) const
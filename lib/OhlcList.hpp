@@ -10,6 +10,8 @@
 #include "CsvFile.hpp"
 #include "Ohlc.hpp"
 
+#include <memory>
+
 namespace portopt {
 
 using OhlcVector = std::vector<Ohlc>;
@@ -18,18 +20,41 @@ using OhlcVector = std::vector<Ohlc>;
 class OhlcList {
 public:
     explicit OhlcList(double price);
-    explicit OhlcList(OhlcVector data);
-    OhlcList(const CsvFile& csv, OhlcTimeFrame timeFrame);
+    explicit OhlcList(OhlcVector data, OhlcTimeFrame timeFrame = OhlcTimeFrame::Daily);
+    OhlcList(const CsvFile& csv, OhlcTimeFrame timeFrame, const DateRange& range = defaultRange());
+
+    [[nodiscard]] static DateRange defaultRange(); // load window used when none is given
+    [[nodiscard]] static DateRange recentRange(std::size_t days); // the most recent days of defaultRange()
+    [[nodiscard]] static std::size_t barsPerYear(OhlcTimeFrame timeFrame); // 365 forward filled days, 52 weeks, 12 months, trading hours and minutes
+    [[nodiscard]] static std::size_t tradingBarsPerYear(OhlcTimeFrame timeFrame); // same without the forward filled days, 252 days
 
     void save(const FilePath& filePath) const; // save to CSV file
     [[nodiscard]] size_t size() const noexcept; // number of OHLC entries
     [[nodiscard]] const Ohlc& at(size_t i) const; // first elemet (data[0]) is the most recent
+    [[nodiscard]] OhlcTimeFrame timeFrame() const noexcept { return m_timeFrame; }
+
+    // Bars of a coarser time frame built in one pass and cached, the list itself for its own time frame. Dummy
+    // entries are skipped, each bar is dated by the start of its period (local midnight of the day, Monday, first
+    // day of the month or quarter, in UTC for intraday lists) so the bars of different assets line up. A finer
+    // time frame gives an empty list.
+    [[nodiscard]] const OhlcList& resample(OhlcTimeFrame timeFrame) const;
+
+    // Cumulative factors built in one pass from the splits, dividends and capital gains of the list: 1 for the most
+    // recent entry, adjusted price = price * factor. Forward filled dummies share the factor of the entry they copy.
+    [[nodiscard]] double adjustmentFactor(size_t i, PriceAdjustment adjustment) const;
+    [[nodiscard]] double adjustedPrice(size_t i, PriceType type, PriceAdjustment adjustment) const;
+    [[nodiscard]] std::vector<double> totalReturnIndex() const; // growth of 1 from the oldest close with distributions reinvested
+
+    // Cached copy with adjusted prices (volume in today's shares) and the events folded in, the list itself for
+    // None. Analytics that work on whole lists (returns, resample) switch series through it.
+    [[nodiscard]] const OhlcList& adjusted(PriceAdjustment adjustment) const;
 
     [[nodiscard]] PriceDirection priceDirection(size_t i, size_t offset) const;
     [[nodiscard]] double priceChange(size_t i) const;
     [[nodiscard]] double priceChange(size_t i, size_t offset, PriceType type) const;
 
     [[nodiscard]] std::vector<double> toVector(size_t size, size_t offset, PriceType type) const;
+    [[nodiscard]] std::vector<double> returns(size_t offset, PriceType type) const; // priceChange(i, offset, type) for every i with offset entries of history
     [[nodiscard]] std::vector<double> sma(size_t length, PriceType type) const; // Simple Moving Average
     [[nodiscard]] std::vector<double> wma(size_t length, PriceType type) const; // Weighted Moving Average
     [[nodiscard]] std::vector<double> ema(size_t length, PriceType type) const; // Exponential Moving Average
@@ -41,8 +66,14 @@ public:
     // williamsR
     // RSI
 
-    [[nodiscard]] double allTimeHigh(size_t skip) const;
-    [[nodiscard]] std::vector<double> allTimeHigh() const;
+    [[nodiscard]] double allTimeHigh(size_t skip) const; // highest high in [skip, size)
+    [[nodiscard]] const std::vector<double>& allTimeHigh() const; // cached allTimeHigh(i) for every i
+
+    [[nodiscard]] double highestHigh(size_t begin, size_t end) const; // highest high in [begin, end)
+    [[nodiscard]] double lowestLow(size_t begin, size_t end) const; // lowest low in [begin, end)
+    [[nodiscard]] double drawdown(size_t i, size_t window) const; // percent of low(i) from the highest high in [i, i + window)
+    [[nodiscard]] size_t timeUnderWater(size_t i) const; // number of entries between i and its all time high
+    [[nodiscard]] double maxDrawdown(size_t begin, size_t end) const; // largest peak to trough decline in [begin, end) in percent, O(1)
 
     [[nodiscard]] double percentFromAth(size_t i) const;
     [[nodiscard]] std::vector<double> percentFrom(const std::vector<double>& ath) const;
@@ -55,8 +86,16 @@ public:
     [[nodiscard]] bool matchTimePoint(const OhlcList& other, size_t maxSize) const;
 
 private:
+    struct Cache; // lazily computed columns, shared between copies of the list
+
+    [[nodiscard]] const Cache& athCache() const;
+    [[nodiscard]] const Cache& rangeCache() const;
+    [[nodiscard]] const Cache& drawdownCache() const;
+    [[nodiscard]] const Cache& adjustmentCache() const;
+
     const OhlcVector m_data;
     const OhlcTimeFrame m_timeFrame;
+    const std::shared_ptr<Cache> m_cache;
 };
 
 } // namespace portopt
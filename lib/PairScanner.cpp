@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "PairScanner.hpp"
+#include "AssetRatio.hpp"
+#include "Market.hpp"
+#include "ReportWriter.hpp"
+#include "SimilarityIndex.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <tuple>
+
+using namespace portopt;
+
+std::vector<PairCandidate> PairScanner::scan(const Market& market, const std::vector<std::string>& symbols, std::size_t length, double minCorrelation,
+    PriceType priceType, std::size_t adfLags)
+{
+    // daily log returns of the last length prices, aligned on the first usable asset
+    std::vector<const Asset*> assets;
+    std::vector<std::string> indexed;
+    std::vector<std::vector<double>> series;
+    for (const auto& symbol : symbols) {
+        const auto& asset = market.get(symbol);
+        if (length < 2 || asset.ohlc().size() < length || (!assets.empty() && !assets.front()->ohlc().matchTimePoint(asset.ohlc(), length))) {
+            continue;
+        }
+        auto& returns = series.emplace_back(length - 1);
+        for (std::size_t i = 0; i + 1 < length; ++i) {
+            returns[i] = std::log(asset.ohlc().at(i).get(priceType) / asset.ohlc().at(i + 1).get(priceType));
+        }
+        assets.push_back(&asset);
+        indexed.push_back(symbol);
+    }
+    if (assets.size() < 2) {
+        return {};
+    }
+
+    const SimilarityIndex index { indexed, series };
+    const auto pairs = index.pairsAbove(minCorrelation);
+    std::cerr << "PairScanner::scan [assets] " << assets.size() << " [candidates] " << pairs.size() << "\n";
+
+    std::vector<PairCandidate> result(pairs.size());
+    Utils::parallelFor(pairs.size(), [&](std::size_t begin, std::size_t end) {
+        for (std::size_t p = begin; p < end; ++p) {
+            const auto& pair = pairs[p];
+            const AssetRatio forward { *assets[pair.first], *assets[pair.second] };
+            const AssetRatio backward { *assets[pair.second], *assets[pair.first] };
+            const auto test1 = forward.cointegration(length, priceType, adfLags);
+            const auto test2 = backward.cointegration(length, priceType, adfLags);
+            const bool first = test1.adfStatistic <= test2.adfStatistic;
+            result[p] = { first ? indexed[pair.first] : indexed[pair.second], first ? indexed[pair.second] : indexed[pair.first],
+                pair.correlation, first ? test1 : test2 };
+        }
+    });
+
+    std::sort(result.begin(), result.end(), [](const PairCandidate& a, const PairCandidate& b) {
+        return a.test.adfStatistic != b.test.adfStatistic ? a.test.adfStatistic < b.test.adfStatistic : std::tie(a.first, a.second) < std::tie(b.first, b.second);
+    });
+    return result;
+}
+
+void PairScanner::save(const std::vector<PairCandidate>& candidates, const FilePath& filePath)
+{
+    ReportWriter writer { filePath };
+    if (!writer.isOpen()) {
+        return;
+    }
+    writer << "first,second,correlation,beta,alpha,adfStatistic,criticalValue,cointegrated,halfLife\n";
+    writer.writeRows(candidates.size(), [&](ReportBuffer& buffer, std::size_t i) {
+        const auto& candidate = candidates[i];
+        buffer.append(candidate.first);
+        buffer.append(',');
+        buffer.append(candidate.second);
+        for (const double value : { candidate.correlation, candidate.test.beta, candidate.test.alpha, candidate.test.adfStatistic, candidate.test.criticalValue }) {
+            buffer.append(',');
+            buffer.append(value);
+        }
+        buffer.append(',');
+        buffer.append(candidate.test.cointegrated());
+        buffer.append(',');
+        buffer.append(candidate.test.halfLife);
+        buffer.append('\n');
+    });
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#pragma once
+
+#include "Cointegration.hpp"
+#include "FilePath.hpp"
+#include "OhlcEnums.hpp"
+
+#include <string>
+#include <vector>
+
+namespace portopt {
+
+class Market;
+
+struct PairCandidate {
+    std::string first; // dependent asset of the test
+    std::string second;
+    double correlation {}; // of daily log returns
+    CointegrationTest test;
+};
+
+namespace PairScanner {
+
+    /**
+     * @brief scan Engle-Granger test of every pair of symbols whose daily returns are correlated enough
+     * @param market loaded assets
+     * @param symbols assets to pair, those with less than length entries or misaligned dates are skipped
+     * @param length number of prices used for each test
+     * @param minCorrelation pairs below it are rejected by a SimilarityIndex before any regression
+     * @return candidates that passed the correlation screen, most negative ADF statistic (strongest) first
+     *
+     * Both assets are tried as the dependent variable and the stronger test is kept. Pairs are tested in parallel.
+     */
+    std::vector<PairCandidate> scan(const Market& market, const std::vector<std::string>& symbols, std::size_t length, double minCorrelation,
+        PriceType priceType = PriceType::Close, std::size_t adfLags = 1);
+
+    void save(const std::vector<PairCandidate>& candidates, const FilePath& filePath);
+
+} // namespace PairScanner
+} // namespace portopt
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "PatternSearch.hpp"
+#include "Market.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iterator>
+#include <numeric>
+#include <tuple>
+
+using namespace portopt;
+
+PatternSearch::PatternSearch(std::vector<double> query, PriceType priceType, std::size_t exclusionZone)
+    : m_query { std::move(query) }
+    , m_priceType { priceType }
+    , m_exclusionZone { exclusionZone == npos ? m_query.size() / 2 : exclusionZone }
+{
+    assert(m_query.size() > 1);
+    const double mean = Utils::mean(m_query);
+    double sumSq {};
+    for (const double value : m_query) {
+        sumSq += (value - mean) * (value - mean);
+    }
+    const double stdDev = std::sqrt(sumSq / static_cast<double>(m_query.size()));
+    m_constant = stdDev <= 1e-12 * std::abs(mean) || stdDev == 0;
+    for (auto& value : m_query) {
+        value = m_constant ? 0 : (value - mean) / stdDev;
+    }
+}
+
+std::vector<double> PatternSearch::distanceProfile(std::span<const double> series) const
+{
+    Plans plans;
+    return distanceProfile(series, plans);
+}
+
+std::vector<double> PatternSearch::distanceProfile(std::span<const double> series, Plans& plans) const
+{
+    const std::size_t m = length();
+    const std::size_t n = series.size();
+    if (n < m) {
+        return {};
+    }
+
+    // prefix sums of the demeaned series for the mean and deviation of every window
+    const double mean = std::accumulate(series.begin(), series.end(), 0.0) / static_cast<double>(n);
+    std::vector<double> sum(n + 1);
+    std::vector<double> sumSq(n + 1);
+    for (std::size_t t = 0; t < n; ++t) {
+        const double value = series[t] - mean;
+        sum[t + 1] = sum[t] + value;
+        sumSq[t + 1] = sumSq[t] + (value * value);
+    }
+    const double tolerance = 1e-10 * (sumSq[n] / static_cast<double>(n)); // variance of a flat window, relative to the series
+
+    // sliding dot products of the query with every window, the query sums to 0 so the series mean doesn't matter
+    std::vector<Fft::Complex> products;
+    if (!m_constant) {
+        const std::size_t size = Fft::paddedSize(n); // windows end inside the series, no wrap around
+        auto itr = plans.find(size);
+        if (itr == plans.end()) {
+            Plan plan { Fft { size }, std::vector<Fft::Complex>(size) };
+            std::copy(m_query.begin(), m_query.end(), plan.query.begin());
+            plan.fft.transform(plan.query, false);
+            for (auto& value : plan.query) {
+                value = std::conj(value);
+            }
+            itr = plans.emplace(size, std::move(plan)).first;
+        }
+        const auto& [fft, query] = itr->second;
+        products.resize(size);
+        for (std::size_t t = 0; t < n; ++t) {
+            products[t] = series[t] - mean;
+        }
+        fft.transform(products, false);
+        for (std::size_t k = 0; k < size; ++k) {
+            products[k] *= query[k];
+        }
+        fft.transform(products, true);
+    }
+
+    // flat windows are at sqrt(length) from any shape
+    const auto md = static_cast<double>(m);
+    std::vector<double> result(n - m + 1);
+    for (std::size_t i = 0; i < result.size(); ++i) {
+        const double windowMean = (sum[i + m] - sum[i]) / md;
+        const double variance = ((sumSq[i + m] - sumSq[i]) / md) - (windowMean * windowMean);
+        if (variance <= tolerance || m_constant) {
+            result[i] = variance <= tolerance && m_constant ? 0 : std::sqrt(md);
+            continue;
+        }
+        const double correlation = std::clamp(products[i].real() / (md * std::sqrt(variance)), -1.0, 1.0);
+        result[i] = std::sqrt(2 * md * (1 - correlation));
+    }
+    return result;
+}
+
+std::vector<PatternSearch::Match> PatternSearch::search(const Asset& asset, std::size_t k, std::size_t minOffset) const
+{
+    Plans plans;
+    return search(asset, k, minOffset, plans);
+}
+
+std::vector<PatternSearch::Match> PatternSearch::search(const Asset& asset, std::size_t k, std::size_t minOffset, Plans& plans) const
+{
+    const auto& ohlc = asset.ohlc();
+    if (ohlc.size() < minOffset + length()) {
+        return {};
+    }
+    const auto profile = distanceProfile(ohlc.toVector(ohlc.size(), 0, m_priceType), plans);
+
+    std::vector<std::size_t> order(profile.size() - minOffset);
+    std::iota(order.begin(), order.end(), minOffset);
+    std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return profile[a] != profile[b] ? profile[a] < profile[b] : a < b; });
+
+    // closest windows first, skipping the ones near an earlier match
+    std::vector<Match> result;
+    for (const std::size_t offset : order) {
+        if (result.size() >= k) {
+            break;
+        }
+        const bool near = std::any_of(result.begin(), result.end(), [&](const Match& match) {
+            return (offset > match.offset ? offset - match.offset : match.offset - offset) <= m_exclusionZone;
+        });
+        if (!near) {
+            result.push_back({ asset.symbol(), offset, profile[offset] });
+        }
+    }
+    return result;
+}
+
+std::vector<PatternSearch::Match> PatternSearch::search(const Market& market, std::size_t k, std::size_t minOffset) const
+{
+    std::vector<const Asset*> assets;
+    for (const auto& [symbol, asset] : market.assets()) {
+        assets.push_back(&asset);
+    }
+
+    std::vector<std::vector<Match>> found(assets.size());
+    Utils::parallelFor(assets.size(), [&](std::size_t begin, std::size_t end) {
+        Plans plans;
+        for (std::size_t i = begin; i < end; ++i) {
+            found[i] = search(*assets[i], k, minOffset, plans);
+        }
+    });
+
+    std::vector<Match> result;
+    for (auto& matches : found) {
+        std::move(matches.begin(), matches.end(), std::back_inserter(result));
+    }
+    std::sort(result.begin(), result.end(), [](const Match& a, const Match& b) {
+        return std::tie(a.distance, a.symbol, a.offset) < std::tie(b.distance, b.symbol, b.offset);
+    });
+    result.resize(std::min(result.size(), k));
+    return result;
+}
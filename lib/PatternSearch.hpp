@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#pragma once
+
+#include "Fft.hpp"
+#include "OhlcEnums.hpp"
+
+#include <map>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace portopt {
+
+class Asset;
+class Market;
+
+// Historical windows most similar in shape to a query, by z-normalized Euclidean distance
+//
+// Distances to every window of a history come from one MASS distance profile: the sliding dot products with the
+// query from an FFT in O(n log n) and the window means and deviations from prefix sums.
+class PatternSearch {
+public:
+    struct Match {
+        std::string symbol;
+        std::size_t offset {}; // OhlcList index of the most recent entry of the window
+        double distance {}; // 0 for the same shape, sqrt(2 * length) for the opposite one
+    };
+
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    /**
+     * @brief PatternSearch Constructor
+     * @param query prices most recent first, e.g. ohlc.toVector(60, 0, priceType) for the last 60 days of an asset
+     * @param priceType price of the histories searched
+     * @param exclusionZone matches in one history are more than this many entries apart, npos for half the query
+     */
+    PatternSearch(std::vector<double> query, PriceType priceType, std::size_t exclusionZone = npos);
+
+    [[nodiscard]] std::size_t length() const noexcept { return m_query.size(); }
+
+    // Distance of the query to every window series[i, i + length), series most recent first like the query
+    [[nodiscard]] std::vector<double> distanceProfile(std::span<const double> series) const;
+
+    // k closest windows starting at least minOffset entries ago, use the query length to skip the query itself
+    [[nodiscard]] std::vector<Match> search(const Asset& asset, std::size_t k, std::size_t minOffset = 0) const;
+    [[nodiscard]] std::vector<Match> search(const Market& market, std::size_t k, std::size_t minOffset = 0) const; // assets in parallel
+
+private:
+    struct Plan {
+        Fft fft;
+        std::vector<Fft::Complex> query; // conjugate spectrum of the zero padded query
+    };
+    using Plans = std::map<std::size_t, Plan>; // by FFT size, one per thread
+
+    [[nodiscard]] std::vector<double> distanceProfile(std::span<const double> series, Plans& plans) const;
+    [[nodiscard]] std::vector<Match> search(const Asset& asset, std::size_t k, std::size_t minOffset, Plans& plans) const;
+
+    std::vector<double> m_query; // z-normalized
+    PriceType m_priceType;
+    std::size_t m_exclusionZone;
+    bool m_constant {}; // the query has no shape, only constant windows match it
+};
+
+} // namespace portopt
@@ -8,6 +8,7 @@
 #include "Portfolio.hpp"
 
 #include "CsvFile.hpp"
+#include "ReportWriter.hpp"
 
 #include <cassert>
 #include <cmath>
@@ -52,11 +53,11 @@ const Portfolio::PositionMap& Portfolio::holdings() const noexcept
 void Portfolio::saveCsv(const FilePath& csvPath) const
 {
     std::cerr << "Portfolio::saveCsv [csvPath] " << csvPath << "\n";
-    std::ofstream file(csvPath, std::ios::out | std::ios::trunc);
-    assert(file.is_open());
+    ReportWriter file { csvPath };
+    assert(file.isOpen());
     file << "Symbol,Quantity\n";
     for (const auto& [symbol, quantity] : m_holdings) {
-        file << symbol << "," << quantity << "\n";
+        file << symbol << ',' << quantity << '\n';
     }
 }
 
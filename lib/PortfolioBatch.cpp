@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "PortfolioBatch.hpp"
+#include "Market.hpp"
+#include "ReturnMatrix.hpp"
+#include "RiskEstimator.hpp"
+#include "RiskModel.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+using namespace portopt;
+
+namespace {
+
+constexpr std::size_t blockRows = 4096; // portfolios per product with Σ, bounds the memory to O(blockRows N)
+
+} // anonymous namespace
+
+PortfolioBatchResult PortfolioBatch::evaluate(const Market& market, const Matrix& weights, std::size_t historicalHorizon, const RiskEstimator* estimator)
+{
+    // the columns of the weights are the assets of the market in market order, as in market.riskModel()
+    std::vector<std::string> symbols;
+    std::vector<double> mu;
+    for (const auto& [symbol, asset] : market.assets()) {
+        symbols.push_back(symbol);
+        mu.push_back(asset.avgReturn(0));
+    }
+    const auto column = [&symbols](const std::string& symbol) {
+        const auto itr = std::lower_bound(symbols.begin(), symbols.end(), symbol);
+        return itr == symbols.end() || *itr != symbol ? RiskEstimator::npos : static_cast<std::size_t>(itr - symbols.begin());
+    };
+    const std::size_t numPortfolios = weights.rows();
+    const std::size_t numAssets = symbols.size();
+    assert(weights.cols() == numAssets);
+    std::cerr << "PortfolioBatch::evaluate [portfolios] " << numPortfolios << "\n";
+
+    PortfolioBatchResult result;
+    result.risks.resize(numPortfolios);
+    result.returns.resize(numPortfolios);
+    Utils::parallelFor(numPortfolios, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t k = begin; k < end; ++k) {
+            const double* w = weights.row(k);
+            double ret {};
+            for (std::size_t i = 0; i < numAssets; ++i) {
+                ret += w[i] * mu[i];
+            }
+            result.returns[k] = ret;
+        }
+    });
+
+    if (estimator == nullptr) {
+        // risk(k)² = row sum of (WΣ)∘W, Σ is symmetric so WΣ = WΣᵀ. W goes through in blocks of rows so only
+        // blockRows x N of WΣ is held at once instead of K x N
+        const Matrix& covariance = market.riskModel().covariance();
+        for (std::size_t first = 0; first < numPortfolios; first += blockRows) {
+            const std::size_t last = std::min(first + blockRows, numPortfolios);
+            Matrix block { last - first, numAssets };
+            std::copy(weights.row(first), weights.row(first) + block.data().size(), block.row(0));
+            const Matrix weightedCovariance = Matrix::multiply(block, covariance);
+            Utils::parallelFor(block.rows(), [&](std::size_t begin, std::size_t end) {
+                for (std::size_t k = begin; k < end; ++k) {
+                    const double* w = block.row(k);
+                    const double* ws = weightedCovariance.row(k);
+                    double variance {};
+                    for (std::size_t i = 0; i < numAssets; ++i) {
+                        variance += ws[i] * w[i];
+                    }
+                    result.risks[first + k] = std::sqrt(std::max(0.0, variance));
+                }
+            });
+        }
+    } else {
+        // map the columns of the weights onto the estimator's columns, the dense model is never built
+        std::vector<std::size_t> columns(estimator->size());
+        for (std::size_t e = 0; e < columns.size(); ++e) {
+            columns[e] = column(estimator->symbols()[e]);
+        }
+        Utils::parallelFor(numPortfolios, [&](std::size_t begin, std::size_t end) {
+            std::vector<double> w(columns.size());
+            for (std::size_t k = begin; k < end; ++k) {
+                for (std::size_t e = 0; e < columns.size(); ++e) {
+                    w[e] = columns[e] == RiskEstimator::npos ? 0 : weights(k, columns[e]);
+                }
+                result.risks[k] = estimator->risk(w);
+            }
+        });
+    }
+
+    if (historicalHorizon == 0) {
+        return result;
+    }
+
+    // map the risk model's columns onto the return matrix's columns
+    const ReturnMatrix& returns = market.returns(historicalHorizon);
+    const std::size_t numPeriods = returns.numPeriods();
+    Matrix projection { returns.numAssets(), numPortfolios }; // Wᵀ restricted to assets with history
+    for (std::size_t a = 0; a < returns.numAssets(); ++a) {
+        const std::size_t i = column(returns.symbols()[a]);
+        for (std::size_t k = 0; k < numPortfolios; ++k) {
+            projection(a, k) = weights(k, i);
+        }
+    }
+
+    // portfolio returns: (periods x assets) * (assets x portfolios)
+    const Matrix portfolioReturns = Matrix::multiply(returns.timeMajor(), projection);
+
+    result.historicalRisks.resize(numPortfolios);
+    if (numPeriods == 0) {
+        return result;
+    }
+    std::vector<double> mean(numPortfolios);
+    for (std::size_t t = 0; t < numPeriods; ++t) {
+        const double* row = portfolioReturns.row(t);
+        for (std::size_t k = 0; k < numPortfolios; ++k) {
+            mean[k] += row[k];
+        }
+    }
+    const auto n = static_cast<double>(numPeriods);
+    for (auto& item : mean) {
+        item /= n;
+    }
+    std::vector<double> sumDeviation(numPortfolios);
+    for (std::size_t t = 0; t < numPeriods; ++t) {
+        const double* row = portfolioReturns.row(t);
+        for (std::size_t k = 0; k < numPortfolios; ++k) {
+            const double deviation = row[k] - mean[k];
+            sumDeviation[k] += deviation * deviation;
+        }
+    }
+    for (std::size_t k = 0; k < numPortfolios; ++k) {
+        result.historicalRisks[k] = std::sqrt(sumDeviation[k] / n);
+    }
+    return result;
+}
@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#pragma once
+
+#include "Matrix.hpp"
+
+#include <vector>
+
+namespace portopt {
+
+class Market;
+class RiskEstimator;
+
+// Risk and return of many candidate portfolios at once
+struct PortfolioBatchResult {
+    std::vector<double> risks; // σ(k) = sqrt(w(k)ᵀΣw(k)) under the dense risk model or the estimator
+    std::vector<double> returns; // Σw(k,i)μ(i)
+    std::vector<double> historicalRisks; // standard deviation of each portfolio's historical returns (empty unless requested)
+};
+
+namespace PortfolioBatch {
+
+    /**
+     * @brief evaluate K portfolios over the N assets of a market
+     * @param market market providing the expected returns, the risk model (and returns for historical risks)
+     * @param weights K x N matrix, row k holds the weights of portfolio k in market.riskModel().symbols() order
+     * @param historicalHorizon if non-zero, also compute the risk of each constant-mix portfolio over
+     *        market.returns(historicalHorizon) (assets without enough history contribute no return)
+     * @param estimator if set, the risks come from it instead of market.riskModel(), which is then not built (e.g.
+     *        Market::ewmaCovariance or Market::factorModel), weights are mapped onto its symbols
+     * @return K risks, K returns and optionally K historical risks
+     */
+    PortfolioBatchResult evaluate(const Market& market, const Matrix& weights, std::size_t historicalHorizon = 0,
+        const RiskEstimator* estimator = nullptr);
+
+} // namespace PortfolioBatch
+} // namespace portopt
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "RangeQuery.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+using namespace portopt;
+
+RangeQuery::RangeQuery(std::vector<double> values, Mode mode)
+    : m_values { std::move(values) }
+    , m_mode { mode }
+{
+    const std::size_t size = m_values.size();
+    if (size == 0) {
+        return;
+    }
+
+    m_table.resize(std::bit_width(size));
+    m_table[0].resize(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        m_table[0][i] = static_cast<std::uint32_t>(i);
+    }
+
+    for (std::size_t k = 1; k < m_table.size(); ++k) {
+        const std::size_t half = std::size_t { 1 } << (k - 1);
+        const std::size_t count = size - (half * 2) + 1;
+        m_table[k].resize(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            m_table[k][i] = better(m_table[k - 1][i], m_table[k - 1][i + half]);
+        }
+    }
+}
+
+std::uint32_t RangeQuery::better(std::uint32_t i, std::uint32_t j) const noexcept
+{
+    if (m_values[j] == m_values[i]) {
+        return std::min(i, j);
+    }
+    if (m_mode == Mode::Max) {
+        return m_values[j] > m_values[i] ? j : i;
+    }
+    return m_values[j] < m_values[i] ? j : i;
+}
+
+std::size_t RangeQuery::index(std::size_t begin, std::size_t end) const
+{
+    assert(begin < end);
+    assert(end <= m_values.size());
+    const std::size_t k = std::bit_width(end - begin) - 1;
+    return better(m_table[k][begin], m_table[k][end - (std::size_t { 1 } << k)]);
+}
+
+double RangeQuery::value(std::size_t begin, std::size_t end) const
+{
+    return m_values[index(begin, end)];
+}
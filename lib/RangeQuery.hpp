@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace portopt {
+
+// Sparse table answering range maximum (or minimum) queries in O(1) after an O(n log n) build
+class RangeQuery {
+public:
+    enum class Mode : std::uint8_t {
+        Max,
+        Min,
+    };
+
+    RangeQuery(std::vector<double> values, Mode mode);
+
+    [[nodiscard]] std::size_t size() const noexcept { return m_values.size(); }
+    [[nodiscard]] std::size_t index(std::size_t begin, std::size_t end) const; // index of the best value in [begin, end), lowest index on ties
+    [[nodiscard]] double value(std::size_t begin, std::size_t end) const; // best value in [begin, end)
+
+private:
+    [[nodiscard]] std::uint32_t better(std::uint32_t i, std::uint32_t j) const noexcept;
+
+    const std::vector<double> m_values;
+    const Mode m_mode;
+    std::vector<std::vector<std::uint32_t>> m_table; // m_table[k][i] is the index of the best value in [i, i + 2^k)
+};
+
+} // namespace portopt
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "ReportWriter.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <ctime>
+#include <iostream>
+#include <thread>
+
+using namespace portopt;
+
+namespace {
+
+// Zero padded decimal digits of a non negative value
+void writeDigits(char* out, int value, int width)
+{
+    for (int i = width - 1; i >= 0; --i) {
+        out[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+}
+
+} // anonymous namespace
+
+void ReportBuffer::append(double value)
+{
+    char chars[32];
+    const auto [end, ec] = std::to_chars(std::begin(chars), std::end(chars), value, std::chars_format::general, 6);
+    m_data.append(chars, end);
+}
+
+void ReportBuffer::appendFixed(double value, int precision)
+{
+    char chars[400]; // 309 integer digits for the largest double
+    const auto [end, ec] = std::to_chars(std::begin(chars), std::end(chars), value, std::chars_format::fixed, precision);
+    assert(ec == std::errc {});
+    m_data.append(chars, end);
+}
+
+void ReportBuffer::appendDate(const TimePoint& tp)
+{
+    const auto tt = std::chrono::system_clock::to_time_t(tp);
+    std::tm tmbuf {};
+    std::tm* const tm = localtime_r(&tt, &tmbuf);
+    assert(tm != nullptr);
+
+    char chars[10] { '0', '0', '0', '0', '-', '0', '0', '-', '0', '0' };
+    writeDigits(chars, tm->tm_year + 1900, 4);
+    writeDigits(chars + 5, tm->tm_mon + 1, 2);
+    writeDigits(chars + 8, tm->tm_mday, 2);
+    m_data.append(chars, sizeof(chars));
+}
+
+void ReportBuffer::appendDateTime(const TimePoint& tp)
+{
+    const auto tt = std::chrono::system_clock::to_time_t(tp);
+    std::tm tmbuf {};
+    std::tm* const tm = localtime_r(&tt, &tmbuf);
+    assert(tm != nullptr);
+
+    char chars[19] { '0', '0', '0', '0', '-', '0', '0', '-', '0', '0', ' ', '0', '0', ':', '0', '0', ':', '0', '0' };
+    writeDigits(chars, tm->tm_year + 1900, 4);
+    writeDigits(chars + 5, tm->tm_mon + 1, 2);
+    writeDigits(chars + 8, tm->tm_mday, 2);
+    writeDigits(chars + 11, tm->tm_hour, 2);
+    writeDigits(chars + 14, tm->tm_min, 2);
+    writeDigits(chars + 17, tm->tm_sec, 2);
+    m_data.append(chars, sizeof(chars));
+}
+
+ReportWriter::ReportWriter(const FilePath& filePath)
+    : m_file { filePath, std::ios::out | std::ios::trunc | std::ios::binary }
+{
+    if (!m_file.is_open()) {
+        std::cerr << "ReportWriter::ReportWriter [FAILED TO OPEN FILE] " << filePath << "\n";
+    }
+    m_buffer.reserve(flushSize + flushSize / 4);
+}
+
+ReportWriter::~ReportWriter()
+{
+    flush();
+}
+
+void ReportWriter::flush()
+{
+    if (m_buffer.size() > 0 && m_file.is_open()) {
+        m_file.write(m_buffer.view().data(), static_cast<std::streamsize>(m_buffer.size()));
+    }
+    m_buffer.clear();
+}
+
+void ReportWriter::writeRows(std::size_t count, const std::function<void(ReportBuffer& buffer, std::size_t row)>& format)
+{
+    flush();
+
+    // rows are formatted in chunks so the memory used does not grow with the size of the report
+    const std::size_t chunkSize = std::min<std::size_t>(count, 64 * std::max(1U, std::thread::hardware_concurrency()));
+    m_rows.resize(std::max(m_rows.size(), chunkSize));
+
+    for (std::size_t first = 0; first < count; first += chunkSize) {
+        const std::size_t size = std::min(chunkSize, count - first);
+        Utils::parallelFor(size, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                m_rows[i].clear();
+                format(m_rows[i], first + i);
+            }
+        });
+        for (std::size_t i = 0; i < size; ++i) {
+            m_buffer.append(m_rows[i].view());
+            if (m_buffer.size() >= flushSize) {
+                flush();
+            }
+        }
+    }
+}
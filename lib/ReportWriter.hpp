@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#pragma once
+
+#include "FilePath.hpp"
+#include "TimePoint.hpp"
+
+#include <charconv>
+#include <concepts>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace portopt {
+
+// Text buffer for report rows, numbers are formatted with std::to_chars
+class ReportBuffer {
+public:
+    void append(std::string_view str) { m_data.append(str); }
+
+    template <std::integral T>
+    void append(T value)
+    {
+        if constexpr (std::is_same_v<T, char>) {
+            m_data.push_back(value);
+        } else if constexpr (std::is_same_v<T, bool>) {
+            m_data.push_back(value ? '1' : '0');
+        } else {
+            char chars[24];
+            const auto [end, ec] = std::to_chars(std::begin(chars), std::end(chars), value);
+            m_data.append(chars, end);
+        }
+    }
+
+    void append(double value); // 6 significant digits, same as the default std::ostream format
+    void appendFixed(double value, int precision); // same as std::fixed with std::setprecision
+    void appendDate(const TimePoint& tp); // YYYY-MM-DD, same as Utils::to_string
+    void appendDateTime(const TimePoint& tp); // YYYY-MM-DD HH:MM:SS, same as Utils::toDateTimeString
+
+    void clear() noexcept { m_data.clear(); } // keeps the capacity for the next rows
+    void reserve(std::size_t size) { m_data.reserve(size); }
+    [[nodiscard]] std::size_t size() const noexcept { return m_data.size(); }
+    [[nodiscard]] std::string_view view() const noexcept { return m_data; }
+
+private:
+    std::string m_data;
+};
+
+// Writes a report file with few large writes, rows can be formatted in parallel
+class ReportWriter {
+public:
+    explicit ReportWriter(const FilePath& filePath);
+    ~ReportWriter(); // flushes the buffer
+
+    ReportWriter(const ReportWriter&) = delete;
+    ReportWriter& operator=(const ReportWriter&) = delete;
+
+    [[nodiscard]] bool isOpen() const { return m_file.is_open(); }
+
+    // Sequential output, written to the file once the buffer is large enough
+    template <typename T>
+    ReportWriter& operator<<(const T& value)
+    {
+        m_buffer.append(value);
+        if (m_buffer.size() >= flushSize) {
+            flush();
+        }
+        return *this;
+    }
+    [[nodiscard]] ReportBuffer& buffer() noexcept { return m_buffer; } // for appendFixed and appendDate
+
+    // Format rows [0, count) in parallel blocks, format(buffer, row) appends one row and rows are written in order
+    void writeRows(std::size_t count, const std::function<void(ReportBuffer& buffer, std::size_t row)>& format);
+
+    void flush();
+
+private:
+    static constexpr std::size_t flushSize = 1 << 20;
+
+    std::ofstream m_file;
+    ReportBuffer m_buffer;
+    std::vector<ReportBuffer> m_rows; // reused between calls of writeRows
+};
+
+} // namespace portopt
@@ -0,0 +1,385 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "Retirement.hpp"
+#include "Market.hpp"
+#include "Portfolio.hpp"
+#include "Utils.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace portopt;
+
+namespace {
+
+constexpr std::size_t lanes = 64; // paths updated together, the inner loops run over lanes so they vectorize
+constexpr std::size_t daysPerMonth = 30;
+
+struct Month {
+    double flow {}; // savings added or expenses paid at the end of the month
+    bool accumulating {}; // before retirement savings always grow, after it only while positive
+};
+
+// Cash flows of every month from current age to death age
+std::vector<Month> schedule(const RetirementPlan& plan)
+{
+    std::vector<Month> result;
+    for (int month = plan.currentAge * 12; month < plan.deathAge * 12; ++month) {
+        if (month < plan.retirementAge * 12) {
+            result.push_back({ plan.monthlySavings, true });
+        } else if (month < plan.socialSecurityAge * 12) {
+            result.push_back({ -plan.monthlyExpenses, false });
+        } else {
+            result.push_back({ plan.socialSecurity - plan.monthlyExpenses, false });
+        }
+    }
+    return result;
+}
+
+constexpr std::size_t never = static_cast<std::size_t>(-1);
+
+struct Phase {
+    double balance {};
+    std::size_t depleted { never }; // first month of the phase that ended with no savings left
+};
+
+// Balance after k months of b = b * g + f
+double compound(double b, double g, double f, double k)
+{
+    if (g == 1) {
+        return b + f * k;
+    }
+    const double gk = std::pow(g, k);
+    return b * gk + f * (gk - 1) / (g - 1);
+}
+
+// n months where savings only grow while they are positive, with a flow f at the end of each month
+Phase drawdown(double b, double g, double f, std::size_t n)
+{
+    const auto months = static_cast<double>(n);
+    if (b <= 0) {
+        if (f <= 0) {
+            return { b + f * months, 0 };
+        }
+        // no growth until the flow makes the balance positive again
+        const auto k = static_cast<std::size_t>(std::floor(-b / f)) + 1;
+        if (k >= n) {
+            return { b + f * months, 0 };
+        }
+        return { drawdown(b + f * static_cast<double>(k), g, f, n - k).balance, 0 };
+    }
+    if (f >= 0) {
+        return { compound(b, g, f, months), never }; // stays positive
+    }
+
+    // first month k with b(k) <= 0, from b(k) = (b - c) * g^k + c where c = f / (1 - g) is the fixed point
+    double first = std::ceil(b / -f);
+    if (g != 1) {
+        const double c = f / (1 - g);
+        if (g > 1 && b >= c) {
+            return { compound(b, g, f, months), never }; // growth covers the expenses
+        }
+        first = std::ceil(std::log(c / (c - b)) / std::log(g));
+    }
+    auto k = static_cast<std::size_t>(std::clamp(first, 1.0, months + 1));
+
+    // rounding can be off by a month, settle it with monthly steps
+    while (k > 1 && compound(b, g, f, static_cast<double>(k - 1)) <= 0) {
+        --k;
+    }
+    while (k <= n && compound(b, g, f, static_cast<double>(k)) > 0) {
+        ++k;
+    }
+    if (k > n) {
+        return { compound(b, g, f, months), never };
+    }
+    return { compound(b, g, f, static_cast<double>(k)) + f * static_cast<double>(n - k), k };
+}
+
+void appendNumber(std::string& buffer, double value)
+{
+    char chars[32];
+    const auto [end, ec] = std::to_chars(std::begin(chars), std::end(chars), value, std::chars_format::fixed, 2);
+    buffer.append(chars, end);
+}
+
+template <typename T>
+void read(const nlohmann::json& json, const char* key, T& value)
+{
+    if (json.contains(key)) {
+        value = json.at(key).get<T>();
+    }
+}
+
+} // anonymous namespace
+
+RetirementPlan RetirementPlan::load(const FilePath& jsonPath)
+{
+    RetirementPlan plan;
+    std::ifstream ifs(jsonPath);
+    if (!ifs.is_open()) {
+        std::cerr << "RetirementPlan::load [FAILED TO OPEN FILE] " << jsonPath << "\n";
+        return plan;
+    }
+    try {
+        const auto json = nlohmann::json::parse(ifs);
+        read(json, "currentAge", plan.currentAge);
+        read(json, "retirementAge", plan.retirementAge);
+        read(json, "socialSecurityAge", plan.socialSecurityAge);
+        read(json, "deathAge", plan.deathAge);
+        read(json, "monthlySavings", plan.monthlySavings);
+        read(json, "monthlyExpenses", plan.monthlyExpenses);
+        read(json, "socialSecurity", plan.socialSecurity);
+        read(json, "currentSavings", plan.currentSavings);
+        read(json, "rateOfReturnBefore", plan.rateOfReturnBefore);
+        read(json, "rateOfReturnAfter", plan.rateOfReturnAfter);
+    } catch (std::exception& e) {
+        std::cerr << "RetirementPlan::load [exception] " << jsonPath << " " << e.what() << "\n";
+    }
+    assert(plan.currentAge <= plan.retirementAge && plan.retirementAge <= plan.deathAge);
+    return plan;
+}
+
+std::vector<double> Retirement::deterministic(const RetirementPlan& plan)
+{
+    const double growthBefore = (100.0 + plan.rateOfReturnBefore / 12.0) / 100.0;
+    const double growthAfter = (100.0 + plan.rateOfReturnAfter / 12.0) / 100.0;
+    const auto months = schedule(plan);
+
+    std::vector<double> result { plan.currentSavings };
+    double savings = plan.currentSavings;
+    for (std::size_t i = 0; i < months.size(); ++i) {
+        if (months[i].accumulating) {
+            savings *= growthBefore;
+        } else if (savings > 0) {
+            savings *= growthAfter;
+        }
+        savings += months[i].flow;
+        if ((i + 1) % 12 == 0) {
+            result.push_back(savings);
+        }
+    }
+    return result;
+}
+
+std::size_t RetirementGrid::size() const noexcept
+{
+    return retirementAges.size() * monthlySavings.size() * monthlyExpenses.size() * ratesOfReturn.size();
+}
+
+RetirementScenario Retirement::evaluate(const RetirementPlan& plan)
+{
+    const double growthBefore = (100.0 + plan.rateOfReturnBefore / 12.0) / 100.0;
+    const double growthAfter = (100.0 + plan.rateOfReturnAfter / 12.0) / 100.0;
+    assert(growthBefore > 0 && growthAfter > 0);
+
+    const int retirementAge = std::clamp(plan.retirementAge, plan.currentAge, plan.deathAge);
+    const int socialSecurityAge = std::clamp(plan.socialSecurityAge, retirementAge, plan.deathAge);
+
+    const double savings = compound(plan.currentSavings, growthBefore, plan.monthlySavings, 12.0 * (retirementAge - plan.currentAge));
+    const auto retired = drawdown(savings, growthAfter, -plan.monthlyExpenses, 12 * static_cast<std::size_t>(socialSecurityAge - retirementAge));
+    const auto social = drawdown(retired.balance, growthAfter, plan.socialSecurity - plan.monthlyExpenses, 12 * static_cast<std::size_t>(plan.deathAge - socialSecurityAge));
+
+    RetirementScenario result;
+    result.retirementAge = retirementAge;
+    result.monthlySavings = plan.monthlySavings;
+    result.monthlyExpenses = plan.monthlyExpenses;
+    result.rateOfReturnBefore = plan.rateOfReturnBefore;
+    result.rateOfReturnAfter = plan.rateOfReturnAfter;
+    result.endBalance = social.balance;
+    if (retired.depleted != never) {
+        result.depletionAge = retirementAge + static_cast<double>(retired.depleted) / 12;
+    } else if (social.depleted != never) {
+        result.depletionAge = socialSecurityAge + static_cast<double>(social.depleted) / 12;
+    }
+    return result;
+}
+
+std::vector<RetirementScenario> Retirement::sweep(const RetirementPlan& base, const RetirementGrid& grid)
+{
+    std::vector<RetirementScenario> result(grid.size());
+    Utils::parallelFor(result.size(), [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            // the rate of return changes fastest
+            std::size_t rest = i;
+            const auto& rates = grid.ratesOfReturn[rest % grid.ratesOfReturn.size()];
+            rest /= grid.ratesOfReturn.size();
+            const double expenses = grid.monthlyExpenses[rest % grid.monthlyExpenses.size()];
+            rest /= grid.monthlyExpenses.size();
+            const double savings = grid.monthlySavings[rest % grid.monthlySavings.size()];
+            rest /= grid.monthlySavings.size();
+
+            RetirementPlan plan = base;
+            plan.retirementAge = grid.retirementAges[rest];
+            plan.monthlySavings = savings;
+            plan.monthlyExpenses = expenses;
+            plan.rateOfReturnBefore = rates.first;
+            plan.rateOfReturnAfter = rates.second;
+            result[i] = evaluate(plan);
+        }
+    });
+    return result;
+}
+
+void Retirement::saveSweep(const std::vector<RetirementScenario>& scenarios, const FilePath& filePath)
+{
+    std::ofstream outFile(filePath, std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!outFile.is_open()) {
+        std::cerr << "Retirement::saveSweep [FAILED TO OPEN FILE] " << filePath << "\n";
+        return;
+    }
+
+    std::string buffer { "Retirement Age,Monthly Savings,Monthly Expenses,Return Before %,Return After %,End Balance,Depletion Age\n" };
+    buffer.reserve(scenarios.size() * 64 + buffer.size());
+    for (const auto& item : scenarios) {
+        buffer += std::to_string(item.retirementAge);
+        for (const double value : { item.monthlySavings, item.monthlyExpenses, item.rateOfReturnBefore, item.rateOfReturnAfter, item.endBalance, item.depletionAge }) {
+            buffer += ',';
+            appendNumber(buffer, value);
+        }
+        buffer += '\n';
+    }
+    outFile.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+}
+
+std::vector<double> Retirement::monthlyReturns(const Market& market, const Portfolio& portfolio)
+{
+    // history shared by all holdings, single price assets like CASH keep their price
+    std::size_t length = static_cast<std::size_t>(-1);
+    for (const auto& [symbol, quantity] : portfolio.holdings()) {
+        const auto size = market.get(symbol).ohlc().size();
+        if (size > 1) {
+            length = std::min(length, size);
+        }
+    }
+    if (length == static_cast<std::size_t>(-1)) {
+        return {};
+    }
+
+    const auto nav = [&](std::size_t i) {
+        double total {};
+        for (const auto& [symbol, quantity] : portfolio.holdings()) {
+            const auto& ohlc = market.get(symbol).ohlc();
+            total += ohlc.at(ohlc.size() > 1 ? i : 0).hl2() * quantity;
+        }
+        return total;
+    };
+
+    // oldest first, so a block of consecutive returns is in chronological order
+    std::vector<double> result;
+    for (std::size_t i = (length - 1) / daysPerMonth * daysPerMonth; i >= daysPerMonth; i -= daysPerMonth) {
+        const double before = nav(i);
+        if (before > 0) {
+            result.push_back(nav(i - daysPerMonth) / before - 1);
+        }
+    }
+    return result;
+}
+
+RetirementResult Retirement::monteCarlo(const RetirementPlan& plan, const std::vector<double>& monthlyReturns, std::size_t numPaths,
+    std::size_t blockSize, std::uint64_t seed, std::size_t maxSamples)
+{
+    RetirementResult result;
+    result.numPaths = numPaths;
+    for (int age = plan.currentAge; age <= plan.deathAge; ++age) {
+        result.ages.push_back(age);
+    }
+    if (monthlyReturns.empty() || numPaths == 0) {
+        std::cerr << "Retirement::monteCarlo [no returns or paths]\n";
+        return result;
+    }
+
+    const auto months = schedule(plan);
+    const std::size_t numAges = result.ages.size();
+    const std::size_t numSamples = std::min(maxSamples, numPaths);
+    blockSize = std::clamp<std::size_t>(blockSize, 1, monthlyReturns.size());
+
+    std::vector<double> samples(numAges * numSamples); // age-major savings of the first numSamples paths
+    std::atomic<std::size_t> successes {};
+
+    const std::size_t numBlocks = (numPaths + lanes - 1) / lanes;
+    Utils::parallelFor(numBlocks, [&](std::size_t begin, std::size_t end) {
+        std::size_t localSuccesses {};
+        std::array<double, lanes> savings {};
+        std::array<double, lanes> rate {};
+        std::array<double, lanes> lowest {};
+        std::array<std::size_t, lanes> position {};
+        std::array<std::size_t, lanes> remaining {};
+
+        for (std::size_t block = begin; block < end; ++block) {
+            // one generator per block of paths, independent of how blocks are split between threads
+            std::seed_seq seq { static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32),
+                static_cast<std::uint32_t>(block), static_cast<std::uint32_t>(block >> 32) };
+            std::mt19937_64 rng { seq };
+            std::uniform_int_distribution<std::size_t> start { 0, monthlyReturns.size() - blockSize };
+
+            const std::size_t firstPath = block * lanes;
+            const std::size_t count = std::min(lanes, numPaths - firstPath);
+            savings.fill(plan.currentSavings);
+            lowest.fill(plan.currentSavings);
+            remaining.fill(0);
+
+            const auto record = [&](std::size_t ageIndex) {
+                for (std::size_t l = 0; l < count && firstPath + l < numSamples; ++l) {
+                    samples[ageIndex * numSamples + firstPath + l] = savings[l];
+                }
+            };
+            record(0);
+
+            for (std::size_t m = 0; m < months.size(); ++m) {
+                for (std::size_t l = 0; l < lanes; ++l) {
+                    if (remaining[l] == 0) {
+                        position[l] = start(rng);
+                        remaining[l] = blockSize;
+                    }
+                    rate[l] = monthlyReturns[position[l]++];
+                    --remaining[l];
+                }
+                const double flow = months[m].flow;
+                const bool accumulating = months[m].accumulating;
+                for (std::size_t l = 0; l < lanes; ++l) {
+                    const double growth = (accumulating || savings[l] > 0) ? 1 + rate[l] : 1.0;
+                    savings[l] = savings[l] * growth + flow;
+                    lowest[l] = std::min(lowest[l], savings[l]);
+                }
+                if ((m + 1) % 12 == 0) {
+                    record((m + 1) / 12);
+                }
+            }
+
+            for (std::size_t l = 0; l < count; ++l) {
+                localSuccesses += lowest[l] >= 0 ? 1 : 0;
+            }
+        }
+        successes += localSuccesses;
+    });
+
+    result.successProbability = static_cast<double>(successes) / static_cast<double>(numPaths);
+
+    result.bands.resize(numAges);
+    Utils::parallelFor(numAges, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t a = begin; a < end; ++a) {
+            const auto first = samples.begin() + static_cast<std::ptrdiff_t>(a * numSamples);
+            for (std::size_t p = 0; p < RetirementResult::percentiles.size(); ++p) {
+                const auto rank = static_cast<std::ptrdiff_t>(RetirementResult::percentiles[p] / 100 * static_cast<double>(numSamples - 1) + 0.5);
+                std::nth_element(first, first + rank, first + static_cast<std::ptrdiff_t>(numSamples));
+                result.bands[a][p] = *(first + rank);
+            }
+        }
+    });
+    return result;
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#pragma once
+
+#include "FilePath.hpp"
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace portopt {
+
+class Market;
+class Portfolio;
+
+// Inputs of a retirement plan, amounts are in today's dollars and rates are annual percentages
+struct RetirementPlan {
+    int currentAge { 30 };
+    int retirementAge { 42 };
+    int socialSecurityAge { 67 };
+    int deathAge { 90 };
+
+    double monthlySavings { 5000 }; // stops at retirement age
+    double monthlyExpenses { 5000 }; // starts at retirement age
+    double socialSecurity { 1000 }; // monthly income from social security age
+    double currentSavings { 500'000 };
+
+    double rateOfReturnBefore { 4 }; // before retirement
+    double rateOfReturnAfter { 2 }; // after retirement
+
+    static RetirementPlan load(const FilePath& jsonPath); // missing keys keep their default value
+};
+
+struct RetirementResult {
+    static constexpr std::array<double, 5> percentiles { 5, 25, 50, 75, 95 };
+
+    std::size_t numPaths {};
+    double successProbability {}; // fraction of paths whose savings never went negative
+    std::vector<int> ages; // currentAge .. deathAge
+    std::vector<std::array<double, percentiles.size()>> bands; // savings percentiles at each age
+};
+
+// Values of each plan input to combine in a sweep, every combination is one scenario
+struct RetirementGrid {
+    std::vector<int> retirementAges;
+    std::vector<double> monthlySavings;
+    std::vector<double> monthlyExpenses;
+    std::vector<std::pair<double, double>> ratesOfReturn; // {before, after} retirement
+
+    [[nodiscard]] std::size_t size() const noexcept;
+};
+
+struct RetirementScenario {
+    int retirementAge {};
+    double monthlySavings {};
+    double monthlyExpenses {};
+    double rateOfReturnBefore {};
+    double rateOfReturnAfter {};
+    double endBalance {}; // savings at death age
+    double depletionAge {}; // age when savings ran out, 0 if they never did
+};
+
+namespace Retirement {
+
+    // Month by month savings at each age with the constant rates of return of the plan
+    std::vector<double> deterministic(const RetirementPlan& plan);
+
+    // Ending balance of a plan, each phase uses closed-form growth and annuity formulas instead of monthly steps
+    RetirementScenario evaluate(const RetirementPlan& plan);
+
+    // Evaluate every combination of the grid in parallel, other inputs come from the base plan
+    std::vector<RetirementScenario> sweep(const RetirementPlan& base, const RetirementGrid& grid);
+    void saveSweep(const std::vector<RetirementScenario>& scenarios, const FilePath& filePath);
+
+    // Monthly returns of the net asset value of a portfolio, from 30 day steps of its price history
+    std::vector<double> monthlyReturns(const Market& market, const Portfolio& portfolio);
+
+    /**
+     * @brief monteCarlo Simulate independent paths with block-bootstrapped historical returns
+     * @param plan retirement plan, its rates of return are replaced by the sampled returns
+     * @param monthlyReturns historical monthly returns to resample
+     * @param numPaths number of simulated paths
+     * @param blockSize consecutive months drawn together to keep autocorrelation
+     * @param seed results only depend on the seed, not on the number of threads
+     * @param maxSamples number of paths kept to estimate the percentile bands
+     */
+    RetirementResult monteCarlo(const RetirementPlan& plan, const std::vector<double>& monthlyReturns, std::size_t numPaths,
+        std::size_t blockSize = 12, std::uint64_t seed = 1, std::size_t maxSamples = 100'000);
+
+} // namespace Retirement
+} // namespace portopt
@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "ReturnMatrix.hpp"
+#include "ColumnFile.hpp"
+#include "MappedFile.hpp"
+#include "Market.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <span>
+
+using namespace portopt;
+
+namespace {
+
+// Assets of a return matrix and the entries of their histories it covers
+struct Selection {
+    std::vector<std::string> symbols;
+    std::vector<const OhlcList*> lists;
+    std::size_t size {}; // entries of each list, the returns cover size - horizon periods
+};
+
+Selection selectAssets(const Market& market, std::size_t horizon, OhlcTimeFrame timeFrame, PriceAdjustment adjustment, std::size_t minHistory)
+{
+    Selection result;
+
+    // assets with enough history that end on the most common last date (stale histories can't line up)
+    std::vector<std::string> symbols;
+    std::vector<const OhlcList*> candidates;
+    std::map<TimePoint, std::size_t> lastDates;
+    for (const auto& [symbol, asset] : market.assets()) {
+        const OhlcList& ohlc = asset.ohlc().adjusted(adjustment).resample(timeFrame);
+        if (ohlc.size() > horizon && ohlc.size() >= minHistory) {
+            symbols.push_back(symbol);
+            candidates.push_back(&ohlc);
+            lastDates[ohlc.at(0).timepoint]++;
+        }
+    }
+    if (candidates.empty()) {
+        return result;
+    }
+    const TimePoint lastDate = std::max_element(lastDates.begin(), lastDates.end(), [](const auto& a, const auto& b) { return a.second < b.second; })->first;
+
+    // without a cutoff, keep the assets with at least L entries for the L that covers the most returns, so a young
+    // listing is left out instead of truncating every other history
+    result.size = std::max(minHistory, horizon + 1);
+    if (minHistory == 0) {
+        std::vector<std::size_t> sizes;
+        for (const auto* ohlc : candidates) {
+            if (ohlc->at(0).timepoint == lastDate) {
+                sizes.push_back(ohlc->size());
+            }
+        }
+        std::sort(sizes.begin(), sizes.end(), std::greater {});
+        std::size_t best {};
+        for (std::size_t k = 0; k < sizes.size(); ++k) {
+            const std::size_t cells = (k + 1) * (sizes[k] - horizon);
+            if (cells >= best) {
+                best = cells;
+                result.size = sizes[k];
+            }
+        }
+    }
+
+    for (std::size_t a = 0; a < candidates.size(); ++a) {
+        if (candidates[a]->size() < result.size) {
+            continue;
+        }
+        if (candidates[a]->at(0).timepoint != lastDate || (!result.lists.empty() && !result.lists[0]->matchTimePoint(*candidates[a], result.size))) {
+            std::cerr << "ReturnMatrix::ReturnMatrix [timepoint mismatch] " << symbols[a] << "\n";
+            continue;
+        }
+        result.symbols.push_back(symbols[a]);
+        result.lists.push_back(candidates[a]);
+    }
+    return result;
+}
+
+// Returns of one asset over numPeriods, most recent first
+void computeReturns(const OhlcList& ohlc, std::size_t horizon, PriceType priceType, ReturnType returnType, std::size_t numPeriods, double* out)
+{
+    for (std::size_t t = 0; t < numPeriods; ++t) {
+        const double today = ohlc.at(t).get(priceType);
+        const double yesterday = ohlc.at(t + horizon).get(priceType);
+        assert(yesterday > 0);
+        out[t] = returnType == ReturnType::Log ? std::log(today / yesterday) : (today - yesterday) / yesterday;
+    }
+}
+
+// Returns of one asset at the trading periods (most recent first, all below numPeriods), written every stride values
+// of out. With compound set the growth of the skipped periods is carried into the next trading one, otherwise
+// (overlapping returns already span the skipped days) they are dropped
+void tradingValues(const double* r, std::size_t numPeriods, std::span<const std::size_t> periods, bool compound, bool log, double* out, std::size_t stride)
+{
+    if (!compound) {
+        for (std::size_t k = 0; k < periods.size(); ++k) {
+            out[k * stride] = r[periods[k]];
+        }
+        return;
+    }
+    double pending = log ? 0 : 1;
+    std::size_t k = periods.size();
+    for (std::size_t t = numPeriods; t-- > 0 && k > 0;) { // oldest first
+        pending = log ? pending + r[t] : pending * (1 + r[t]);
+        if (t == periods[k - 1]) {
+            --k;
+            out[k * stride] = log ? pending : pending - 1;
+            pending = log ? 0 : 1;
+        }
+    }
+}
+
+} // anonymous namespace
+
+ReturnMatrix::ReturnMatrix(const Market& market, std::size_t horizon, PriceType priceType, ReturnType returnType, OhlcTimeFrame timeFrame,
+    PriceAdjustment adjustment, std::size_t minHistory)
+    : m_horizon { horizon }
+    , m_returnType { returnType }
+    , m_timeFrame { timeFrame }
+    , m_adjustment { adjustment }
+{
+    assert(horizon > 0);
+    std::cerr << "ReturnMatrix::ReturnMatrix [horizon] " << horizon << "\n";
+
+    const Selection selection = selectAssets(market, horizon, timeFrame, adjustment, minHistory);
+    const auto& lists = selection.lists;
+    if (lists.empty()) {
+        return;
+    }
+    m_symbols = selection.symbols;
+
+    const std::size_t numPeriods = selection.size - horizon;
+    m_assetMajor = Matrix { lists.size(), numPeriods };
+    m_timepoints.reserve(numPeriods);
+    for (std::size_t t = 0; t < numPeriods; ++t) {
+        m_timepoints.push_back(lists[0]->at(t).timepoint); // the same for every asset
+    }
+    m_dummies.resize(lists.size() * numPeriods);
+    std::vector<std::size_t> numReal(numPeriods);
+    for (std::size_t a = 0; a < lists.size(); ++a) {
+        for (std::size_t t = 0; t < numPeriods; ++t) {
+            const bool dummy = lists[a]->at(t).dummy;
+            m_dummies[(a * numPeriods) + t] = dummy;
+            numReal[t] += dummy ? 0 : 1;
+        }
+    }
+    for (std::size_t t = 0; t < numPeriods; ++t) {
+        if (2 * numReal[t] > lists.size()) {
+            m_tradingPeriods.push_back(t);
+        }
+    }
+
+    Utils::parallelFor(lists.size(), [&](std::size_t begin, std::size_t end) {
+        for (std::size_t a = begin; a < end; ++a) {
+            computeReturns(*lists[a], horizon, priceType, returnType, numPeriods, m_assetMajor.row(a));
+        }
+    });
+
+    m_timeMajor = m_assetMajor.transposed();
+}
+
+std::size_t ReturnMatrix::index(const std::string& symbol) const
+{
+    const auto itr = std::lower_bound(m_symbols.begin(), m_symbols.end(), symbol); // symbols are sorted (market order)
+    if (itr == m_symbols.end() || *itr != symbol) {
+        return npos;
+    }
+    return static_cast<std::size_t>(itr - m_symbols.begin());
+}
+
+std::vector<double> ReturnMatrix::tradingSeries(std::size_t asset) const
+{
+    assert(asset < numAssets());
+    std::vector<double> result(m_tradingPeriods.size());
+    tradingValues(series(asset), numPeriods(), m_tradingPeriods, m_horizon == 1, m_returnType == ReturnType::Log, result.data(), 1);
+    return result;
+}
+
+Matrix ReturnMatrix::tradingReturns(std::size_t numPeriods) const
+{
+    assert(numPeriods <= this->numPeriods());
+    const auto last = std::lower_bound(m_tradingPeriods.begin(), m_tradingPeriods.end(), numPeriods);
+    const std::span<const std::size_t> periods { m_tradingPeriods.begin(), last };
+    Matrix result { periods.size(), numAssets() };
+    if (periods.empty()) {
+        return result;
+    }
+    for (std::size_t a = 0; a < numAssets(); ++a) {
+        tradingValues(series(a), numPeriods, periods, m_horizon == 1, m_returnType == ReturnType::Log, result.row(0) + a, numAssets());
+    }
+    return result;
+}
+
+bool ReturnMatrix::save(const FilePath& filePath) const
+{
+    ColumnFileWriter writer;
+    writer.add("symbols", m_symbols);
+    writer.add("horizon", std::vector<std::uint64_t> { m_horizon });
+    writer.add("returns", m_assetMajor.data(), m_assetMajor.cols());
+    return writer.save(filePath);
+}
+
+bool ReturnMatrix::saveCache(const FilePath& filePath, const Market& market, std::size_t horizon, PriceType priceType, ReturnType returnType,
+    OhlcTimeFrame timeFrame, PriceAdjustment adjustment, std::size_t minHistory)
+{
+    assert(horizon > 0);
+    const Selection selection = selectAssets(market, horizon, timeFrame, adjustment, minHistory);
+    const auto& lists = selection.lists;
+    if (lists.empty()) {
+        std::cerr << "ReturnMatrix::saveCache [no assets] " << filePath << "\n";
+        return false;
+    }
+
+    // the returns column is reserved in the file and filled through a writable mapping, asset by asset
+    const std::size_t numPeriods = selection.size - horizon;
+    ColumnFileWriter writer;
+    writer.add("symbols", selection.symbols);
+    writer.add("horizon", std::vector<std::uint64_t> { horizon });
+    writer.reserve("returns", ColumnFile::Type::Float64, { lists.size(), numPeriods });
+    if (!writer.save(filePath)) {
+        return false;
+    }
+    const ColumnFile layout { filePath };
+    const auto* column = layout.find("returns");
+    MappedFile output { filePath, MappedFile::Mode::ReadWrite };
+    if (column == nullptr || output.writableData() == nullptr) {
+        std::cerr << "ReturnMatrix::saveCache [failed to map] " << filePath << "\n";
+        return false;
+    }
+    auto* returns = reinterpret_cast<double*>(output.writableData() + column->offset);
+
+    Utils::parallelFor(lists.size(), [&](std::size_t begin, std::size_t end) {
+        for (std::size_t a = begin; a < end; ++a) {
+            computeReturns(*lists[a], horizon, priceType, returnType, numPeriods, returns + (a * numPeriods));
+        }
+    });
+    return true;
+}
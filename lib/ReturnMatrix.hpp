@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#pragma once
+
+#include "FilePath.hpp"
+#include "Matrix.hpp"
+#include "OhlcEnums.hpp"
+#include "TimePoint.hpp"
+
+#include <string>
+#include <vector>
+
+namespace portopt {
+
+class Market;
+
+// Aligned returns of every asset in a market with enough price history
+class ReturnMatrix {
+public:
+    /**
+     * @brief ReturnMatrix Constructor
+     * @param market assets to include (assets with less than horizon + 1 entries, a stale last date or misaligned dates are skipped)
+     * @param horizon number of entries between the two prices of each return (e.g. 1, 30, 365 days)
+     * @param priceType price used from each OHLC entry
+     * @param returnType simple or log returns
+     * @param timeFrame entries of the returns, the daily history or its resampled bars (e.g. 1 month, 12 months)
+     * @param adjustment raw prices, or prices adjusted for splits or total return (see OhlcList::adjusted)
+     * @param minHistory entries an asset needs to be included, the matrix covers that many entries. 0 picks the cutoff
+     *        that covers the most returns (number of assets kept times their common length)
+     */
+    ReturnMatrix(const Market& market, std::size_t horizon, PriceType priceType, ReturnType returnType, OhlcTimeFrame timeFrame = OhlcTimeFrame::Daily,
+        PriceAdjustment adjustment = PriceAdjustment::None, std::size_t minHistory = 0);
+
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    [[nodiscard]] const std::vector<std::string>& symbols() const noexcept { return m_symbols; }
+    [[nodiscard]] std::size_t index(const std::string& symbol) const; // column of a symbol or npos
+    [[nodiscard]] std::size_t numAssets() const noexcept { return m_symbols.size(); }
+    [[nodiscard]] std::size_t numPeriods() const noexcept { return m_assetMajor.cols(); }
+    [[nodiscard]] std::size_t horizon() const noexcept { return m_horizon; }
+    [[nodiscard]] OhlcTimeFrame timeFrame() const noexcept { return m_timeFrame; }
+    [[nodiscard]] PriceAdjustment adjustment() const noexcept { return m_adjustment; }
+
+    [[nodiscard]] const std::vector<TimePoint>& timepoints() const noexcept { return m_timepoints; } // end of each period, most recent first
+    [[nodiscard]] const Matrix& timeMajor() const noexcept { return m_timeMajor; } // periods x assets, row 0 is the most recent
+    [[nodiscard]] const Matrix& assetMajor() const noexcept { return m_assetMajor; } // assets x periods
+    [[nodiscard]] const double* series(std::size_t asset) const noexcept { return m_assetMajor.row(asset); } // returns of one asset
+
+    // True if the period of the asset ends on a forward filled entry (weekend or holiday of a daily list), the
+    // return of a one entry horizon is then 0 and the next real entry carries the whole move
+    [[nodiscard]] bool dummy(std::size_t asset, std::size_t period) const { return m_dummies[(asset * numPeriods()) + period]; }
+
+    // Periods that end on a real entry of most assets (the trading days of a daily list), most recent first
+    [[nodiscard]] const std::vector<std::size_t>& tradingPeriods() const noexcept { return m_tradingPeriods; }
+
+    // Returns of one asset over tradingPeriods(). With a one entry horizon the return of a skipped period is
+    // compounded into the next trading period, so an asset that trades on the skipped days keeps its whole move
+    [[nodiscard]] std::vector<double> tradingSeries(std::size_t asset) const;
+
+    // The same for every asset over the trading periods among the most recent numPeriods, periods x assets with row 0
+    // the most recent, e.g. to bring a model up to date with the new periods only
+    [[nodiscard]] Matrix tradingReturns(std::size_t numPeriods) const;
+
+    // Binary cache for out-of-core analytics: ColumnFile with "symbols", "horizon" and asset-major "returns"
+    bool save(const FilePath& filePath) const;
+
+    // Same file as save for the same arguments as the constructor, each asset's returns are written straight into
+    // the mapped file so the matrix is never held in memory. False if no asset qualifies or the file can't be written
+    static bool saveCache(const FilePath& filePath, const Market& market, std::size_t horizon, PriceType priceType = PriceType::HL2,
+        ReturnType returnType = ReturnType::Simple, OhlcTimeFrame timeFrame = OhlcTimeFrame::Daily, PriceAdjustment adjustment = PriceAdjustment::None,
+        std::size_t minHistory = 0);
+
+private:
+    const std::size_t m_horizon;
+    const ReturnType m_returnType;
+    const OhlcTimeFrame m_timeFrame;
+    const PriceAdjustment m_adjustment;
+    std::vector<std::string> m_symbols;
+    Matrix m_assetMajor;
+    Matrix m_timeMajor;
+    std::vector<TimePoint> m_timepoints;
+    std::vector<bool> m_dummies; // assets x periods
+    std::vector<std::size_t> m_tradingPeriods;
+};
+
+} // namespace portopt
@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "RiskEstimator.hpp"
+#include "Market.hpp"
+#include "Portfolio.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+
+using namespace portopt;
+
+std::size_t RiskEstimator::index(const std::string& symbol) const
+{
+    const auto& list = symbols();
+    const auto itr = std::lower_bound(list.begin(), list.end(), symbol);
+    if (itr == list.end() || *itr != symbol) {
+        return npos;
+    }
+    return static_cast<std::size_t>(itr - list.begin());
+}
+
+std::vector<double> RiskEstimator::weights(const Market& market, const Portfolio& portfolio) const
+{
+    std::vector<double> result(size());
+    const auto total = Utils::totalValue(market, portfolio, 0);
+    if (total <= 0) {
+        return result;
+    }
+    for (const auto& [symbol, quantity] : portfolio.holdings()) {
+        const std::size_t i = index(symbol);
+        if (i == npos) {
+            continue; // not in the market (e.g. CASH), no risk but still part of the total value
+        }
+        result[i] += market.get(symbol).ohlc().at(0).hl2() * quantity / total;
+    }
+    return result;
+}
@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace portopt {
+
+class Market;
+class Portfolio;
+
+// Portfolio volatility from a covariance estimate of the assets of a market, weights are in symbols() order
+class RiskEstimator {
+public:
+    virtual ~RiskEstimator() = default;
+
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    [[nodiscard]] virtual const std::vector<std::string>& symbols() const noexcept = 0; // sorted (market order)
+    [[nodiscard]] std::size_t size() const noexcept { return symbols().size(); }
+    [[nodiscard]] std::size_t index(const std::string& symbol) const; // position of a symbol or npos
+
+    // value of each holding divided by the portfolio's total value, in symbols() order
+    [[nodiscard]] std::vector<double> weights(const Market& market, const Portfolio& portfolio) const;
+
+    [[nodiscard]] virtual double risk(const std::vector<double>& weights) const = 0; // σ(portfolio) = sqrt(wᵀΣw)
+};
+
+} // namespace portopt
@@ -0,0 +1,280 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "RiskMetrics.hpp"
+#include "Market.hpp"
+#include "OhlcList.hpp"
+#include "Portfolio.hpp"
+#include "ReturnMatrix.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace portopt;
+
+namespace {
+
+constexpr std::size_t tailPoints = 64; // quantiles averaged for the Cornish-Fisher CVaR
+
+// report columns, the scalars then each group once per confidence level
+constexpr std::array<const char*, 7> scalarNames { "maxDrawdown", "drawdownDuration", "downsideDeviation", "sortino", "calmar", "skewness", "excessKurtosis" };
+constexpr std::array<const char*, 4> levelNames { "VaR", "CVaR", "cfVaR", "cfCVaR" };
+
+std::string levelName(double confidence)
+{
+    return std::to_string(static_cast<int>(std::round(confidence * 100))); // "95", "99"
+}
+
+// Returns of the prices of the real entries, most recent first
+std::vector<double> realReturns(const OhlcList& ohlc, PriceType type)
+{
+    std::vector<double> result;
+    result.reserve(ohlc.size());
+    double today {};
+    bool first = true;
+    for (std::size_t i = 0; i < ohlc.size(); ++i) {
+        const Ohlc& item = ohlc.at(i);
+        if (item.dummy) {
+            continue;
+        }
+        const double price = item.get(type);
+        if (!first && price > 0) {
+            result.push_back((today - price) / price);
+        }
+        today = price;
+        first = false;
+    }
+    return result;
+}
+
+} // anonymous namespace
+
+std::vector<std::string> RiskStats::names()
+{
+    std::vector<std::string> result { scalarNames.begin(), scalarNames.end() };
+    for (const double confidence : confidenceLevels) {
+        const auto level = levelName(confidence);
+        for (const char* name : levelNames) {
+            result.push_back(name + level);
+        }
+    }
+    return result;
+}
+
+std::vector<double> RiskStats::values() const
+{
+    std::vector<double> result { maxDrawdown, static_cast<double>(drawdownDuration), downsideDeviation, sortino, calmar, skewness, excessKurtosis };
+    for (std::size_t level = 0; level < numLevels; ++level) {
+        result.insert(result.end(), { var[level], cvar[level], cornishFisherVar[level], cornishFisherCvar[level] });
+    }
+    return result;
+}
+
+RiskStats RiskStats::fromValues(std::span<const double> values)
+{
+    RiskStats result;
+    assert(values.size() == scalarNames.size() + (levelNames.size() * numLevels)); // names().size()
+    result.maxDrawdown = values[0];
+    result.drawdownDuration = static_cast<std::size_t>(values[1]);
+    result.downsideDeviation = values[2];
+    result.sortino = values[3];
+    result.calmar = values[4];
+    result.skewness = values[5];
+    result.excessKurtosis = values[6];
+    for (std::size_t level = 0; level < numLevels; ++level) {
+        const auto* itr = values.data() + scalarNames.size() + (levelNames.size() * level);
+        result.var[level] = itr[0];
+        result.cvar[level] = itr[1];
+        result.cornishFisherVar[level] = itr[2];
+        result.cornishFisherCvar[level] = itr[3];
+    }
+    return result;
+}
+
+RiskStats RiskMetrics::compute(std::span<const double> returns, double barsPerYear, double target)
+{
+    RiskStats result;
+    const std::size_t n = returns.size();
+    result.size = n;
+    if (n < 2) {
+        return result;
+    }
+
+    // moments (Terriberry's online update), downside and drawdowns from the oldest return to the most recent
+    double mean {};
+    double m2 {};
+    double m3 {};
+    double m4 {};
+    double downside {};
+    double value = 1;
+    double peak = 1;
+    std::size_t underWater {};
+    for (std::size_t i = n; i-- > 0;) {
+        const double x = returns[i];
+        const auto count = static_cast<double>(n - i);
+        const double delta = x - mean;
+        const double deltaN = delta / count;
+        const double deltaN2 = deltaN * deltaN;
+        const double term = delta * deltaN * (count - 1);
+        mean += deltaN;
+        m4 += term * deltaN2 * (count * count - 3 * count + 3) + 6 * deltaN2 * m2 - 4 * deltaN * m3;
+        m3 += term * deltaN * (count - 2) - 3 * deltaN * m2;
+        m2 += term;
+
+        const double shortfall = std::min(x - target, 0.0);
+        downside += shortfall * shortfall;
+
+        value *= 1 + x;
+        if (value >= peak) {
+            peak = value;
+            underWater = 0;
+        } else {
+            result.maxDrawdown = std::max(result.maxDrawdown, 1 - value / peak);
+            result.drawdownDuration = std::max(result.drawdownDuration, ++underWater);
+        }
+    }
+    const auto size = static_cast<double>(n);
+    result.mean = mean;
+    result.stdDev = std::sqrt(m2 / size);
+    if (m2 > 0) {
+        result.skewness = std::sqrt(size) * m3 / std::pow(m2, 1.5);
+        result.excessKurtosis = size * m4 / (m2 * m2) - 3;
+    }
+    result.downsideDeviation = std::sqrt(downside / size);
+    if (result.downsideDeviation > 0) {
+        result.sortino = (mean - target) * std::sqrt(barsPerYear) / result.downsideDeviation;
+    }
+    if (result.maxDrawdown > 0 && value > 0) {
+        result.calmar = (std::pow(value, barsPerYear / size) - 1) / result.maxDrawdown;
+    }
+
+    // historical quantiles from the widest tail to the narrowest, each selection only within the previous tail
+    std::vector<double> sorted { returns.begin(), returns.end() };
+    auto tailEnd = sorted.end();
+    for (std::size_t level = 0; level < RiskStats::numLevels; ++level) {
+        assert(level == 0 || RiskStats::confidenceLevels[level] >= RiskStats::confidenceLevels[level - 1]);
+        const double tail = 1 - RiskStats::confidenceLevels[level];
+        const auto k = std::min(static_cast<std::size_t>(tail * size), n - 1);
+        const auto nth = sorted.begin() + static_cast<std::ptrdiff_t>(k);
+        std::nth_element(sorted.begin(), nth, tailEnd);
+        tailEnd = nth + 1;
+        result.var[level] = -*nth;
+        double sum {};
+        for (auto itr = sorted.begin(); itr != tailEnd; ++itr) {
+            sum += *itr;
+        }
+        result.cvar[level] = -sum / static_cast<double>(k + 1);
+
+        const double z = cornishFisher(normalQuantile(tail), result.skewness, result.excessKurtosis);
+        result.cornishFisherVar[level] = -(mean + z * result.stdDev);
+        double tailSum {};
+        for (std::size_t j = 0; j < tailPoints; ++j) {
+            const double p = tail * (static_cast<double>(j) + 0.5) / tailPoints;
+            tailSum += cornishFisher(normalQuantile(p), result.skewness, result.excessKurtosis);
+        }
+        result.cornishFisherCvar[level] = -(mean + tailSum / tailPoints * result.stdDev);
+    }
+    return result;
+}
+
+RiskStats RiskMetrics::compute(const OhlcList& ohlc, PriceType type)
+{
+    return compute(realReturns(ohlc, type), static_cast<double>(OhlcList::tradingBarsPerYear(ohlc.timeFrame())));
+}
+
+RiskStats RiskMetrics::compute(const Market& market, const Portfolio& portfolio, std::size_t length)
+{
+    // CASH and symbols missing from the market keep their current value, only the others size the history
+    std::vector<std::pair<const OhlcList*, double>> holdings;
+    double constant {};
+    std::size_t size = length + 1;
+    for (const auto& [symbol, quantity] : portfolio.holdings()) {
+        const OhlcList& ohlc = market.get(symbol).ohlc();
+        if (!market.assets().contains(symbol)) {
+            constant += ohlc.at(0).hl2() * quantity;
+            continue;
+        }
+        holdings.emplace_back(&ohlc, quantity);
+        size = std::min(size, ohlc.size());
+    }
+
+    std::vector<double> values; // most recent first
+    values.reserve(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        const bool dummy = std::all_of(holdings.begin(), holdings.end(), [i](const auto& holding) { return holding.first->at(i).dummy; });
+        if (dummy) {
+            continue;
+        }
+        double value = constant;
+        for (const auto& [ohlc, quantity] : holdings) {
+            value += ohlc->at(i).hl2() * quantity;
+        }
+        values.push_back(value);
+    }
+    std::vector<double> returns;
+    for (std::size_t i = 0; i + 1 < values.size(); ++i) {
+        if (values[i + 1] > 0) {
+            returns.push_back((values[i] - values[i + 1]) / values[i + 1]);
+        }
+    }
+    return compute(returns, static_cast<double>(OhlcList::tradingBarsPerYear(OhlcTimeFrame::Daily)));
+}
+
+std::vector<RiskStats> RiskMetrics::compute(const ReturnMatrix& returns)
+{
+    // the same convention as the OhlcList overload: periods ending on a dummy are skipped, trading bars per year
+    std::vector<RiskStats> result(returns.numAssets());
+    const auto barsPerYear = static_cast<double>(OhlcList::tradingBarsPerYear(returns.timeFrame())) / static_cast<double>(returns.horizon());
+    Utils::parallelFor(result.size(), [&](std::size_t begin, std::size_t end) {
+        std::vector<double> series;
+        for (std::size_t a = begin; a < end; ++a) {
+            series.clear();
+            for (std::size_t t = 0; t < returns.numPeriods(); ++t) {
+                if (!returns.dummy(a, t)) {
+                    series.push_back(returns.series(a)[t]);
+                }
+            }
+            result[a] = compute(series, barsPerYear);
+        }
+    });
+    return result;
+}
+
+double RiskMetrics::normalQuantile(double p)
+{
+    // Acklam's rational approximation, relative error below 1.2e-9
+    assert(p > 0 && p < 1);
+    constexpr double a[] { -3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02, 1.383577518672690e+02, -3.066479806614716e+01,
+        2.506628277459239e+00 };
+    constexpr double b[] { -5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02, 6.680131188771972e+01, -1.328068155288572e+01 };
+    constexpr double c[] { -7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00, -2.549732539343734e+00, 4.374664141464968e+00,
+        2.938163982698783e+00 };
+    constexpr double d[] { 7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00, 3.754408661907416e+00 };
+    constexpr double low = 0.02425;
+
+    const auto tail = [&](double q) {
+        return (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) / ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1);
+    };
+    if (p < low) {
+        return tail(std::sqrt(-2 * std::log(p)));
+    }
+    if (p > 1 - low) {
+        return -tail(std::sqrt(-2 * std::log(1 - p)));
+    }
+    const double q = p - 0.5;
+    const double r = q * q;
+    return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q / (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1);
+}
+
+double RiskMetrics::cornishFisher(double z, double skewness, double excessKurtosis)
+{
+    const double z2 = z * z;
+    const double z3 = z2 * z;
+    return z + (z2 - 1) * skewness / 6 + (z3 - 3 * z) * excessKurtosis / 24 - (2 * z3 - 5 * z) * skewness * skewness / 36;
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#pragma once
+
+#include "OhlcEnums.hpp"
+
+#include <array>
+#include <cstddef>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace portopt {
+
+class Market;
+class OhlcList;
+class Portfolio;
+class ReturnMatrix;
+
+// Drawdown and tail risk of one return series, losses are positive fractions of the value
+struct RiskStats {
+    static constexpr std::array<double, 2> confidenceLevels { 0.95, 0.99 };
+    static constexpr std::size_t numLevels = confidenceLevels.size();
+
+    std::size_t size {}; // returns used
+    double mean {}; // per bar
+    double stdDev {};
+    double skewness {};
+    double excessKurtosis {};
+    double downsideDeviation {}; // root mean square of the shortfall below the target, per bar
+    double maxDrawdown {}; // largest decline of the compounded value from a previous peak
+    std::size_t drawdownDuration {}; // longest number of bars below a previous peak
+    double sortino {}; // annualized excess return over annualized downside deviation
+    double calmar {}; // compound annual growth over max drawdown
+
+    // one value per confidence level
+    std::array<double, numLevels> var {}; // historical Value at Risk, the loss at the quantile
+    std::array<double, numLevels> cvar {}; // mean loss at or beyond the VaR
+    std::array<double, numLevels> cornishFisherVar {}; // VaR of the normal quantile corrected for skewness and kurtosis
+    std::array<double, numLevels> cornishFisherCvar {}; // corrected quantiles averaged over the tail
+
+    // Flat columns for reports, names() and values() are in the same order
+    [[nodiscard]] static std::vector<std::string> names();
+    [[nodiscard]] std::vector<double> values() const;
+    [[nodiscard]] static RiskStats fromValues(std::span<const double> values);
+};
+
+namespace RiskMetrics {
+
+    // One scan of the returns (most recent first, like ReturnMatrix::series) for the moments, downside deviation and
+    // drawdowns, then partial selection (nth_element) for the historical quantiles of every level
+    RiskStats compute(std::span<const double> returns, double barsPerYear, double target = 0);
+
+    // Close to close returns of the entries that are not forward filled dummies
+    RiskStats compute(const OhlcList& ohlc, PriceType type = PriceType::Close);
+
+    // Daily returns of the value of the holdings over the last length days, skipping days where every holding is a dummy
+    RiskStats compute(const Market& market, const Portfolio& portfolio, std::size_t length);
+
+    // Every asset of the matrix in parallel, like the OhlcList overload without the periods ending on a dummy
+    std::vector<RiskStats> compute(const ReturnMatrix& returns);
+
+    double normalQuantile(double p); // inverse of the standard normal distribution
+    double cornishFisher(double z, double skewness, double excessKurtosis); // corrected quantile of z
+
+} // namespace RiskMetrics
+} // namespace portopt
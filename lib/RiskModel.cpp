@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "RiskModel.hpp"
+#include "Market.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+using namespace portopt;
+
+RiskModel::RiskModel(const Market& market, const std::set<std::string>& symbols)
+{
+    std::vector<const Asset*> assets;
+    for (const auto& [symbol, asset] : market.assets()) {
+        if (!symbols.empty() && !symbols.contains(symbol)) {
+            continue;
+        }
+        m_symbols.push_back(symbol);
+        m_risks.push_back(asset.avgRisk(0));
+        m_returns.push_back(asset.avgReturn(0));
+        assets.push_back(&asset);
+    }
+
+    const std::size_t n = assets.size();
+    std::cerr << "RiskModel::RiskModel [assets] " << n << "\n";
+    m_covariance = Matrix { n, n };
+
+    // ρ is symmetric, each pair is computed once for j > i and mirrored. Rows i and n - 1 - i go to the same task so
+    // every task has about the same number of pairs.
+    const auto fillRow = [&](std::size_t i) {
+        m_covariance(i, i) = m_risks[i] * m_risks[i];
+        for (std::size_t j = i + 1; j < n; ++j) {
+            const double corr = assets[i]->correlation(*assets[j], PriceType::HL2, false, 400);
+            m_covariance(i, j) = m_risks[i] * m_risks[j] * corr;
+            m_covariance(j, i) = m_covariance(i, j);
+        }
+    };
+    Utils::parallelFor((n + 1) / 2, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t p = begin; p < end; ++p) {
+            fillRow(p);
+            if (n - 1 - p != p) {
+                fillRow(n - 1 - p);
+            }
+        }
+    });
+}
+
+double RiskModel::risk(const std::vector<double>& weights) const
+{
+    // σ²(portfolio) = ΣΣw(i)w(j)σ(i)σ(j)ρ(i,j) = wᵀΣw
+    assert(weights.size() == m_symbols.size());
+    const auto sigmaW = m_covariance.multiply(weights);
+    double variance {};
+    for (std::size_t i = 0; i < weights.size(); ++i) {
+        variance += weights[i] * sigmaW[i];
+    }
+    return std::sqrt(std::max(0.0, variance));
+}
+
+double RiskModel::expectedReturn(const std::vector<double>& weights) const
+{
+    assert(weights.size() == m_returns.size());
+    double result {};
+    for (std::size_t i = 0; i < weights.size(); ++i) {
+        result += weights[i] * m_returns[i];
+    }
+    return result;
+}
+
+RiskContribution RiskModel::contributions(const std::vector<double>& weights) const
+{
+    assert(weights.size() == m_symbols.size());
+    const auto sigmaW = m_covariance.multiply(weights);
+
+    RiskContribution result;
+    double variance {};
+    double weightedRisk {};
+    for (std::size_t i = 0; i < weights.size(); ++i) {
+        variance += weights[i] * sigmaW[i];
+        weightedRisk += weights[i] * m_risks[i];
+    }
+    result.volatility = std::sqrt(std::max(0.0, variance));
+    result.marginal.resize(weights.size());
+    result.component.resize(weights.size());
+    if (result.volatility <= 0) {
+        return result;
+    }
+    for (std::size_t i = 0; i < weights.size(); ++i) {
+        result.marginal[i] = sigmaW[i] / result.volatility;
+        result.component[i] = weights[i] * result.marginal[i];
+    }
+    result.diversificationRatio = weightedRisk / result.volatility;
+    return result;
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#pragma once
+
+#include "Matrix.hpp"
+#include "RiskEstimator.hpp"
+
+#include <set>
+#include <string>
+#include <vector>
+
+namespace portopt {
+
+class Market;
+
+// Breakdown of a portfolio's volatility by asset
+struct RiskContribution {
+    double volatility {}; // σ(portfolio) = sqrt(wᵀΣw)
+    std::vector<double> marginal; // ∂σ/∂w(i) = (Σw)(i) / σ
+    std::vector<double> component; // w(i) * marginal(i), sums to volatility
+    double diversificationRatio {}; // Σw(i)σ(i) / σ
+};
+
+// Dense covariance matrix Σ(i,j) = σ(i)σ(j)ρ(i,j) of the assets of a market
+class RiskModel : public RiskEstimator {
+public:
+    /**
+     * @brief RiskModel Constructor
+     * @param market assets and their price history
+     * @param symbols assets to include (default: all), e.g. the holdings of a portfolio, unknown symbols are skipped
+     */
+    explicit RiskModel(const Market& market, const std::set<std::string>& symbols = {});
+
+    [[nodiscard]] const std::vector<std::string>& symbols() const noexcept override { return m_symbols; }
+    [[nodiscard]] const Matrix& covariance() const noexcept { return m_covariance; }
+    [[nodiscard]] const std::vector<double>& risks() const noexcept { return m_risks; } // σ(i)
+    [[nodiscard]] const std::vector<double>& expectedReturns() const noexcept { return m_returns; } // μ(i)
+
+    [[nodiscard]] double risk(const std::vector<double>& weights) const override; // σ(portfolio)
+    [[nodiscard]] double expectedReturn(const std::vector<double>& weights) const; // Σw(i)μ(i)
+    [[nodiscard]] RiskContribution contributions(const std::vector<double>& weights) const;
+
+private:
+    std::vector<std::string> m_symbols; // sorted (market order)
+    std::vector<double> m_risks;
+    std::vector<double> m_returns;
+    Matrix m_covariance;
+};
+
+} // namespace portopt
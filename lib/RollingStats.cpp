@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "RollingStats.hpp"
+#include "Market.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+using namespace portopt;
+
+void RollingWindow::add(double x, double y) noexcept
+{
+    m_count++;
+    const double n = static_cast<double>(m_count);
+    const double dx = x - m_meanX;
+    const double dy = y - m_meanY;
+    m_meanX += dx / n;
+    m_meanY += dy / n;
+    m_m2X += dx * (x - m_meanX);
+    m_m2Y += dy * (y - m_meanY);
+    m_cXY += dx * (y - m_meanY);
+}
+
+void RollingWindow::remove(double x, double y) noexcept
+{
+    assert(m_count > 0);
+    if (m_count <= 1) {
+        clear();
+        return;
+    }
+    m_count--;
+    const double n = static_cast<double>(m_count);
+    const double meanX = m_meanX;
+    const double meanY = m_meanY;
+    m_meanX -= (x - meanX) / n;
+    m_meanY -= (y - meanY) / n;
+    m_m2X -= (x - m_meanX) * (x - meanX);
+    m_m2Y -= (y - m_meanY) * (y - meanY);
+    m_cXY -= (x - m_meanX) * (y - meanY);
+}
+
+double RollingWindow::varianceX() const noexcept
+{
+    return m_count == 0 ? 0 : std::max(0.0, m_m2X) / static_cast<double>(m_count);
+}
+
+double RollingWindow::varianceY() const noexcept
+{
+    return m_count == 0 ? 0 : std::max(0.0, m_m2Y) / static_cast<double>(m_count);
+}
+
+double RollingWindow::covariance() const noexcept
+{
+    return m_count == 0 ? 0 : m_cXY / static_cast<double>(m_count);
+}
+
+double RollingWindow::correlation() const noexcept
+{
+    const double denominator = std::sqrt(std::max(0.0, m_m2X) * std::max(0.0, m_m2Y));
+    return denominator > 0 ? m_cXY / denominator : 0;
+}
+
+double RollingWindow::beta() const noexcept
+{
+    return m_m2Y > 0 ? m_cXY / m_m2Y : 0;
+}
+
+std::vector<double> RollingStats::mean(const std::vector<double>& x, std::size_t window)
+{
+    return RollingStats::slide(x.data(), nullptr, x.size(), window, [](const RollingWindow& rw) { return rw.meanX(); });
+}
+
+std::vector<double> RollingStats::stdDev(const std::vector<double>& x, std::size_t window)
+{
+    return RollingStats::slide(x.data(), nullptr, x.size(), window, [](const RollingWindow& rw) { return std::sqrt(rw.varianceX()); });
+}
+
+std::vector<double> RollingStats::correlation(const std::vector<double>& x, const std::vector<double>& y, std::size_t window)
+{
+    assert(x.size() == y.size());
+    const std::size_t n = std::min(x.size(), y.size());
+    return RollingStats::slide(x.data(), y.data(), n, window, [](const RollingWindow& rw) { return rw.correlation(); });
+}
+
+std::vector<double> RollingStats::beta(const std::vector<double>& x, const std::vector<double>& benchmark, std::size_t window)
+{
+    assert(x.size() == benchmark.size());
+    const std::size_t n = std::min(x.size(), benchmark.size());
+    return RollingStats::slide(x.data(), benchmark.data(), n, window, [](const RollingWindow& rw) { return rw.beta(); });
+}
+
+std::vector<RollingStats::PairSeries> RollingStats::correlation(const Market& market, std::size_t window, PriceType type)
+{
+    std::cerr << "RollingStats::correlation [window] " << window << "\n";
+
+    // daily returns of every asset with price history, computed once, each pair is aligned on its own common history
+    // instead of the market-wide ReturnMatrix so a young listing doesn't shorten every other pair
+    std::vector<std::string> symbols;
+    std::vector<std::vector<double>> returns;
+    for (const auto& [symbol, asset] : market.assets()) {
+        if (asset.ohlc().size() > window) {
+            symbols.push_back(symbol);
+            returns.push_back(asset.ohlc().returns(1, type));
+        }
+    }
+
+    std::vector<PairSeries> result;
+    std::vector<std::pair<std::size_t, std::size_t>> indexes;
+    for (std::size_t i = 0; i < symbols.size(); ++i) {
+        for (std::size_t j = i + 1; j < symbols.size(); ++j) {
+            result.push_back({ symbols[i], symbols[j], {} });
+            indexes.emplace_back(i, j);
+        }
+    }
+
+    Utils::parallelFor(result.size(), [&](std::size_t begin, std::size_t end) {
+        for (std::size_t k = begin; k < end; ++k) {
+            const auto [i, j] = indexes[k];
+            const auto& ohlc1 = market.get(symbols[i]).ohlc();
+            const auto& ohlc2 = market.get(symbols[j]).ohlc();
+            const std::size_t size = std::min(ohlc1.size(), ohlc2.size());
+            if (!ohlc1.matchTimePoint(ohlc2, size)) {
+                continue; // series are not aligned
+            }
+            result[k].values = RollingStats::slide(returns[i].data(), returns[j].data(), size - 1, window, [](const RollingWindow& rw) { return rw.correlation(); });
+        }
+    });
+    return result;
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#pragma once
+
+#include "OhlcEnums.hpp"
+
+#include <cassert>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace portopt {
+
+class Market;
+
+// Moments of one or two series over a sliding window with O(1) add/remove updates (Welford)
+class RollingWindow {
+public:
+    void add(double x, double y = 0) noexcept;
+    void remove(double x, double y = 0) noexcept;
+    void clear() noexcept { *this = {}; }
+
+    [[nodiscard]] std::size_t count() const noexcept { return m_count; }
+    [[nodiscard]] double meanX() const noexcept { return m_meanX; }
+    [[nodiscard]] double meanY() const noexcept { return m_meanY; }
+    [[nodiscard]] double varianceX() const noexcept; // population variance of x
+    [[nodiscard]] double varianceY() const noexcept; // population variance of y
+    [[nodiscard]] double covariance() const noexcept; // population covariance of x and y
+    [[nodiscard]] double correlation() const noexcept; // Pearson correlation of x and y
+    [[nodiscard]] double beta() const noexcept; // slope of x regressed on y
+
+private:
+    std::size_t m_count {};
+    double m_meanX {};
+    double m_meanY {};
+    double m_m2X {}; // sum of squared deviations of x
+    double m_m2Y {}; // sum of squared deviations of y
+    double m_cXY {}; // sum of co-deviations of x and y
+};
+
+// Full rolling series, result[i] is the statistic of the window [i, i + window)
+namespace RollingStats {
+
+    constexpr std::size_t resyncInterval = 1000; // rebuild the window from scratch every N slides to bound rounding drift
+
+    // stat(window) for every window of n values of x and y (nullptr for a single series), O(1) per slide
+    template <typename Stat>
+    auto slide(const double* x, const double* y, std::size_t n, std::size_t window, Stat stat) -> std::vector<std::invoke_result_t<Stat, const RollingWindow&>>
+    {
+        assert(window > 0);
+        if (window == 0 || n < window) {
+            return {};
+        }
+
+        const auto yAt = [y](std::size_t i) { return y == nullptr ? 0.0 : y[i]; };
+
+        const std::size_t size = n - window + 1;
+        std::vector<std::invoke_result_t<Stat, const RollingWindow&>> result;
+        result.reserve(size);
+
+        RollingWindow rw;
+        for (std::size_t i = 0; i < size; ++i) {
+            if (i % resyncInterval == 0) {
+                rw.clear();
+                for (std::size_t j = i; j < i + window; ++j) {
+                    rw.add(x[j], yAt(j));
+                }
+            } else {
+                rw.remove(x[i - 1], yAt(i - 1));
+                rw.add(x[i + window - 1], yAt(i + window - 1));
+            }
+            result.push_back(stat(rw));
+        }
+        return result;
+    }
+
+    std::vector<double> mean(const std::vector<double>& x, std::size_t window);
+    std::vector<double> stdDev(const std::vector<double>& x, std::size_t window);
+    std::vector<double> correlation(const std::vector<double>& x, const std::vector<double>& y, std::size_t window);
+    std::vector<double> beta(const std::vector<double>& x, const std::vector<double>& benchmark, std::size_t window);
+
+    struct PairSeries {
+        std::string symbol1;
+        std::string symbol2;
+        std::vector<double> values;
+    };
+
+    // Rolling correlation of the daily returns of every pair of assets with price history, over the history each pair shares
+    std::vector<PairSeries> correlation(const Market& market, std::size_t window, PriceType type);
+
+} // namespace RollingStats
+} // namespace portopt
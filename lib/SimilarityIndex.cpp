@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "SimilarityIndex.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <queue>
+#include <tuple>
+
+using namespace portopt;
+
+namespace {
+
+constexpr std::size_t abandonStep = 32; // values added between checks of the partial distance
+
+double toCorrelation(double squaredDistance)
+{
+    return std::clamp(1 - (squaredDistance / 2), -1.0, 1.0);
+}
+
+double toSquaredDistance(double correlation)
+{
+    return std::max(0.0, 2 * (1 - correlation));
+}
+
+} // anonymous namespace
+
+SimilarityIndex::SimilarityIndex(std::vector<std::string> symbols, const std::vector<std::vector<double>>& series, std::size_t numPivots)
+    : m_symbols { std::move(symbols) }
+    , m_valid(m_symbols.size())
+{
+    assert(m_symbols.size() == series.size());
+    const std::size_t length = series.empty() ? 0 : series.front().size();
+    m_vectors = Matrix(series.size(), length);
+
+    for (std::size_t i = 0; i < series.size(); ++i) {
+        m_index.insert({ m_symbols[i], i });
+        if (series[i].size() != length || length < 2) {
+            std::cerr << "SimilarityIndex::SimilarityIndex [length mismatch] " << m_symbols[i] << "\n";
+            continue;
+        }
+        const double mean = Utils::mean(series[i]);
+        double sumSq {};
+        for (const double value : series[i]) {
+            sumSq += (value - mean) * (value - mean);
+        }
+        if (sumSq <= 0) {
+            continue; // constant series has no correlation
+        }
+        const double scale = 1 / std::sqrt(sumSq);
+        double* row = m_vectors.row(i);
+        for (std::size_t t = 0; t < length; ++t) {
+            row[t] = (series[i][t] - mean) * scale;
+        }
+        m_valid[i] = true;
+    }
+
+    // pivots spread over the valid series
+    std::vector<std::size_t> valid;
+    for (std::size_t i = 0; i < size(); ++i) {
+        if (m_valid[i]) {
+            valid.push_back(i);
+        }
+    }
+    numPivots = std::min(numPivots, valid.size());
+    m_pivotDistance = Matrix(size(), numPivots);
+    Utils::parallelFor(size(), [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            for (std::size_t p = 0; p < numPivots && m_valid[i]; ++p) {
+                const std::size_t pivot = valid[p * valid.size() / numPivots];
+                m_pivotDistance(i, p) = std::sqrt(squaredDistance(i, pivot, 4));
+            }
+        }
+    });
+}
+
+std::size_t SimilarityIndex::index(const std::string& symbol) const
+{
+    const auto itr = m_index.find(symbol);
+    return itr == m_index.end() ? npos : itr->second;
+}
+
+double SimilarityIndex::correlation(std::size_t i, std::size_t j) const
+{
+    if (!m_valid[i] || !m_valid[j]) {
+        return 0;
+    }
+    return toCorrelation(squaredDistance(i, j, 4));
+}
+
+double SimilarityIndex::lowerBound(std::size_t i, std::size_t j) const
+{
+    double result {};
+    for (std::size_t p = 0; p < m_pivotDistance.cols(); ++p) {
+        result = std::max(result, std::abs(m_pivotDistance(i, p) - m_pivotDistance(j, p)));
+    }
+    return result;
+}
+
+double SimilarityIndex::squaredDistance(std::size_t i, std::size_t j, double limit) const
+{
+    const double* x = m_vectors.row(i);
+    const double* y = m_vectors.row(j);
+    const std::size_t length = m_vectors.cols();
+    double result {};
+    for (std::size_t begin = 0; begin < length; begin += abandonStep) {
+        const std::size_t end = std::min(begin + abandonStep, length);
+        for (std::size_t t = begin; t < end; ++t) {
+            const double diff = x[t] - y[t];
+            result += diff * diff;
+        }
+        if (result > limit) {
+            return result; // early abandon
+        }
+    }
+    return result;
+}
+
+std::vector<SimilarityIndex::Match> SimilarityIndex::topK(std::size_t query, std::size_t k, double minCorrelation) const
+{
+    if (query >= size() || !m_valid[query] || k == 0) {
+        return {};
+    }
+
+    // visit candidates by increasing lower bound, stop once the bound can't beat the k-th best distance
+    std::vector<std::pair<double, std::size_t>> candidates; // {lower bound, index}
+    candidates.reserve(size());
+    const double radius = std::sqrt(toSquaredDistance(minCorrelation));
+    for (std::size_t j = 0; j < size(); ++j) {
+        if (j != query && m_valid[j]) {
+            const double bound = lowerBound(query, j);
+            if (bound <= radius) {
+                candidates.emplace_back(bound, j);
+            }
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    std::priority_queue<std::pair<double, std::size_t>> best; // max-heap of {squared distance, index}
+    double limit = toSquaredDistance(minCorrelation);
+    for (const auto& [bound, j] : candidates) {
+        if (bound * bound > limit) {
+            break;
+        }
+        const double distance = squaredDistance(query, j, limit);
+        if (distance > limit) {
+            continue;
+        }
+        best.emplace(distance, j);
+        if (best.size() > k) {
+            best.pop();
+        }
+        if (best.size() == k) {
+            limit = best.top().first;
+        }
+    }
+
+    std::vector<Match> result(best.size());
+    for (auto itr = result.rbegin(); itr != result.rend(); ++itr) {
+        *itr = { best.top().second, toCorrelation(best.top().first) };
+        best.pop();
+    }
+    return result;
+}
+
+std::vector<std::vector<SimilarityIndex::Match>> SimilarityIndex::allTopK(std::size_t k, double minCorrelation) const
+{
+    std::vector<std::vector<Match>> result(size());
+    if (minCorrelation > 0) {
+        // a positive threshold leaves few pairs, compute each of them once and select per series
+        for (const auto& pair : pairsAbove(minCorrelation)) {
+            auto& first = result[pair.first];
+            auto& second = result[pair.second];
+            if (first.size() < k) {
+                first.push_back({ pair.second, pair.correlation });
+            }
+            if (second.size() < k) {
+                second.push_back({ pair.first, pair.correlation });
+            }
+        }
+        return result; // pairs are already in descending order
+    }
+    Utils::parallelFor(size(), [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            result[i] = topK(i, k, minCorrelation);
+        }
+    });
+    return result;
+}
+
+std::vector<SimilarityIndex::Pair> SimilarityIndex::pairsAbove(double tau) const
+{
+    const double limit = toSquaredDistance(tau);
+    const double radius = std::sqrt(limit);
+
+    // sorted by distance to the first pivot, only a window of that order can be within the radius
+    std::vector<std::size_t> order;
+    for (std::size_t i = 0; i < size(); ++i) {
+        if (m_valid[i]) {
+            order.push_back(i);
+        }
+    }
+    if (m_pivotDistance.cols() > 0) {
+        std::sort(order.begin(), order.end(), [this](std::size_t a, std::size_t b) { return m_pivotDistance(a, 0) < m_pivotDistance(b, 0); });
+    }
+
+    std::vector<Pair> result;
+    std::mutex mutex;
+    Utils::parallelFor(order.size(), [&](std::size_t begin, std::size_t end) {
+        std::vector<Pair> local;
+        for (std::size_t a = begin; a < end; ++a) {
+            const std::size_t i = order[a];
+            for (std::size_t b = a + 1; b < order.size(); ++b) {
+                const std::size_t j = order[b];
+                if (m_pivotDistance.cols() > 0 && m_pivotDistance(j, 0) - m_pivotDistance(i, 0) > radius) {
+                    break; // every later series is even farther from the first pivot
+                }
+                if (lowerBound(i, j) > radius) {
+                    continue;
+                }
+                const double distance = squaredDistance(i, j, limit);
+                if (distance <= limit) {
+                    local.push_back({ std::min(i, j), std::max(i, j), toCorrelation(distance) });
+                }
+            }
+        }
+        const std::scoped_lock lock { mutex };
+        result.insert(result.end(), local.begin(), local.end());
+    });
+
+    std::sort(result.begin(), result.end(), [](const Pair& a, const Pair& b) {
+        return a.correlation != b.correlation ? a.correlation > b.correlation : std::tie(a.first, a.second) < std::tie(b.first, b.second);
+    });
+    return result;
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#pragma once
+
+#include "Matrix.hpp"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace portopt {
+
+// Finds the most correlated series without computing the full correlation matrix
+//
+// Series are z-normalized to unit vectors, so correlation = 1 - distance^2 / 2 and a correlation threshold is a
+// distance radius. Distances to a few pivots give triangle-inequality lower bounds that skip most pairs, and the
+// remaining distances are abandoned as soon as their partial sum exceeds the radius.
+class SimilarityIndex {
+public:
+    struct Match {
+        std::size_t index {};
+        double correlation {};
+    };
+
+    struct Pair {
+        std::size_t first {}; // first < second
+        std::size_t second {};
+        double correlation {};
+    };
+
+    // All series must have the same length, constant series never match anything
+    SimilarityIndex(std::vector<std::string> symbols, const std::vector<std::vector<double>>& series, std::size_t numPivots = 16);
+
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    [[nodiscard]] std::size_t size() const noexcept { return m_symbols.size(); }
+    [[nodiscard]] const std::vector<std::string>& symbols() const noexcept { return m_symbols; }
+    [[nodiscard]] std::size_t index(const std::string& symbol) const; // npos if not indexed
+    [[nodiscard]] double correlation(std::size_t i, std::size_t j) const; // Pearson correlation
+
+    // Up to k most correlated series with correlation >= minCorrelation, in descending order, excluding the query
+    [[nodiscard]] std::vector<Match> topK(std::size_t query, std::size_t k, double minCorrelation = -1) const;
+    [[nodiscard]] std::vector<std::vector<Match>> allTopK(std::size_t k, double minCorrelation = -1) const; // topK of every series, in parallel
+
+    // Every pair with correlation >= tau, in descending order
+    [[nodiscard]] std::vector<Pair> pairsAbove(double tau) const;
+
+private:
+    [[nodiscard]] double lowerBound(std::size_t i, std::size_t j) const; // on the distance, from the pivots
+    [[nodiscard]] double squaredDistance(std::size_t i, std::size_t j, double limit) const; // > limit if abandoned
+
+    std::vector<std::string> m_symbols;
+    std::unordered_map<std::string, std::size_t> m_index;
+    Matrix m_vectors; // z-normalized unit vectors, one per row
+    std::vector<bool> m_valid; // false for constant series
+    Matrix m_pivotDistance; // series x pivots
+};
+
+} // namespace portopt
@@ -0,0 +1,301 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "TiledCorrelation.hpp"
+#include "MappedFile.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <queue>
+#include <tuple>
+
+using namespace portopt;
+
+namespace {
+
+struct MappedMatrix {
+    std::unique_ptr<MappedFile> file;
+    float* data {}; // nullptr on failure
+};
+
+// Saves the writer with a zero filled float32 "correlation" column and maps it to be filled in
+MappedMatrix createMatrix(ColumnFileWriter& writer, std::vector<std::size_t> shape, const FilePath& filePath)
+{
+    MappedMatrix result;
+    writer.reserve("correlation", ColumnFile::Type::Float32, std::move(shape));
+    if (!writer.save(filePath)) {
+        return result;
+    }
+    const ColumnFile layout { filePath };
+    const auto* column = layout.find("correlation");
+    result.file = std::make_unique<MappedFile>(filePath, MappedFile::Mode::ReadWrite);
+    if (column == nullptr || result.file->writableData() == nullptr) {
+        std::cerr << "TiledCorrelation [failed to map] " << filePath << "\n";
+        return result;
+    }
+    result.data = reinterpret_cast<float*>(result.file->writableData() + column->offset);
+    return result;
+}
+
+} // anonymous namespace
+
+TiledCorrelation::TiledCorrelation(const FilePath& returnsPath, std::size_t memoryBudget)
+    : m_file { returnsPath }
+{
+    if (!m_file.isOpen()) {
+        return;
+    }
+    const auto* returns = m_file.find("returns");
+    if (returns == nullptr || returns->shape.size() != 2) {
+        std::cerr << "TiledCorrelation::TiledCorrelation [not a return cache] " << returnsPath << "\n";
+        return;
+    }
+    for (const auto symbol : m_file.strings("symbols")) {
+        m_symbols.emplace_back(symbol);
+    }
+    m_returns = m_file.float64("returns");
+    m_numPeriods = returns->shape[1];
+    if (m_symbols.size() != returns->shape[0]) {
+        std::cerr << "TiledCorrelation::TiledCorrelation [symbols mismatch] " << returnsPath << "\n";
+        return;
+    }
+
+    // row block, column block and its transpose (3 * B * T) plus one tile (B * B), in doubles
+    const double t = static_cast<double>(m_numPeriods);
+    const double budget = static_cast<double>(memoryBudget) / sizeof(double);
+    const double size = (-3 * t + std::sqrt((9 * t * t) + (4 * budget))) / 2;
+    if (size < 1) {
+        std::cerr << "TiledCorrelation::TiledCorrelation [budget too small] " << memoryBudget << " bytes, one asset per block needs "
+                  << static_cast<std::size_t>(((3 * t) + 1) * sizeof(double)) << "\n";
+    }
+    m_blockSize = std::clamp<std::size_t>(static_cast<std::size_t>(size), 1, std::max<std::size_t>(1, m_symbols.size()));
+    std::cerr << "TiledCorrelation::TiledCorrelation [assets] " << m_symbols.size() << " [periods] " << m_numPeriods
+              << " [block] " << m_blockSize << "\n";
+    m_open = true;
+}
+
+Matrix TiledCorrelation::loadBlock(std::size_t begin, std::size_t end) const
+{
+    Matrix result(end - begin, m_numPeriods);
+    for (std::size_t a = begin; a < end; ++a) {
+        const double* in = m_returns.data() + (a * m_numPeriods);
+        double mean {};
+        for (std::size_t t = 0; t < m_numPeriods; ++t) {
+            mean += in[t];
+        }
+        mean /= static_cast<double>(m_numPeriods);
+        double sumSq {};
+        for (std::size_t t = 0; t < m_numPeriods; ++t) {
+            sumSq += (in[t] - mean) * (in[t] - mean);
+        }
+        const double scale = sumSq > 0 ? 1 / std::sqrt(sumSq) : 0; // constant series correlate with nothing
+        double* out = result.row(a - begin);
+        for (std::size_t t = 0; t < m_numPeriods; ++t) {
+            out[t] = (in[t] - mean) * scale;
+        }
+    }
+    return result;
+}
+
+void TiledCorrelation::forEachTile(const TileFunction& func) const
+{
+    forEachTile(func, { 0, numAssets() });
+}
+
+void TiledCorrelation::forEachTile(const TileFunction& func, std::pair<std::size_t, std::size_t> rows) const
+{
+    assert(rows.first % m_blockSize == 0);
+    const std::size_t n = numAssets();
+    for (std::size_t rowBegin = rows.first; rowBegin < std::min(rows.second, n); rowBegin += m_blockSize) {
+        const std::size_t rowEnd = std::min(rowBegin + m_blockSize, n);
+        const Matrix rows = loadBlock(rowBegin, rowEnd);
+        for (std::size_t colBegin = rowBegin; colBegin < n; colBegin += m_blockSize) {
+            const std::size_t colEnd = std::min(colBegin + m_blockSize, n);
+            const Matrix cols = colBegin == rowBegin ? rows.transposed() : loadBlock(colBegin, colEnd).transposed();
+            func(rowBegin, colBegin, Matrix::multiply(rows, cols));
+        }
+    }
+}
+
+std::pair<std::size_t, std::size_t> TiledCorrelation::shardRows(std::size_t shard, std::size_t numShards) const
+{
+    assert(shard < numShards);
+    // block row b has numBlocks - b tiles, a shard starts at the first block row with shard / numShards of the
+    // tiles before it
+    const std::size_t numBlocks = (numAssets() + m_blockSize - 1) / m_blockSize;
+    const std::size_t numTiles = numBlocks * (numBlocks + 1) / 2;
+    const auto firstBlock = [&](std::size_t s) {
+        std::size_t block {};
+        for (std::size_t tiles {}; block < numBlocks && tiles * numShards < numTiles * s; ++block) {
+            tiles += numBlocks - block;
+        }
+        return block;
+    };
+    return { std::min(firstBlock(shard) * m_blockSize, numAssets()), std::min(firstBlock(shard + 1) * m_blockSize, numAssets()) };
+}
+
+bool TiledCorrelation::saveMatrix(const FilePath& filePath) const
+{
+    const std::size_t n = numAssets();
+    ColumnFileWriter writer;
+    writer.add("symbols", m_symbols);
+    const auto output = createMatrix(writer, { n, n }, filePath);
+    if (output.data == nullptr) {
+        return false;
+    }
+    float* matrix = output.data;
+
+    forEachTile([&](std::size_t rowBegin, std::size_t colBegin, const Matrix& tile) {
+        for (std::size_t r = 0; r < tile.rows(); ++r) {
+            for (std::size_t c = 0; c < tile.cols(); ++c) {
+                const std::size_t i = rowBegin + r;
+                const std::size_t j = colBegin + c;
+                const auto value = static_cast<float>(i == j ? 1 : tile(r, c));
+                matrix[(i * n) + j] = value;
+                matrix[(j * n) + i] = value;
+            }
+        }
+    });
+    return true;
+}
+
+bool TiledCorrelation::saveShard(const FilePath& filePath, std::size_t shard, std::size_t numShards) const
+{
+    const std::size_t n = numAssets();
+    const auto rows = shardRows(shard, numShards);
+    ColumnFileWriter writer;
+    writer.add("symbols", m_symbols);
+    writer.add("rows", std::vector<std::uint64_t> { rows.first, rows.second });
+    const auto output = createMatrix(writer, { rows.second - rows.first, n }, filePath);
+    if (output.data == nullptr) {
+        return false;
+    }
+    float* matrix = output.data;
+
+    forEachTile(
+        [&](std::size_t rowBegin, std::size_t colBegin, const Matrix& tile) {
+            for (std::size_t r = 0; r < tile.rows(); ++r) {
+                const std::size_t i = rowBegin + r;
+                for (std::size_t c = 0; c < tile.cols(); ++c) {
+                    const std::size_t j = colBegin + c;
+                    matrix[((i - rows.first) * n) + j] = static_cast<float>(i == j ? 1 : tile(r, c));
+                }
+            }
+        },
+        rows);
+    return true;
+}
+
+bool TiledCorrelation::mergeShards(const std::vector<FilePath>& shardPaths, const FilePath& filePath)
+{
+    std::vector<ColumnFile> shards;
+    std::vector<std::string_view> symbols;
+    std::size_t nextRow {};
+    for (const auto& shardPath : shardPaths) {
+        const auto& shard = shards.emplace_back(shardPath);
+        const auto rows = shard.uint64("rows");
+        const auto* column = shard.find("correlation");
+        if (shards.size() == 1) {
+            symbols = shard.strings("symbols");
+        }
+        if (!shard.isOpen() || rows.size() != 2 || rows[0] != nextRow || shard.strings("symbols") != symbols || column == nullptr
+            || column->type != ColumnFile::Type::Float32 || column->shape != std::vector<std::size_t> { rows[1] - rows[0], symbols.size() }) {
+            std::cerr << "TiledCorrelation::mergeShards [invalid shard] " << shardPath << "\n";
+            return false;
+        }
+        nextRow = rows[1];
+    }
+    const std::size_t n = symbols.size();
+    if (n == 0) {
+        std::cerr << "TiledCorrelation::mergeShards [no symbols] " << shardPaths.size() << " shards\n";
+        return false;
+    }
+    if (nextRow != n) {
+        std::cerr << "TiledCorrelation::mergeShards [missing rows] " << nextRow << " of " << n << "\n";
+        return false;
+    }
+
+    ColumnFileWriter writer;
+    writer.add("symbols", std::vector<std::string> { symbols.begin(), symbols.end() });
+    const auto output = createMatrix(writer, { n, n }, filePath);
+    if (output.data == nullptr) {
+        return false;
+    }
+    float* matrix = output.data;
+
+    for (const auto& shard : shards) {
+        const std::size_t rowBegin = shard.uint64("rows")[0];
+        const auto values = shard.float32("correlation");
+        for (std::size_t r = 0; r < values.size() / n; ++r) {
+            const std::size_t i = rowBegin + r;
+            for (std::size_t j = i; j < n; ++j) {
+                matrix[(i * n) + j] = values[(r * n) + j];
+                matrix[(j * n) + i] = values[(r * n) + j];
+            }
+        }
+    }
+    return true;
+}
+
+std::vector<std::vector<SimilarityIndex::Match>> TiledCorrelation::topK(std::size_t k, double minCorrelation) const
+{
+    // min-heap of the k best matches of each asset
+    const auto worse = [](const SimilarityIndex::Match& a, const SimilarityIndex::Match& b) { return a.correlation > b.correlation; };
+    std::vector<std::vector<SimilarityIndex::Match>> heaps(numAssets());
+    const auto offer = [&](std::size_t i, std::size_t j, double correlation) {
+        auto& heap = heaps[i];
+        if (heap.size() < k) {
+            heap.push_back({ j, correlation });
+            std::push_heap(heap.begin(), heap.end(), worse);
+        } else if (k > 0 && correlation > heap.front().correlation) {
+            std::pop_heap(heap.begin(), heap.end(), worse);
+            heap.back() = { j, correlation };
+            std::push_heap(heap.begin(), heap.end(), worse);
+        }
+    };
+
+    forEachTile([&](std::size_t rowBegin, std::size_t colBegin, const Matrix& tile) {
+        for (std::size_t r = 0; r < tile.rows(); ++r) {
+            for (std::size_t c = 0; c < tile.cols(); ++c) {
+                const std::size_t i = rowBegin + r;
+                const std::size_t j = colBegin + c;
+                if (i < j && tile(r, c) >= minCorrelation) {
+                    offer(i, j, tile(r, c));
+                    offer(j, i, tile(r, c));
+                }
+            }
+        }
+    });
+
+    for (auto& heap : heaps) {
+        std::sort_heap(heap.begin(), heap.end(), worse); // descending correlation
+    }
+    return heaps;
+}
+
+std::vector<SimilarityIndex::Pair> TiledCorrelation::pairsAbove(double tau) const
+{
+    std::vector<SimilarityIndex::Pair> result;
+    forEachTile([&](std::size_t rowBegin, std::size_t colBegin, const Matrix& tile) {
+        for (std::size_t r = 0; r < tile.rows(); ++r) {
+            for (std::size_t c = 0; c < tile.cols(); ++c) {
+                const std::size_t i = rowBegin + r;
+                const std::size_t j = colBegin + c;
+                if (i < j && tile(r, c) >= tau) {
+                    result.push_back({ i, j, tile(r, c) });
+                }
+            }
+        }
+    });
+    std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) {
+        return a.correlation != b.correlation ? a.correlation > b.correlation : std::tie(a.first, a.second) < std::tie(b.first, b.second);
+    });
+    return result;
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#pragma once
+
+#include "ColumnFile.hpp"
+#include "Matrix.hpp"
+#include "SimilarityIndex.hpp"
+
+#include <functional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace portopt {
+
+// Correlation matrix of a return cache (ReturnMatrix::save) computed one tile at a time
+//
+// Returns are read from the memory mapped cache a block of assets at a time, so only two normalized blocks and one
+// tile are held in memory. Their size is chosen to fit the memory budget. Results are written to a memory mapped
+// file or reduced on the fly, the reductions (top-K lists, pairs above a threshold) come on top of the budget.
+//
+// The rows can also be split into shards computed by separate processes, possibly on other machines sharing the
+// files. Each one saves its rows with saveShard and mergeShards assembles the full matrix from the partial files.
+class TiledCorrelation {
+public:
+    TiledCorrelation(const FilePath& returnsPath, std::size_t memoryBudget);
+
+    [[nodiscard]] bool isOpen() const noexcept { return m_open; }
+    [[nodiscard]] const std::vector<std::string>& symbols() const noexcept { return m_symbols; }
+    [[nodiscard]] std::size_t numAssets() const noexcept { return m_symbols.size(); }
+    [[nodiscard]] std::size_t numPeriods() const noexcept { return m_numPeriods; }
+    [[nodiscard]] std::size_t blockSize() const noexcept { return m_blockSize; } // assets per block
+
+    // Tile with rows [rowBegin, rowBegin + tile.rows()) and columns [colBegin, colBegin + tile.cols()), only tiles
+    // on or above the diagonal are visited (rowBegin <= colBegin) since the matrix is symmetric
+    using TileFunction = std::function<void(std::size_t rowBegin, std::size_t colBegin, const Matrix& tile)>;
+    void forEachTile(const TileFunction& func) const;
+    void forEachTile(const TileFunction& func, std::pair<std::size_t, std::size_t> rows) const; // block aligned rows
+
+    // Block aligned rows [first, second) of a shard, shards get about the same number of tiles
+    [[nodiscard]] std::pair<std::size_t, std::size_t> shardRows(std::size_t shard, std::size_t numShards) const;
+
+    bool saveMatrix(const FilePath& filePath) const; // ColumnFile with "symbols" and a float32 N x N "correlation"
+    bool saveShard(const FilePath& filePath, std::size_t shard, std::size_t numShards) const; // rows on and above the diagonal
+    static bool mergeShards(const std::vector<FilePath>& shardPaths, const FilePath& filePath); // same file as saveMatrix
+    [[nodiscard]] std::vector<std::vector<SimilarityIndex::Match>> topK(std::size_t k, double minCorrelation = -1) const;
+    [[nodiscard]] std::vector<SimilarityIndex::Pair> pairsAbove(double tau) const; // descending order
+
+private:
+    [[nodiscard]] Matrix loadBlock(std::size_t begin, std::size_t end) const; // z-normalized unit rows
+
+    ColumnFile m_file;
+    std::span<const double> m_returns; // asset-major, straight from the mapping
+    std::vector<std::string> m_symbols;
+    std::size_t m_numPeriods {};
+    std::size_t m_blockSize {};
+    bool m_open {};
+};
+
+} // namespace portopt
@@ -15,4 +15,10 @@ namespace portopt {
 // using TimePoint = std::chrono::time_point<std::chrono::system_clock>;
 using TimePoint = std::chrono::system_clock::time_point;
 
+// Closed interval of dates [minDate, maxDate]
+struct DateRange {
+    TimePoint minDate {};
+    TimePoint maxDate {};
+};
+
 } // namespace portopt
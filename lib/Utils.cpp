@@ -8,17 +8,25 @@
 #include "Utils.hpp"
 
 #include "EnumUtils.hpp"
+#include "FactorModel.hpp"
 #include "Market.hpp"
 #include "Portfolio.hpp"
+#include "ReportWriter.hpp"
+#include "RiskModel.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <cctype>
+#include <charconv>
 #include <cmath>
-#include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <numbers>
 #include <numeric>
+#include <set>
 #include <sstream>
+#include <thread>
 
 using namespace portopt;
 using namespace portopt::Utils;
@@ -63,6 +71,55 @@ TimePoint Utils::toTimePoint(const std::string& str)
 #endif
 }
 
+std::string Utils::toDateTimeString(const TimePoint& tp)
+{
+    const auto tt = std::chrono::system_clock::to_time_t(tp);
+
+    std::tm tmbuf {};
+    std::tm* const tm = localtime_r(&tt, &tmbuf);
+    assert(tm != nullptr);
+
+    std::ostringstream oss;
+    oss << std::put_time(tm, "%F %T");
+    return oss.str();
+}
+
+TimePoint Utils::toDateTime(const std::string& str)
+{
+    assert(str.size() >= 10); // "YYYY-MM-DD"
+    if (str.size() < 16) {
+        return toTimePoint(str); // a date, local midnight like the daily bars
+    }
+    const auto number = [&str](size_t pos) {
+        int value {};
+        std::from_chars(str.data() + pos, str.data() + pos + 2, value);
+        return value;
+    };
+
+    std::tm tm {};
+    std::istringstream iss(str.substr(0, 10));
+    iss >> std::get_time(&tm, "%Y-%m-%d");
+    tm.tm_hour = number(11); // after ' ' or 'T'
+    tm.tm_min = number(14);
+    size_t pos = 16;
+    if (str.size() >= 19 && str[16] == ':') {
+        tm.tm_sec = number(17);
+        pos = 19;
+    }
+    while (pos < str.size() && (str[pos] == '.' || std::isdigit(static_cast<unsigned char>(str[pos])) != 0)) {
+        pos++; // fractional seconds
+    }
+
+    if (pos < str.size() && (str[pos] == 'Z' || ((str[pos] == '+' || str[pos] == '-') && str.size() >= pos + 6))) {
+        // UTC offset of the exchange, e.g. "2024-12-13 09:30:00-05:00" from yfinance
+        const int sign = str[pos] == '-' ? -1 : 1;
+        const int offset = str[pos] == 'Z' ? 0 : sign * (number(pos + 1) * 3600 + number(pos + 4) * 60);
+        return std::chrono::system_clock::from_time_t(timegm(&tm) - offset);
+    }
+    tm.tm_isdst = -1;
+    return std::chrono::system_clock::from_time_t(std::mktime(&tm));
+}
+
 std::string Utils::join(const std::vector<std::string>& list, const std::string& delim)
 {
     std::string result;
@@ -202,25 +259,49 @@ std::size_t Utils::powi(std::size_t base, std::size_t exp)
     return result;
 }
 
-double Utils::avgRisk(const Market& market, const Portfolio& portfolio)
+void Utils::parallelFor(std::size_t count, const std::function<void(std::size_t begin, std::size_t end)>& func)
 {
-    // σ²(portfolio) = ΣΣw(i)w(j)σ(i)σ(j)ρ(i,j)
-    const auto total = totalValue(market, portfolio, 0);
-    if (total <= 0) {
-        return 0;
+    const std::size_t numThreads = std::min<std::size_t>(std::max(1U, std::thread::hardware_concurrency()), count);
+    if (numThreads <= 1) {
+        func(0, count);
+        return;
     }
-    double result {};
-    for (const auto& [symbol1, quantity1] : portfolio.holdings()) {
-        const auto& asset1 = market.get(symbol1);
-        const double value1 = asset1.ohlc().at(0).hl2() * quantity1;
-        for (const auto& [symbol2, quantity2] : portfolio.holdings()) {
-            const auto& asset2 = market.get(symbol2);
-            const double value2 = asset2.ohlc().at(0).hl2() * quantity2;
-            const double corr = symbol1 == symbol2 ? 1 : asset1.correlation(asset2, PriceType::HL2, false, 400);
-            result += (value1 / total) * (value2 / total) * corr * asset1.avgRisk(0) * asset2.avgRisk(0);
+    const std::size_t blockSize = (count + numThreads - 1) / numThreads;
+    std::vector<std::jthread> threads;
+    threads.reserve(numThreads);
+    for (std::size_t begin = 0; begin < count; begin += blockSize) {
+        threads.emplace_back(func, begin, std::min(begin + blockSize, count));
+    }
+}
+
+double Utils::avgRisk(const Market& market, const Portfolio& portfolio, RiskBackend backend)
+{
+    // σ²(portfolio) = ΣΣw(i)w(j)σ(i)σ(j)ρ(i,j) over the holdings only
+    std::set<std::string> symbols;
+    for (const auto& [symbol, quantity] : portfolio.holdings()) {
+        if (market.assets().contains(symbol)) { // CASH and unknown symbols carry no risk
+            symbols.insert(symbol);
+        }
+    }
+    if (symbols.empty()) {
+        return 0; // an empty set would select the whole market
+    }
+    if (backend == RiskBackend::Factor) {
+        const FactorModel& model = market.factorModel(defaultFactors);
+        for (const std::string& symbol : symbols) {
+            if (model.index(symbol) == RiskEstimator::npos) { // weights() would drop it and understate the risk
+                std::cerr << "Utils::avgRisk [holding missing from the factor model] " << symbol << "\n";
+                return std::numeric_limits<double>::quiet_NaN();
+            }
         }
+        return avgRisk(market, portfolio, model);
     }
-    return std::sqrt(result);
+    return avgRisk(market, portfolio, RiskModel { market, symbols });
+}
+
+double Utils::avgRisk(const Market& market, const Portfolio& portfolio, const RiskEstimator& estimator)
+{
+    return estimator.risk(estimator.weights(market, portfolio));
 }
 
 double Utils::avgRisk(const Market& market, const Portfolio& portfolio, int length)
@@ -264,8 +345,8 @@ double Utils::avgReturn(const Market& market, const Portfolio& portfolio, int le
 void Utils::saveAllocations(const Market& market, const Portfolio& portfolio, const std::string& filePath)
 {
     std::cerr << "\nPortfolio::saveAllocations\n";
-    std::ofstream outFile(filePath, std::ios::out | std::ios::trunc);
-    if (!outFile.is_open()) {
+    ReportWriter outFile { filePath };
+    if (!outFile.isOpen()) {
         std::cerr << "Portfolio::saveAllocations [FAILED TO OPEN FILE] " << filePath << "\n";
     }
 
@@ -276,16 +357,16 @@ void Utils::saveAllocations(const Market& market, const Portfolio& portfolio, co
     // Body
     for (AssetClass tag = AssetClass::Unclassified; tag < AssetClass::LastTag; tag = static_cast<AssetClass>(static_cast<int>(tag) + 1)) {
         const auto value = totalValue(market, portfolio, tag);
-        outFile << EnumUtils::to_string(tag) << ","
-                << value.first << ","
-                << std::round(10000.0 * value.first / total) / 100 << ","
+        outFile << EnumUtils::to_string(tag) << ','
+                << value.first << ','
+                << std::round(10000.0 * value.first / total) / 100 << ','
                 << value.second.size();
         for (const auto& symbol : value.second) {
-            outFile << "," << symbol;
+            outFile << ',' << symbol;
         }
-        outFile << "\n";
+        outFile << '\n';
     }
-    outFile << "Total," << total << ",100," << portfolio.holdings().size() << "\n";
+    outFile << "Total," << total << ",100," << portfolio.holdings().size() << '\n';
 }
 
 double Utils::totalValue(const Market& market, const Portfolio& portfolio, std::size_t i)
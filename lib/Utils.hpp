@@ -10,6 +10,7 @@
 #include "AssetEnums.hpp"
 #include "TimePoint.hpp"
 
+#include <functional>
 #include <set>
 #include <string>
 #include <utility>
@@ -19,14 +20,27 @@ namespace portopt {
 
 class Market;
 class Portfolio;
+class RiskEstimator;
 
 namespace Utils {
 
     std::string to_string(const TimePoint& tp);
     TimePoint toTimePoint(const std::string& str);
+    std::string toDateTimeString(const TimePoint& tp); // "YYYY-MM-DD HH:MM:SS" in local time
+    TimePoint toDateTime(const std::string& str); // "YYYY-MM-DD[ HH:MM[:SS]][+HH:MM]", local time without an offset
     std::string join(const std::vector<std::string>& list, const std::string& delim);
 
-    double avgRisk(const Market& market, const Portfolio& portfolio);
+    // Covariance estimate behind avgRisk: the dense RiskModel of the holdings correlates every pair of price histories in
+    // O(n²), the market's cached FactorModel of the daily returns costs O(N k) per portfolio once built. Both estimate a
+    // different covariance, so the factor model is never picked implicitly
+    enum class RiskBackend {
+        Dense,
+        Factor,
+    };
+    constexpr std::size_t defaultFactors = 20;
+
+    double avgRisk(const Market& market, const Portfolio& portfolio, RiskBackend backend = RiskBackend::Dense);
+    double avgRisk(const Market& market, const Portfolio& portfolio, const RiskEstimator& estimator); // e.g. market.ewmaCovariance(λ)
     double avgReturn(const Market& market, const Portfolio& portfolio);
     double avgRisk(const Market& market, const Portfolio& portfolio, int length);
     double avgReturn(const Market& market, const Portfolio& portfolio, int length);
@@ -49,5 +63,8 @@ namespace Utils {
     double doublingTime(double ratePercent);
     std::size_t powi(std::size_t base, std::size_t exp);
 
+    // Split [0, count) into contiguous blocks and run func(begin, end) for each block on its own thread
+    void parallelFor(std::size_t count, const std::function<void(std::size_t begin, std::size_t end)>& func);
+
 } // namespace Utils
 } // namespace portopt
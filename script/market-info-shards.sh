@@ -0,0 +1,22 @@
+#!/bin/bash
+set -euo pipefail
+
+# usage: script/market-info-shards.sh numShards [directory] [--tiled budgetMiB]
+#
+# Runs market-info as numShards local processes and merges their partial results. On several machines sharing the
+# data directory run "market-info --shard i/n" once for every i on any of them, then "market-info --merge n".
+
+MARKET_INFO=${MARKET_INFO:-./build/src/market-info}
+NUM_SHARDS=$1
+shift
+
+PIDS=()
+for ((i = 0; i < NUM_SHARDS; i++)); do
+    "$MARKET_INFO" "$@" --shard "$i/$NUM_SHARDS" > "/tmp/market-info-shard-$i.log" 2>&1 &
+    PIDS+=($!)
+done
+for PID in "${PIDS[@]}"; do
+    wait "$PID"
+done
+
+"$MARKET_INFO" "$@" --merge "$NUM_SHARDS"
@@ -5,155 +5,93 @@
  * license that can be found in the LICENSE file
  */
 
+#include "lib/ArbitrageGraph.hpp"
+#include "lib/ArbitrageMonitor.hpp"
 #include "lib/CsvFile.hpp"
 
 #include <algorithm>
-#include <cassert>
-#include <cmath>
-#include <filesystem>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
-#include <limits>
-#include <map>
-#include <set>
-#include <vector>
+#include <string>
 
 using namespace portopt;
 
-using Weights = std::map<std::pair<std::string, std::string>, double>; // {from, to} -> rate
-
 namespace {
 
-void print(const Weights& table)
+void print(const ArbitrageGraph& graph)
 {
-    std::cout << "table.size: " << table.size() << "\n";
-    for (const auto& item : table) {
-        std::cout << item.first.first << " -> " << item.first.second << " : " << item.second << "\n";
+    std::cout << "nodes: " << graph.numNodes() << " edges: " << graph.numEdges() << "\n";
+    for (const auto& edge : graph.edges()) {
+        std::cout << graph.name(edge.from) << " -> " << graph.name(edge.to) << " : " << edge.rate
+                  << (edge.implied ? " (implied)" : "") << "\n";
     }
     std::cout << "\n";
 }
 
-// https://en.wikipedia.org/wiki/Bellman%E2%80%93Ford_algorithm
-// https://stackoverflow.com/questions/2282427/interesting-problem-currency-arbitrage
-
-void runBellmanFord(const std::vector<std::string>& assets, const std::vector<std::vector<double>>& rates, size_t source)
+// Applies "FROM,TO,RATE" lines from a stream (stdin, file or FIFO) and reports cycles as they appear or vanish
+void stream(ArbitrageMonitor& monitor, std::istream& input)
 {
-    const size_t numAssets = assets.size();
-    assert(numAssets > 0);
-    assert(source < numAssets);
-
-    std::vector<double> distance(numAssets);
-    std::vector<int> predecessor(numAssets);
-
-    // Step 1: initialize graph
-    for (size_t i = 0; i < numAssets; ++i) {
-        distance[i] = std::numeric_limits<double>::max(); // infinity
-        predecessor[i] = -1; // null
-    }
-
-    distance[source] = 0; // The distance from the source to itself is, of course, zero
-
-    // Step 2: relax edges repeatedly
-    for (size_t k = 0; k < numAssets; ++k) {
-        for (size_t i = 0; i < numAssets; ++i) {
-            for (size_t j = 0; j < numAssets; ++j) {
-                if (distance[i] + rates[i][j] < distance[j]) {
-                    distance[j] = distance[i] + rates[i][j];
-                    predecessor[j] = static_cast<int>(i);
-                }
-            }
+    std::size_t updates {};
+    std::chrono::nanoseconds total {};
+    std::chrono::nanoseconds worst {};
+    std::string line;
+    CsvFile::RowType row;
+    while (std::getline(input, line)) {
+        CsvFile::parseLine(line, row);
+        const auto update = monitor.setRate(row);
+        ++updates;
+        total += update.latency;
+        worst = std::max(worst, update.latency);
+
+        const auto us = std::chrono::duration<double, std::micro>(update.latency).count();
+        for (const auto& cycle : update.found) {
+            std::cout << "found    " << monitor.graph().to_string(cycle) << " [" << us << " us]\n";
         }
-    }
-
-    for (size_t k = 0; k < numAssets; ++k) {
-        std::cout << "assets[" << k << "] = " << assets[k] << "\n";
-        std::cout << "distance[" << k << "] = " << distance[k] << "\n";
-        std::cout << "predecessor[" << k << "] = " << predecessor[k] << "\n";
-        std::cout << "\n";
-    }
-
-    // Step 3: check for negative-weight cycles
-    for (size_t i = 0; i < numAssets; ++i) {
-        for (size_t j = 0; j < numAssets; ++j) {
-            if (distance[i] + rates[i][j] < distance[j]) {
-                // Step 4: find a negative-weight cycle
-                // Node j is part of a negative cycle
-                std::cout << "distance[" << i << "] + " << rates[i][j] << " < distance[" << j << "]\n";
-            }
+        for (const auto& cycle : update.vanished) {
+            std::cout << "vanished " << monitor.graph().to_string(cycle) << " [" << us << " us]\n";
         }
+        std::cout.flush();
     }
-}
 
-template <typename T>
-std::vector<T> to_vector(const std::set<T>& set)
-{
-    std::vector<T> result;
-    result.reserve(set.size());
-    std::copy(set.begin(), set.end(), std::back_inserter(result));
-    return result;
+    if (updates > 0) {
+        std::cout << "updates: " << updates
+                  << " avg latency: " << std::chrono::duration<double, std::micro>(total).count() / updates << " us"
+                  << " max latency: " << std::chrono::duration<double, std::micro>(worst).count() << " us\n";
+    }
 }
 
 } // anonymous namespace
 
-int main()
+// usage: arbitrage [--stream [path]]
+int main(int argc, char* argv[])
 {
     const CsvFile csvPairs { "./data/misc/pairs.csv", false };
-    Weights table; // {from, to} -> rate
-    std::set<std::string> assetsSet; // unique assets
-    for (const auto& item : csvPairs.data()) {
-        auto asset1 = item.at(0); // from
-        auto asset2 = item.at(1); // to
-        auto rate = std::stod(item.at(2)); // rate
-        table.insert({ { asset1, asset2 }, rate });
-        assetsSet.insert(asset1);
-        assetsSet.insert(asset2);
-    }
-    print(table);
-
-    const std::vector<std::string> assets = to_vector(assetsSet);
-    const size_t numAssets = assets.size();
-    assert(numAssets > 0);
+    const ArbitrageGraph graph { csvPairs }; // sparse graph, only quoted pairs and their inverses
 
-    std::vector<std::vector<double>> rates;
-    rates.resize(numAssets);
+    std::cout << std::fixed << std::setprecision(4);
+    print(graph);
 
-    for (size_t i = 0; i < numAssets; ++i) {
-        rates[i].resize(numAssets);
-        for (size_t j = 0; j < numAssets; ++j) {
-            auto asset1 = assets.at(i);
-            auto asset2 = assets.at(j);
-            double rate = 0;
-            if (table.find({ asset1, asset2 }) != table.end()) {
-                rate = table.at({ asset1, asset2 });
-            } else if (table.find({ asset2, asset1 }) != table.end()) {
-                rate = 1.0 / table.at({ asset2, asset1 });
-            } else if (asset1 == asset2) {
-                rate = 1;
-            } else {
-                std::cout << "rate not found: " << asset1 << " -> " << asset2 << "\n";
-            }
-            rates[i][j] = rate; // rate from asset1 to asset2
-        }
+    const auto cycles = graph.findCycles();
+    std::cout << "profitable cycles: " << cycles.size() << "\n";
+    for (const auto& cycle : cycles) {
+        std::cout << graph.to_string(cycle) << "\n";
     }
-    std::cout << "\n";
 
-    std::cout << std::fixed << std::setprecision(2);
-
-    std::cout << "     ";
-    for (size_t i = 0; i < numAssets; ++i) {
-        std::cout << assets[i] << "   ";
-    }
-    std::cout << "\n";
-    for (size_t i = 0; i < numAssets; ++i) {
-        std::cout << assets[i] << "  ";
-        for (size_t j = 0; j < numAssets; ++j) {
-            std::cout << rates[i][j] << "  ";
-            rates[i][j] = -std::log(rates[i][j]); // apply the negative logarithm
+    if (argc > 1 && std::string(argv[1]) == "--stream") {
+        std::cout << "\nstreaming updates...\n";
+        ArbitrageMonitor monitor { graph };
+        if (argc > 2) {
+            std::ifstream input { argv[2] };
+            if (!input.is_open()) {
+                std::cerr << "Failed to open " << argv[2] << "\n";
+                return 1;
+            }
+            stream(monitor, input);
+        } else {
+            stream(monitor, std::cin);
         }
-        std::cout << "\n";
     }
-    std::cout << "\n";
-
-    runBellmanFord(assets, rates, 0);
 
     return 0;
 }
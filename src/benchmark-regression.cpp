@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "lib/BenchmarkRegression.hpp"
+#include "lib/CsvFile.hpp"
+#include "lib/Market.hpp"
+#include "lib/ReportWriter.hpp"
+#include "lib/ReturnMatrix.hpp"
+
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+
+using namespace portopt;
+
+// usage: benchmark-regression [directory] [--benchmark SYMBOL]... [--bars daily|weekly|monthly|quarterly] [--length bars] [--rolling SYMBOL window]
+// Alpha, beta, R^2 and tracking error of every asset against each benchmark (VOO and BND by default)
+int main(int argc, char* argv[])
+{
+    const std::map<std::string, OhlcTimeFrame> timeFrames {
+        { "daily", OhlcTimeFrame::Daily },
+        { "weekly", OhlcTimeFrame::Weekly },
+        { "monthly", OhlcTimeFrame::Monthly },
+        { "quarterly", OhlcTimeFrame::Quarterly },
+    };
+    std::vector<std::string> benchmarks;
+    OhlcTimeFrame timeFrame = OhlcTimeFrame::Daily;
+    std::size_t length = BenchmarkRegression::npos;
+    std::string rollingSymbol;
+    std::size_t window {};
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg { argv[i] };
+        if (arg == "--benchmark" && i + 1 < argc) {
+            benchmarks.emplace_back(argv[++i]);
+        } else if (arg == "--bars" && i + 1 < argc) {
+            const auto itr = timeFrames.find(argv[++i]);
+            if (itr == timeFrames.end()) {
+                std::cerr << "Invalid bars " << argv[i] << ", expected daily, weekly, monthly or quarterly\n";
+                return 1;
+            }
+            timeFrame = itr->second;
+        } else if (arg == "--length" && i + 1 < argc) {
+            length = std::stoul(argv[++i]);
+        } else if (arg == "--rolling" && i + 2 < argc) {
+            rollingSymbol = argv[++i];
+            window = std::stoul(argv[++i]);
+        } else if (chdir(argv[i]) != 0) {
+            std::cerr << "Error changing directory to " << argv[i] << "\n";
+            return 1;
+        }
+    }
+    if (benchmarks.empty()) {
+        benchmarks = { "VOO", "BND" };
+    }
+
+    const CsvFile marketInfo { "./data/misc/market.csv", true };
+    const std::set<std::string> symbols;
+    constexpr std::size_t slackDays = 30; // histories may end a few days before the load window does
+    const double daysPerBar = 365.0 / static_cast<double>(OhlcList::tradingBarsPerYear(timeFrame)); // the regression skips weekends and holidays
+    const auto days = static_cast<std::size_t>(std::ceil(static_cast<double>(length + 1) * daysPerBar));
+    const auto range = length == BenchmarkRegression::npos ? OhlcList::defaultRange() : OhlcList::recentRange(days + slackDays);
+    const Market market { "./data/yf", marketInfo, symbols, range };
+
+    const ReturnMatrix& returns = market.returns(1, PriceType::Close, ReturnType::Simple, timeFrame);
+    const BenchmarkRegression regression { returns, benchmarks, length };
+    if (regression.benchmarks().empty()) {
+        std::cerr << "No benchmark found in the market\n";
+        return 1;
+    }
+    regression.save("./data/output/benchmark-regression.csv");
+    std::cout << "Assets: " << returns.numAssets() << ", benchmarks: " << regression.benchmarks().size() << ", periods: " << regression.length() << "\n";
+
+    if (!rollingSymbol.empty()) {
+        const std::size_t asset = returns.index(rollingSymbol);
+        if (asset == ReturnMatrix::npos || window == 0) {
+            std::cerr << "Invalid rolling symbol or window " << rollingSymbol << "\n";
+            return 1;
+        }
+        std::vector<std::vector<BenchmarkFit>> series;
+        for (std::size_t k = 0; k < regression.benchmarks().size(); ++k) {
+            series.push_back(regression.rolling(asset, k, window));
+        }
+        ReportWriter writer { "./data/output/benchmark-regression-" + rollingSymbol + ".csv" };
+        writer << "date";
+        for (const auto& benchmark : regression.benchmarks()) {
+            writer << ",beta-" << benchmark << ",r2-" << benchmark;
+        }
+        writer << '\n';
+        writer.writeRows(series.front().size(), [&](ReportBuffer& row, std::size_t i) {
+            row.appendDate(returns.timepoints()[returns.tradingPeriods()[i]]); // bar of trading return i
+            for (const auto& fits : series) {
+                row.append(',');
+                row.append(fits[i].beta);
+                row.append(',');
+                row.append(fits[i].rSquared);
+            }
+            row.append('\n');
+        });
+    }
+
+    std::cout << "\nDONE\n";
+    return 0;
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "lib/BarStore.hpp"
+#include "lib/CsvFile.hpp"
+#include "lib/Utils.hpp"
+
+#include <cmath>
+#include <iostream>
+#include <string>
+
+using namespace portopt;
+
+namespace {
+
+constexpr auto usage = "usage: intraday-bars import SYMBOL FILE.csv [--hourly] [directory]\n"
+                       "       intraday-bars info SYMBOL [--from YYYY-MM-DD] [--to YYYY-MM-DD] [--hourly] [directory]\n";
+
+void printInfo(const OhlcList& bars)
+{
+    const auto timeFrame = bars.timeFrame();
+    std::cout << "bars\t" << bars.size() << "\n";
+    std::cout << "from\t" << Utils::toDateTimeString(bars.at(bars.size() - 1).timepoint) << "\n";
+    std::cout << "to\t" << Utils::toDateTimeString(bars.at(0).timepoint) << "\n";
+    if (bars.size() < 2) {
+        return;
+    }
+    const auto returns = bars.returns(1, PriceType::Close);
+    const double risk = Utils::stdDev(returns);
+    std::cout << "mean return per bar\t" << Utils::mean(returns) << "\n";
+    std::cout << "risk per bar\t" << risk << "\n";
+    std::cout << "annualized risk\t" << risk * std::sqrt(static_cast<double>(OhlcList::barsPerYear(timeFrame))) << "\n";
+    std::cout << "max drawdown\t" << bars.maxDrawdown(0, bars.size()) << "%\n";
+    if (timeFrame < OhlcTimeFrame::Hourly) {
+        std::cout << "hourly bars\t" << bars.resample(OhlcTimeFrame::Hourly).size() << "\n";
+    }
+    std::cout << "daily bars\t" << bars.resample(OhlcTimeFrame::Daily).size() << "\n";
+}
+
+// Bound of the stored bars: a date is a whole UTC day, included at both ends like the date prefix matched by
+// import, a date with a time is taken as is
+TimePoint storeBound(const std::string& value, bool end)
+{
+    if (value.size() > 10) {
+        return Utils::toDateTime(value);
+    }
+    const TimePoint start = Utils::toDateTime(value + " 00:00Z");
+    return end ? start + std::chrono::days { 1 } - std::chrono::seconds { 1 } : start;
+}
+
+} // anonymous namespace
+
+// Intraday bars from yfinance CSV files (e.g. history(period="7d", interval="1m")) in ./data/intraday, one
+// columnar chunk per symbol and month
+int main(int argc, char* argv[])
+{
+    if (argc < 3) {
+        std::cerr << usage;
+        return 1;
+    }
+    const std::string command { argv[1] };
+    const std::string symbol { argv[2] };
+    std::string csvPath;
+    auto timeFrame = OhlcTimeFrame::Minute;
+    std::string from { "1970-01-02" };
+    std::string to { "2100-01-01" };
+    int i = 3;
+    if (command == "import") {
+        if (argc < 4) {
+            std::cerr << usage;
+            return 1;
+        }
+        csvPath = argv[i++];
+    }
+    for (; i < argc; ++i) {
+        const std::string arg { argv[i] };
+        if (arg == "--hourly") {
+            timeFrame = OhlcTimeFrame::Hourly;
+        } else if (arg == "--from" && i + 1 < argc) {
+            from = argv[++i];
+        } else if (arg == "--to" && i + 1 < argc) {
+            to = argv[++i];
+        } else if (chdir(argv[i]) != 0) {
+            std::cerr << "Error changing directory to " << argv[i] << "\n";
+            return 1;
+        }
+    }
+
+    const BarStore store { "./data/intraday" };
+    if (command == "import") {
+        const CsvFile csv { csvPath, true };
+        const OhlcList bars { csv, timeFrame, { Utils::toDateTime(from), Utils::toDateTime(to) } }; // date prefix of the rows
+        if (!store.save(symbol, bars)) {
+            return 1;
+        }
+        std::cout << "imported " << bars.size() << " bars into " << store.months(symbol).size() << " chunks\n";
+        return 0;
+    }
+    if (command != "info") {
+        std::cerr << usage;
+        return 1;
+    }
+
+    const OhlcList bars = store.load(symbol, { storeBound(from, false), storeBound(to, true) }, timeFrame);
+    if (bars.size() == 0) {
+        std::cerr << "No bars for " << symbol << "\n";
+        return 1;
+    }
+    printInfo(bars);
+
+    std::cout << "\nDONE\n";
+    return 0;
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "lib/CrossCorrelation.hpp"
+#include "lib/CsvFile.hpp"
+#include "lib/Market.hpp"
+#include "lib/ReturnMatrix.hpp"
+
+#include <iostream>
+#include <set>
+#include <string>
+
+using namespace portopt;
+
+// usage: lead-lag [directory] [--max-lag tradingDays] [--min-correlation value]
+int main(int argc, char* argv[])
+{
+    std::size_t maxLag = 5;
+    double minCorrelation = 0.3;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg { argv[i] };
+        if (arg == "--max-lag" && i + 1 < argc) {
+            maxLag = std::stoul(argv[++i]);
+        } else if (arg == "--min-correlation" && i + 1 < argc) {
+            minCorrelation = std::stod(argv[++i]);
+        } else if (chdir(argv[i]) != 0) {
+            std::cerr << "Error changing directory to " << argv[i] << "\n";
+            return 1;
+        }
+    }
+
+    const CsvFile marketInfo { "./data/misc/market.csv", true };
+    const std::set<std::string> symbols;
+    const Market market { "./data/yf", marketInfo, symbols };
+
+    // daily log returns, lagged price levels would mostly show shared trends
+    const ReturnMatrix& returns = market.returns(1, PriceType::Close, ReturnType::Log);
+    const auto pairs = CrossCorrelation::leadLag(returns, maxLag, minCorrelation);
+    CrossCorrelation::saveLeadLag(pairs, returns, "./data/output/lead-lag.csv");
+    std::cout << "Lead-lag pairs: " << pairs.size() << ", lags in trading days up to " << maxLag << "\n";
+
+    std::cout << "\nDONE\n";
+    return 0;
+}
@@ -6,32 +6,204 @@
  */
 
 #include "lib/CsvFile.hpp"
+#include "lib/EwmaCovariance.hpp"
 #include "lib/Market.hpp"
+#include "lib/MarketInfo.hpp"
 #include "lib/Portfolio.hpp"
+#include "lib/ReturnMatrix.hpp"
+#include "lib/TiledCorrelation.hpp"
 
 #include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <set>
+#include <string>
 
 using namespace portopt;
 
+namespace {
+
+// Partial result of one shard, written by "--shard i/n" and read by "--merge n"
+FilePath shardPath(const std::string& name, std::size_t shard, std::size_t numShards, const std::string& extension = ".bin")
+{
+    return "./data/output/shards/" + name + "-" + std::to_string(shard) + "-of-" + std::to_string(numShards) + extension;
+}
+
+// Daily return cache of the market written asset by asset (the matrix is never built in memory), shards running at
+// the same time each write their own copy and rename it into place
+FilePath saveReturns(const Market& market, std::size_t shard)
+{
+    const FilePath cachePath { "./data/output/market-info-returns.bin" };
+    const FilePath tempPath { cachePath.string() + "." + std::to_string(shard) + ".tmp" };
+    if (!ReturnMatrix::saveCache(tempPath, market, 1)) {
+        return {};
+    }
+    std::filesystem::rename(tempPath, cachePath);
+    return cachePath;
+}
+
+// Correlation matrix of daily returns computed tile by tile within a memory budget
+void saveTiled(const Market& market, std::size_t budgetMiB)
+{
+    const FilePath cachePath = saveReturns(market, 0);
+    if (cachePath.empty()) {
+        return;
+    }
+    const TiledCorrelation tiled { cachePath, budgetMiB << 20 };
+    tiled.saveMatrix("./data/output/market-info-correlation.bin");
+}
+
+// Rows of one shard and its part of the correlation list, the per-asset files are written by the first shard
+void saveShard(const Market& market, std::size_t shard, std::size_t numShards, std::size_t tiledBudgetMiB)
+{
+    std::filesystem::create_directories("./data/output/shards");
+    if (shard == 0) {
+        market.saveAssets("./data/output/symbols");
+        market.saveSymbols("./data/output/market-info-symbols.txt");
+    }
+    market.saveCorrelationList(shardPath("market-info-correlation", shard, numShards, ".txt"), shard, numShards);
+
+    const MarketInfo info { market, shard, numShards };
+    info.saveBinary(shardPath("market-info", shard, numShards), ColumnFile::Type::Float64);
+
+    if (tiledBudgetMiB > 0) {
+        const FilePath cachePath = saveReturns(market, shard);
+        if (cachePath.empty()) {
+            return;
+        }
+        const TiledCorrelation tiled { cachePath, tiledBudgetMiB << 20 };
+        tiled.saveShard(shardPath("market-info-correlation", shard, numShards), shard, numShards);
+    }
+}
+
+// Assembles the outputs from the partial files of every shard, without loading the market. Nothing is written if
+// a shard is missing, can't be read or disagrees with the others
+bool mergeShards(std::size_t numShards)
+{
+    std::vector<MarketInfo> infos;
+    std::vector<FilePath> lists;
+    std::vector<FilePath> correlations;
+    for (std::size_t shard = 0; shard < numShards; ++shard) {
+        const FilePath infoPath = shardPath("market-info", shard, numShards);
+        lists.push_back(shardPath("market-info-correlation", shard, numShards, ".txt"));
+        if (!std::filesystem::exists(infoPath) || !std::filesystem::exists(lists.back())) {
+            std::cerr << "Missing shard " << infoPath << "\n";
+            return false;
+        }
+        infos.push_back(MarketInfo::load(infoPath));
+        if (infos.back().rows().empty()) {
+            std::cerr << "Empty shard " << infoPath << "\n";
+            return false;
+        }
+        correlations.push_back(shardPath("market-info-correlation", shard, numShards));
+    }
+
+    const MarketInfo info = MarketInfo::merge(infos);
+    if (info.rows().empty()) {
+        return false; // the shards were run on different markets
+    }
+
+    std::ofstream correlationList { "./data/output/market-info-correlation.txt", std::ios::out | std::ios::trunc };
+    for (const auto& listPath : lists) {
+        std::ifstream list { listPath };
+        if (list.peek() != std::ifstream::traits_type::eof()) { // an empty buffer would fail the stream
+            correlationList << list.rdbuf();
+        }
+    }
+    info.saveCsv("./data/output/market-info.csv");
+    info.saveBinary("./data/output/market-info.bin");
+
+    if (std::filesystem::exists(correlations.front())) { // shards were run with --tiled
+        return TiledCorrelation::mergeShards(correlations, "./data/output/market-info-correlation.bin");
+    }
+    return true;
+}
+
+// Brings the saved EWMA covariance up to date with the new bars of the market, rebuilt if the symbols or decay changed
+void updateEwma(const Market& market, double lambda)
+{
+    const FilePath filePath = "./data/output/market-info-ewma.bin";
+    const ReturnMatrix& daily = market.returns(1);
+    EwmaCovariance model = EwmaCovariance::load(filePath);
+    if (model.symbols() == daily.symbols() && model.lambda() == lambda) {
+        std::cout << "EWMA bars applied: " << model.update(daily) << "\n";
+    } else {
+        model = EwmaCovariance { daily, lambda };
+        std::cout << "EWMA rebuilt from bars: " << model.count() << "\n";
+    }
+    model.save(filePath);
+}
+
+} // anonymous namespace
+
+// usage: market-info [directory] [--tiled budgetMiB] [--shard i/n | --merge n] [--ewma lambda]
 int main(int argc, char* argv[])
 {
-    if (argc > 1) {
-        if (chdir(argv[1]) != 0) {
-            std::cerr << "Error changing directory to " << argv[1] << "\n";
+    std::size_t tiledBudget {};
+    std::size_t shard {};
+    std::size_t numShards {};
+    std::size_t mergeShardCount {};
+    double ewmaLambda {};
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg { argv[i] };
+        if (arg == "--tiled" && i + 1 < argc) {
+            tiledBudget = std::stoul(argv[++i]);
+        } else if (arg == "--shard" && i + 1 < argc) {
+            const std::string value { argv[++i] };
+            const auto slash = value.find('/');
+            shard = std::stoul(value.substr(0, slash));
+            numShards = slash == std::string::npos ? 0 : std::stoul(value.substr(slash + 1));
+            if (shard >= numShards) {
+                std::cerr << "Invalid shard " << value << ", expected i/n with i < n\n";
+                return 1;
+            }
+        } else if (arg == "--merge" && i + 1 < argc) {
+            mergeShardCount = std::stoul(argv[++i]);
+        } else if (arg == "--ewma" && i + 1 < argc) {
+            ewmaLambda = std::stod(argv[++i]);
+            if (ewmaLambda <= 0 || ewmaLambda >= 1) {
+                std::cerr << "Invalid EWMA decay " << ewmaLambda << ", expected 0 < lambda < 1\n";
+                return 1;
+            }
+        } else if (chdir(argv[i]) != 0) {
+            std::cerr << "Error changing directory to " << argv[i] << "\n";
             return 1;
         }
     }
 
+    if (mergeShardCount > 0) {
+        const bool merged = mergeShards(mergeShardCount);
+        std::cout << (merged ? "\nDONE\n" : "\nFAILED\n");
+        return merged ? 0 : 1;
+    }
+
     const CsvFile marketInfo { "./data/misc/market.csv", true };
     const std::set<std::string> symbols; // { "VOO", "VTI" };
     const Market market { "./data/yf", marketInfo, symbols };
 
+    if (numShards > 0) {
+        saveShard(market, shard, numShards, tiledBudget);
+        std::cout << "\nDONE\n";
+        return 0;
+    }
+
+    if (tiledBudget > 0) {
+        saveTiled(market, tiledBudget);
+        std::cout << "\nDONE\n";
+        return 0;
+    }
+
     market.saveAssets("./data/output/symbols"); // save ohlc for assets
     market.saveSymbols("./data/output/market-info-symbols.txt"); // symbols array
     market.saveCorrelationList("./data/output/market-info-correlation.txt");
-    market.saveMarketInfo("./data/output/market-info.csv");
+
+    const MarketInfo info { market }; // computed once for both formats
+    info.saveCsv("./data/output/market-info.csv");
+    info.saveBinary("./data/output/market-info.bin"); // columnar, see ColumnFile.hpp
+
+    if (ewmaLambda > 0) {
+        updateEwma(market, ewmaLambda);
+    }
 
     std::cout << "\nDONE\n";
     return 0;
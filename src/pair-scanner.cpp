@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "lib/CsvFile.hpp"
+#include "lib/Market.hpp"
+#include "lib/PairScanner.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <set>
+#include <string>
+
+using namespace portopt;
+
+constexpr std::size_t slackDays = 30; // histories may end a few days before the load window does
+
+// usage: pair-scanner [directory] [--length days] [--min-correlation value] [--all]
+// Pair trading and substitution candidates among the ETFs, or among all assets with --all
+int main(int argc, char* argv[])
+{
+    std::size_t length = 500;
+    double minCorrelation = 0.8;
+    bool allAssets = false;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg { argv[i] };
+        if (arg == "--length" && i + 1 < argc) {
+            length = std::stoul(argv[++i]);
+        } else if (arg == "--min-correlation" && i + 1 < argc) {
+            minCorrelation = std::stod(argv[++i]);
+        } else if (arg == "--all") {
+            allAssets = true;
+        } else if (chdir(argv[i]) != 0) {
+            std::cerr << "Error changing directory to " << argv[i] << "\n";
+            return 1;
+        }
+    }
+
+    const CsvFile marketInfo { "./data/misc/market.csv", true };
+    const std::set<std::string> symbols;
+    const Market market { "./data/yf", marketInfo, symbols, OhlcList::recentRange(length + slackDays) }; // only the compared window
+
+    std::vector<std::string> candidates;
+    for (const auto& [symbol, asset] : market.assets()) {
+        if (allAssets || asset.isETF()) {
+            candidates.push_back(symbol);
+        }
+    }
+
+    const auto pairs = PairScanner::scan(market, candidates, length, minCorrelation);
+    PairScanner::save(pairs, "./data/output/pair-scanner.csv");
+    const auto cointegrated = std::count_if(pairs.begin(), pairs.end(), [](const PairCandidate& pair) { return pair.test.cointegrated(); });
+    std::cout << "Candidates: " << pairs.size() << ", cointegrated: " << cointegrated << "\n";
+
+    std::cout << "\nDONE\n";
+    return 0;
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "lib/CsvFile.hpp"
+#include "lib/Market.hpp"
+#include "lib/PatternSearch.hpp"
+#include "lib/Utils.hpp"
+
+#include <iostream>
+#include <set>
+#include <string>
+
+using namespace portopt;
+
+// usage: pattern-search SYMBOL [directory] [--length days] [--top k] [--market]
+// Historical windows that looked like the last days of SYMBOL, in its own history or in any asset with --market
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        std::cerr << "usage: pattern-search SYMBOL [directory] [--length days] [--top k] [--market]\n";
+        return 1;
+    }
+    const std::string symbol { argv[1] };
+    std::size_t length = 60;
+    std::size_t top = 10;
+    bool wholeMarket = false;
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg { argv[i] };
+        if (arg == "--length" && i + 1 < argc) {
+            length = std::stoul(argv[++i]);
+        } else if (arg == "--top" && i + 1 < argc) {
+            top = std::stoul(argv[++i]);
+        } else if (arg == "--market") {
+            wholeMarket = true;
+        } else if (chdir(argv[i]) != 0) {
+            std::cerr << "Error changing directory to " << argv[i] << "\n";
+            return 1;
+        }
+    }
+
+    const CsvFile marketInfo { "./data/misc/market.csv", true };
+    const std::set<std::string> symbols;
+    const Market market { "./data/yf", marketInfo, symbols };
+    if (length < 2 || !market.assets().contains(symbol) || market.get(symbol).ohlc().size() < length) {
+        std::cerr << "Not enough history for " << symbol << "\n";
+        return 1;
+    }
+
+    constexpr auto priceType = PriceType::Close;
+    const PatternSearch search { market.get(symbol).ohlc().toVector(length, 0, priceType), priceType };
+    // windows overlapping the query period are skipped, in every asset
+    const auto matches = wholeMarket ? search.search(market, top, length) : search.search(market.get(symbol), top, length);
+
+    std::cout << "symbol\tfrom\tto\tdistance\tnext " << length << " entries\n";
+    for (const auto& match : matches) {
+        const auto& ohlc = market.get(match.symbol).ohlc();
+        std::cout << match.symbol << "\t" << Utils::to_string(ohlc.at(match.offset + length - 1).timepoint) << "\t"
+                  << Utils::to_string(ohlc.at(match.offset).timepoint) << "\t" << match.distance << "\t";
+        if (match.offset >= length) { // what happened after the window
+            std::cout << ohlc.priceChange(match.offset - length, length, priceType);
+        }
+        std::cout << "\n";
+    }
+
+    std::cout << "\nDONE\n";
+    return 0;
+}
@@ -7,15 +7,37 @@
 
 #include "lib/CsvFile.hpp"
 #include "lib/EtradePortfolio.hpp"
+#include "lib/EwmaCovariance.hpp"
+#include "lib/FactorModel.hpp"
 #include "lib/Market.hpp"
+#include "lib/RiskMetrics.hpp"
 #include "lib/Utils.hpp"
 
 #include <iostream>
+#include <map>
+#include <string>
 
 using namespace portopt;
 
-int main()
+// usage: portfolio-info [--risk dense|factor]
+int main(int argc, char* argv[])
 {
+    const std::map<std::string, Utils::RiskBackend> backends {
+        { "dense", Utils::RiskBackend::Dense },
+        { "factor", Utils::RiskBackend::Factor },
+    };
+    Utils::RiskBackend backend = Utils::RiskBackend::Dense;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg { argv[i] };
+        const auto itr = i + 1 < argc ? backends.find(argv[i + 1]) : backends.end();
+        if (arg != "--risk" || itr == backends.end()) {
+            std::cerr << "Invalid argument " << arg << ", expected --risk dense or factor\n";
+            return 1;
+        }
+        backend = itr->second;
+        ++i;
+    }
+
     const EtradePortfolio portfolio { "./data/etrade/PortfolioDownload.csv" };
 
     std::cout << "Number of holdings: " << portfolio.holdings().size() << "\n";
@@ -40,6 +62,22 @@ int main()
     const double totalValue = Utils::totalValue(market, portfolio);
     std::cout << "\ntotalValue: " << totalValue << "\n";
 
+    std::cout << "avgRisk (daily): " << Utils::avgRisk(market, portfolio, backend) << "\n";
+    if (backend == Utils::RiskBackend::Factor) {
+        const FactorModel& factors = market.factorModel(Utils::defaultFactors);
+        std::cout << "factor model: " << factors.numFactors() << " factors, " << factors.explainedVariance() * 100 << "% of the variance\n";
+    }
+    const EwmaCovariance& ewma = market.ewmaCovariance(EwmaCovariance::defaultLambda);
+    std::cout << "avgRisk (daily, EWMA lambda " << ewma.lambda() << "): " << Utils::avgRisk(market, portfolio, ewma) << "\n";
+
+    // daily value of the holdings over the last 5 years
+    const RiskStats risk = RiskMetrics::compute(market, portfolio, 5 * 365);
+    const auto names = RiskStats::names();
+    const auto values = risk.values();
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        std::cout << names[i] << ": " << values[i] << "\n";
+    }
+
     Utils::saveAllocations(market, portfolio, "./data/output/portfolio-info-market-allocations.csv");
 
     std::cout << "\nDONE\n";
@@ -7,57 +7,135 @@
 
 // https://www.bankrate.com/retirement/calculators/retirement-plan-calculator/
 
+#include "lib/Market.hpp"
+#include "lib/Portfolio.hpp"
+#include "lib/Retirement.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
 #include <iomanip>
 #include <iostream>
+#include <set>
+#include <string>
+
+using namespace portopt;
+
+namespace {
+
+// Savings at the end of each year, formatted into one buffer instead of a stream write per month
+void printDeterministic(const RetirementPlan& plan)
+{
+    const auto savings = Retirement::deterministic(plan);
+    const auto scenario = Retirement::evaluate(plan);
+
+    std::string buffer { "age\tsavings\n" };
+    char chars[32];
+    for (std::size_t i = 0; i < savings.size(); ++i) {
+        buffer += std::to_string(plan.currentAge + static_cast<int>(i));
+        buffer += '\t';
+        const auto [end, ec] = std::to_chars(std::begin(chars), std::end(chars), savings[i], std::chars_format::fixed, 2);
+        buffer.append(chars, end);
+        buffer += '\n';
+    }
+    std::cout << buffer;
+    if (scenario.depletionAge > 0) {
+        std::cout << "\nsavings run out at age " << std::fixed << std::setprecision(2) << scenario.depletionAge << "\n";
+    }
+}
+
+// Ending balance of every combination of retirement age, savings, expenses and rates of return
+void sweep(const RetirementPlan& plan, const FilePath& filePath)
+{
+    RetirementGrid grid;
+    for (int age = 35; age <= 70; ++age) {
+        grid.retirementAges.push_back(age);
+    }
+    for (int amount = 0; amount <= 10'000; amount += 500) {
+        grid.monthlySavings.push_back(amount);
+    }
+    for (int amount = 2'000; amount <= 10'000; amount += 500) {
+        grid.monthlyExpenses.push_back(amount);
+    }
+    for (int rate = 1; rate <= 8; ++rate) {
+        grid.ratesOfReturn.emplace_back(rate, rate - 2); // more conservative after retirement
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto scenarios = Retirement::sweep(plan, grid);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    Retirement::saveSweep(scenarios, filePath);
+
+    const auto funded = std::count_if(scenarios.begin(), scenarios.end(), [](const RetirementScenario& item) { return item.depletionAge == 0; });
+    std::cout << "scenarios: " << scenarios.size() << " in " << elapsed.count() << " s\n"
+              << "fully funded: " << funded << "\n"
+              << "saved to " << filePath << "\n";
+}
 
-int main()
+// Resample the monthly returns of a portfolio built from historical prices
+void printMonteCarlo(const RetirementPlan& plan, std::size_t numPaths)
 {
-    const auto current_age = 30;
-    const auto retirement_age = 42;
-    const auto social_security_age = 67;
-    const auto death_age = 90;
-
-    const auto monthly_savings = 5000; // monthly savings (stop at retirement age)
-    const auto monthly_expenses = 5000; // monthly expenses (after retirement)
-    const auto social_security = 1000; // social security income (start at social security age)
-    double current_savings = 500'000; // current savings (at current age)
-
-    const auto rate_of_return_before = 4; // annual growth rate (before retirement)
-    const auto rate_of_return_after = 2; // annual growth rate (after retirement)
-
-    std::cout << "age\tsavings\n"
-              << std::fixed << std::setprecision(2);
-    std::cout << current_age << "\t" << current_savings << "\n";
-
-    auto current_age_month = current_age * 12;
-    while (current_age_month < retirement_age * 12) {
-        current_age_month++;
-        current_savings *= (100.0 + rate_of_return_before / 12.0) / 100.0;
-        current_savings += monthly_savings;
-        std::cout << current_age_month / 12.0 << "\t" << current_savings << "\n";
+    const Portfolio portfolio { "./data/misc/portfolio.csv" };
+    std::set<std::string> symbols;
+    for (const auto& [symbol, quantity] : portfolio.holdings()) {
+        symbols.insert(symbol);
     }
+    const CsvFile marketInfo { "./data/misc/market.csv", true };
+    const Market market { "./data/yf", marketInfo, symbols };
 
-    // std::cout << "retirement starts\n";
+    const auto returns = Retirement::monthlyReturns(market, portfolio);
+    std::cout << "historical months: " << returns.size() << "\n";
 
-    while (current_age_month < social_security_age * 12) {
-        current_age_month++;
-        if (current_savings > 0) {
-            current_savings *= (100.0 + rate_of_return_after / 12.0) / 100.0;
+    const auto start = std::chrono::steady_clock::now();
+    const auto result = Retirement::monteCarlo(plan, returns, numPaths);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "paths: " << result.numPaths << " in " << elapsed.count() << " s\n"
+              << "success probability: " << result.successProbability * 100 << "%\n\n"
+              << "age";
+    for (const double p : RetirementResult::percentiles) {
+        std::cout << "\tp" << p;
+    }
+    std::cout << std::setprecision(0) << "\n";
+    for (std::size_t i = 0; i < result.bands.size(); ++i) {
+        std::cout << result.ages[i];
+        for (const double value : result.bands[i]) {
+            std::cout << "\t" << value;
         }
-        current_savings -= monthly_expenses;
-        std::cout << current_age_month / 12.0 << "\t" << current_savings << "\n";
+        std::cout << "\n";
     }
+}
 
-    // std::cout << "social security starts\n";
+} // anonymous namespace
 
-    while (current_age_month < death_age * 12) {
-        current_age_month++;
-        if (current_savings > 0) {
-            current_savings *= (100.0 + rate_of_return_after / 12.0) / 100.0;
+// usage: retirement-calculator [plan.json] [--monte-carlo [paths] | --sweep [output.csv]]
+int main(int argc, char* argv[])
+{
+    RetirementPlan plan;
+    std::size_t numPaths {};
+    FilePath sweepPath;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg { argv[i] };
+        if (arg == "--sweep") {
+            sweepPath = (i + 1 < argc && argv[i + 1][0] != '-') ? argv[++i] : "./data/output/retirement-sweep.csv";
+        } else if (arg == "--monte-carlo") {
+            numPaths = 1'000'000;
+            if (i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+                numPaths = std::stoul(argv[++i]);
+            }
+        } else {
+            plan = RetirementPlan::load(arg);
         }
-        current_savings -= monthly_expenses;
-        current_savings += social_security;
-        std::cout << current_age_month / 12.0 << "\t" << current_savings << "\n";
+    }
+
+    if (!sweepPath.empty()) {
+        sweep(plan, sweepPath);
+    } else if (numPaths > 0) {
+        printMonteCarlo(plan, numPaths);
+    } else {
+        printDeterministic(plan);
     }
 
     std::cout << "\nDONE\n";
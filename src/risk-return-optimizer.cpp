@@ -11,9 +11,13 @@
 #include "lib/Asset.hpp"
 #include "lib/CsvFile.hpp"
 #include "lib/Market.hpp"
-#include "lib/Portfolio.hpp"
+#include "lib/Matrix.hpp"
+#include "lib/PortfolioBatch.hpp"
+#include "lib/RiskModel.hpp"
 #include "lib/Utils.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
@@ -40,37 +44,48 @@ int main()
 
     const Market market { assets };
 
+    const auto& model = market.riskModel();
+
     // risk -> {return, portfolio}
     std::unordered_map<int, std::pair<double, std::string>> data;
 
     const size_t iterations = Utils::powi(10, assets.size());
-    for (size_t i = 1; i < iterations; ++i) {
-        if (i % 2000 == 0) {
-            std::cout << 100.0 * i / iterations << "\n";
+    constexpr size_t batchSize = 100'000; // portfolios evaluated per batch
+    for (size_t first = 1; first < iterations; first += batchSize) {
+        const size_t last = std::min(first + batchSize, iterations);
+        std::cout << 100.0 * first / iterations << "\n";
+
+        // one row of weights per candidate portfolio (all prices are 1)
+        Matrix weights { last - first, model.size() };
+        std::vector<int> totalShares(last - first);
+        for (size_t i = first; i < last; ++i) {
+            for (size_t j = 0; j < assets.size(); ++j) {
+                const int shares = static_cast<int>((i / Utils::powi(10, j)) % 10) * 10;
+                totalShares[i - first] += shares;
+                weights(i - first, model.index(assets.at(j).symbol())) = shares;
+            }
+            for (size_t c = 0; c < model.size(); ++c) {
+                weights(i - first, c) /= totalShares[i - first];
+            }
         }
 
-        Portfolio portfolio {};
-        int totalShares {};
-        for (size_t j = 0; j < assets.size(); ++j) {
-            int shares = (i / Utils::powi(10, j)) % 10;
-            shares *= 10;
-            totalShares += shares;
-            portfolio.set(assets.at(j).symbol(), shares);
-        }
+        const auto result = PortfolioBatch::evaluate(market, weights);
 
-        const int avgRisk = std::round(Utils::avgRisk(market, portfolio) * 1000);
-        const double avgReturn = Utils::avgReturn(market, portfolio) * 100;
+        for (size_t i = first; i < last; ++i) {
+            const int avgRisk = std::round(result.risks[i - first] * 1000);
+            const double avgReturn = result.returns[i - first] * 100;
 
-        std::stringstream ss;
-        for (const auto& item : assets) {
-            ss << item.symbol() << ":" << portfolio.get(item.symbol()) << "-";
-        }
-        ss << "," << Utils::avgRisk(market, portfolio) * 100 << "," << avgReturn;
-        for (const auto& item : assets) {
-            ss << "," << 100.0 * portfolio.get(item.symbol()) / totalShares;
-        }
+            std::stringstream ss;
+            for (size_t j = 0; j < assets.size(); ++j) {
+                ss << assets.at(j).symbol() << ":" << ((i / Utils::powi(10, j)) % 10) * 10 << "-";
+            }
+            ss << "," << result.risks[i - first] * 100 << "," << avgReturn;
+            for (const auto& item : assets) {
+                ss << "," << 100.0 * weights(i - first, model.index(item.symbol()));
+            }
 
-        data.insert_or_assign(avgRisk, std::make_pair(avgReturn, ss.str()));
+            data.insert_or_assign(avgRisk, std::make_pair(avgReturn, ss.str()));
+        }
     }
 
     std::ofstream outFile("./data/output/risk-return-optimizer.csv", std::ios::out | std::ios::trunc);
@@ -7,20 +7,35 @@
 
 // Efficient frontier for 2 asset portfolio from historical prices
 
+#include "lib/EwmaCovariance.hpp"
 #include "lib/Market.hpp"
 #include "lib/Portfolio.hpp"
+#include "lib/PortfolioBatch.hpp"
 #include "lib/Utils.hpp"
 
+#include <cmath>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 
 using namespace portopt;
 
+constexpr auto length = 365 * 15; // days of history to evaluate
+constexpr auto offset = 365; // days between the two values of each return
+
 void calc(std::ofstream& outFile, const Market& market, const int category, const std::string symbol1, const std::string symbol2)
 {
+    // current risk of each mix under the EWMA covariance of the daily returns, annualized over the trading days
+    const auto column = [&market](const std::string& symbol) { return static_cast<std::size_t>(std::distance(market.assets().begin(), market.assets().find(symbol))); };
+    Matrix weights { 21, market.assets().size() };
+    for (std::size_t k = 0; k < weights.rows(); ++k) {
+        weights(k, column(symbol1)) = static_cast<double>(k) / 20;
+        weights(k, column(symbol2)) = 1 - weights(k, column(symbol1));
+    }
+    const auto batch = PortfolioBatch::evaluate(market, weights, 0, &market.ewmaCovariance(EwmaCovariance::defaultLambda));
+    const double sqrtDays = std::sqrt(static_cast<double>(OhlcList::tradingBarsPerYear(OhlcTimeFrame::Daily)));
+
     const auto total = 1'000'000;
-    const auto length = 365 * 15;
     for (int i = 0; i <= 100; i += 5) {
         const auto price1 = market.get(symbol1).ohlc().at(length).hl2();
         const auto price2 = market.get(symbol2).ohlc().at(length).hl2();
@@ -31,7 +46,8 @@ void calc(std::ofstream& outFile, const Market& market, const int category, cons
         portfolio.set(symbol2, shares2);
         outFile << category << ","
                 << symbol1 << ":" << i << "-" << symbol2 << ":" << (100 - i) << ","
-                << Utils::avgRisk(market, portfolio, length) * 100 << "," << Utils::avgReturn(market, portfolio, length) * 100 << "\n";
+                << Utils::avgRisk(market, portfolio, length) * 100 << "," << Utils::avgReturn(market, portfolio, length) * 100 << ","
+                << batch.risks[i / 5] * sqrtDays * 100 << "\n";
     }
 }
 
@@ -39,10 +55,10 @@ int main()
 {
     const CsvFile marketInfo { "./data/misc/market.csv", true };
     const std::set<std::string> symbols { "BND", "VOO", "SGOL", "VNQ" };
-    const Market market { "./data/yf", marketInfo, symbols };
+    const Market market { "./data/yf", marketInfo, symbols, OhlcList::recentRange(length + offset + 1) }; // only the years used below
 
     std::ofstream outFile("./data/output/two-asset-optimizer.csv", std::ios::out | std::ios::trunc);
-    outFile << "category,portfolio,risk,return\n";
+    outFile << "category,portfolio,risk,return,ewmaRisk\n";
 
     calc(outFile, market, 1, "BND", "VOO");
     calc(outFile, market, 2, "BND", "SGOL");
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "lib/ArbitrageGraph.hpp"
+#include "lib/ArbitrageMonitor.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+
+using namespace portopt;
+
+constexpr double epsilon = 1e-9;
+
+TEST(ArbitrageGraph, noCycle)
+{
+    ArbitrageGraph graph;
+    graph.setRate("USD", "EUR", 0.5);
+    graph.setRate("EUR", "GBP", 0.5);
+    graph.setRate("USD", "GBP", 0.25);
+    EXPECT_EQ(3, graph.numNodes());
+    EXPECT_EQ(6, graph.numEdges()); // quoted pairs and their inverses
+    EXPECT_TRUE(graph.findCycles().empty());
+}
+
+TEST(ArbitrageGraph, oneCycle)
+{
+    ArbitrageGraph graph;
+    graph.setRate("USD", "EUR", 0.5);
+    graph.setRate("EUR", "GBP", 0.5);
+    graph.setRate("GBP", "USD", 4.4); // 0.5 * 0.5 * 4.4 = 1.1
+    graph.setRate("USD", "JPY", 100); // not part of any cycle
+
+    const auto cycles = graph.findCycles();
+    ASSERT_EQ(1, cycles.size());
+    EXPECT_NEAR(0.1, cycles[0].gain, epsilon);
+    EXPECT_EQ(3, cycles[0].nodes.size());
+    EXPECT_NEAR(-std::log(1.1), graph.cycleWeight(cycles[0]), epsilon);
+}
+
+TEST(ArbitrageGraph, edgeDisjoint)
+{
+    ArbitrageGraph graph;
+    graph.setRate("USD", "EUR", 0.5);
+    graph.setRate("EUR", "GBP", 0.5);
+    graph.setRate("GBP", "USD", 4.4); // 0.5 * 0.5 * 4.4 = 1.1
+    graph.setRate("EUR", "JPY", 100);
+    graph.setRate("JPY", "USD", 0.022); // 0.5 * 100 * 0.022 = 1.1, shares USD -> EUR with the first cycle
+    graph.setRate("CHF", "CAD", 1.5);
+    graph.setRate("CAD", "AUD", 1.1);
+    graph.setRate("AUD", "CHF", 0.7); // 1.155, no pair in common with the others
+
+    const auto cycles = graph.findCycles();
+    ASSERT_EQ(2, cycles.size()); // only one of the two cycles through USD -> EUR
+    std::set<std::size_t> used;
+    for (const auto& cycle : cycles) {
+        for (std::size_t i = 0; i < cycle.nodes.size(); ++i) {
+            const std::size_t e = graph.findEdge(cycle.nodes[i], cycle.nodes[(i + 1) % cycle.nodes.size()]);
+            EXPECT_TRUE(used.insert(e).second) << graph.to_string(cycle);
+        }
+    }
+    EXPECT_TRUE(std::any_of(cycles.begin(), cycles.end(), [](const auto& cycle) { return std::abs(cycle.gain - 0.155) < epsilon; }));
+}
+
+TEST(ArbitrageGraph, explicitReverse)
+{
+    ArbitrageGraph graph;
+    graph.setRate("BTC", "USD", 20000);
+    graph.setRate("USD", "BTC", 1.0 / 19000); // quoted in both directions, buy back cheaper
+
+    const auto cycles = graph.findCycles();
+    ASSERT_EQ(1, cycles.size());
+    EXPECT_NEAR(20000.0 / 19000 - 1, cycles[0].gain, epsilon);
+    EXPECT_EQ("BTC -> USD -> BTC : 5.26316%", graph.to_string(cycles[0]));
+}
+
+TEST(ArbitrageMonitor, streaming)
+{
+    ArbitrageMonitor monitor;
+    EXPECT_TRUE(monitor.setRate("USD", "EUR", 0.5).found.empty());
+    EXPECT_TRUE(monitor.setRate("EUR", "GBP", 0.5).found.empty());
+    EXPECT_TRUE(monitor.setRate("GBP", "USD", 4.0).found.empty()); // break-even
+
+    auto update = monitor.setRate("GBP", "USD", 4.4); // 0.5 * 0.5 * 4.4 = 1.1
+    ASSERT_EQ(1, update.found.size());
+    EXPECT_NEAR(0.1, update.found[0].gain, epsilon);
+    EXPECT_EQ(3, update.found[0].nodes.size());
+    EXPECT_TRUE(update.vanished.empty());
+    EXPECT_EQ(1, monitor.cycles().size());
+
+    update = monitor.setRate("USD", "JPY", 100); // unrelated pair
+    EXPECT_TRUE(update.found.empty());
+    EXPECT_TRUE(update.vanished.empty());
+    EXPECT_EQ(1, monitor.cycles().size());
+
+    update = monitor.setRate("EUR", "GBP", 0.4); // 0.5 * 0.4 * 4.4 = 0.88, the implied reverse direction pays
+    ASSERT_EQ(1, update.vanished.size());
+    ASSERT_EQ(1, update.found.size());
+    EXPECT_NEAR(1 / 0.88 - 1, update.found[0].gain, epsilon);
+    EXPECT_EQ(1, monitor.cycles().size());
+
+    update = monitor.setRate("EUR", "GBP", 1 / 2.2); // break-even both ways
+    EXPECT_EQ(1, update.vanished.size());
+    EXPECT_TRUE(update.found.empty());
+    EXPECT_TRUE(monitor.cycles().empty());
+}
+
+TEST(ArbitrageMonitor, streamRows)
+{
+    ArbitrageMonitor monitor;
+    CsvFile::RowType row;
+    for (const std::string line : { "USD,EUR,0.5", "\"EUR\",\"GBP\",0.5\r", "", "GBP,USD,4.4" }) {
+        CsvFile::parseLine(line, row);
+        monitor.setRate(row);
+    }
+    EXPECT_EQ(3, monitor.graph().numNodes());
+    ASSERT_EQ(1, monitor.cycles().size());
+    EXPECT_NEAR(0.1, monitor.cycles()[0].gain, epsilon);
+}
+
+TEST(ArbitrageMonitor, invalidRows)
+{
+    ArbitrageMonitor monitor;
+    CsvFile::RowType row;
+    for (const std::string line : { "USD,EUR,0.5", "EUR,GBP,0.5", "GBP,USD,4.4", "USD,JPY,100" }) {
+        CsvFile::parseLine(line, row);
+        monitor.setRate(row);
+    }
+    ASSERT_EQ(1, monitor.cycles().size());
+    const std::size_t numEdges = monitor.graph().edges().size();
+
+    // a self edge, and non-positive or non-finite rates between known nodes without an edge, are logged and dropped
+    for (const std::string line : { "USD,USD,1.0", "EUR,JPY,0", "JPY,GBP,-2", "EUR,JPY,nan", "CHF,CHF,1" }) {
+        CsvFile::parseLine(line, row);
+        const auto update = monitor.setRate(row);
+        EXPECT_TRUE(update.found.empty()) << line;
+        EXPECT_TRUE(update.vanished.empty()) << line;
+    }
+    EXPECT_EQ(4, monitor.graph().numNodes());
+    EXPECT_EQ(numEdges, monitor.graph().edges().size());
+    ASSERT_EQ(1, monitor.cycles().size());
+    EXPECT_NEAR(0.1, monitor.cycles()[0].gain, epsilon);
+    EXPECT_TRUE(monitor.setRate("USD", "EUR", 0).found.empty());
+}
+
+TEST(ArbitrageMonitor, matchesBatch)
+{
+    ArbitrageGraph graph;
+    graph.setRate("USD", "EUR", 0.9);
+    graph.setRate("EUR", "GBP", 0.85);
+    graph.setRate("GBP", "USD", 1.2); // 0.918
+    graph.setRate("USD", "BTC", 0.00002);
+    graph.setRate("BTC", "ETH", 20);
+    graph.setRate("ETH", "USD", 2600); // 1.04
+    EXPECT_EQ(graph.findCycles().size(), ArbitrageMonitor { graph }.cycles().size());
+
+    ArbitrageMonitor monitor { graph };
+    monitor.setRate("ETH", "USD", 2400); // 0.96
+    monitor.setRate("GBP", "USD", 1.4); // 1.071
+    graph.setRate("ETH", "USD", 2400);
+    graph.setRate("GBP", "USD", 1.4);
+
+    const auto expected = graph.findCycles();
+    const auto cycles = monitor.cycles();
+    ASSERT_EQ(expected.size(), cycles.size());
+    for (const auto& cycle : cycles) {
+        EXPECT_TRUE(std::any_of(expected.begin(), expected.end(), [&](const auto& other) { return std::abs(other.gain - cycle.gain) < epsilon; }));
+    }
+}
@@ -6,6 +6,7 @@
  */
 
 #include "lib/Asset.hpp"
+#include "lib/Utils.hpp"
 
 #include <gtest/gtest.h>
 
@@ -29,3 +30,25 @@ TEST(Asset, Asset2)
     EXPECT_EQ(78, asset1.ohlc().at(0).close);
     EXPECT_EQ(77, asset1.ohlc().at(1).close);
 }
+
+TEST(Asset, Asset3)
+{
+    const AssetInfo info {};
+    const DateRange range { Utils::toTimePoint("2010-09-10"), Utils::toTimePoint("2010-09-10") };
+    const Asset asset1 { "VOO", "../../data/test", info, range };
+    ASSERT_EQ(1, asset1.ohlc().size());
+    EXPECT_EQ(78, asset1.ohlc().at(0).close);
+
+    const DateRange range2 { Utils::toTimePoint("2010-09-09"), Utils::toTimePoint("2010-09-09") };
+    const Asset asset2 { "VOO", "../../data/test", info, range2 };
+    ASSERT_EQ(1, asset2.ohlc().size());
+    EXPECT_EQ(77, asset2.ohlc().at(0).close);
+}
+
+TEST(Asset, recentRange)
+{
+    const DateRange range = OhlcList::recentRange(30);
+    EXPECT_EQ(OhlcList::defaultRange().maxDate, range.maxDate);
+    EXPECT_EQ(OhlcList::defaultRange().maxDate - std::chrono::days { 30 }, range.minDate);
+    EXPECT_EQ(OhlcList::defaultRange().minDate, OhlcList::recentRange(100 * 365).minDate); // clamped to the default window
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "lib/BarStore.hpp"
+#include "lib/Utils.hpp"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+
+using namespace portopt;
+
+namespace {
+
+// 120 minute bars from 2024-01-31 23:00 UTC into February, close = 100 + i
+OhlcList minuteBars()
+{
+    const TimePoint start = Utils::toDateTime("2024-01-31 23:00Z");
+    OhlcVector data;
+    for (int i = 119; i >= 0; --i) { // most recent first
+        const double close = 100 + i;
+        Ohlc bar { close - 0.5, close + 1, close - 1, close, 10 };
+        bar.timepoint = start + std::chrono::minutes { i };
+        bar.valid = true;
+        data.push_back(bar);
+    }
+    return OhlcList { std::move(data), OhlcTimeFrame::Minute };
+}
+
+} // anonymous namespace
+
+TEST(BarStore, dateTime)
+{
+    EXPECT_EQ(Utils::toDateTime("2024-12-13 09:30:00-05:00"), std::chrono::system_clock::from_time_t(1734100200));
+    EXPECT_EQ(Utils::toDateTime("2024-12-13T14:30:00Z"), std::chrono::system_clock::from_time_t(1734100200));
+    EXPECT_EQ(Utils::toDateTime("2024-12-13"), Utils::toTimePoint("2024-12-13"));
+    EXPECT_EQ(Utils::toDateTimeString(Utils::toDateTime("2024-12-13 09:31:15")), "2024-12-13 09:31:15");
+    EXPECT_EQ(Utils::toDateTime("2024-12-13 09:31"), Utils::toDateTime("2024-12-13 09:31:00.000"));
+}
+
+TEST(BarStore, intradayCsv)
+{
+    const auto filePath = std::filesystem::temp_directory_path() / "portopt-intraday.csv";
+    {
+        std::ofstream file { filePath };
+        file << "Datetime,Open,High,Low,Close,Volume,Dividends,Stock Splits\n";
+        file << "2024-12-12 15:59:00-05:00,10,11,9,10.5,100,0.0,0.0\n";
+        file << "2024-12-13 09:30:00-05:00,11,12,10,11.5,200,0.0,0.0\n";
+        file << "2024-12-13 09:31:00-05:00,12,13,11,12.5,300,0.0,0.0\n";
+    }
+    const CsvFile csv { filePath, true };
+    const OhlcList bars { csv, OhlcTimeFrame::Minute };
+    ASSERT_EQ(bars.size(), 3); // no forward filled entries between the bars
+    EXPECT_EQ(bars.at(0).timepoint, std::chrono::system_clock::from_time_t(1734100260));
+    EXPECT_EQ(bars.at(1).timepoint - bars.at(2).timepoint, std::chrono::minutes { 17 * 60 + 31 });
+    EXPECT_DOUBLE_EQ(bars.at(0).close, 12.5);
+    std::filesystem::remove(filePath);
+}
+
+TEST(BarStore, monthlyChunks)
+{
+    const auto root = std::filesystem::temp_directory_path() / "portopt-bar-store";
+    std::filesystem::remove_all(root);
+    const BarStore store { root };
+    const OhlcList bars = minuteBars();
+    ASSERT_TRUE(store.save("TEST", bars));
+    EXPECT_EQ(store.symbols(), std::vector<std::string> { "TEST" });
+    EXPECT_EQ(store.months("TEST"), (std::vector<std::string> { "2024-01", "2024-02" }));
+
+    const DateRange all { Utils::toTimePoint("2024-01-01"), Utils::toTimePoint("2024-03-01") };
+    const OhlcList loaded = store.load("TEST", all);
+    ASSERT_EQ(loaded.size(), bars.size());
+    EXPECT_EQ(loaded.timeFrame(), OhlcTimeFrame::Minute);
+    for (size_t i = 0; i < bars.size(); ++i) {
+        EXPECT_EQ(loaded.at(i).timepoint, bars.at(i).timepoint);
+        EXPECT_DOUBLE_EQ(loaded.at(i).close, bars.at(i).close);
+    }
+
+    // only the February chunk is mapped, and cut at the end of the range
+    const DateRange february { Utils::toDateTime("2024-02-01 00:00Z"), Utils::toDateTime("2024-02-01 00:29Z") };
+    size_t chunks = 0;
+    store.forEachChunk("TEST", february, [&](const BarStore::Chunk& chunk) {
+        EXPECT_EQ(chunk.month, "2024-02");
+        EXPECT_EQ(chunk.time.size(), 60);
+        chunks++;
+    });
+    EXPECT_EQ(chunks, 1);
+    const OhlcList part = store.load("TEST", february);
+    ASSERT_EQ(part.size(), 30);
+    EXPECT_DOUBLE_EQ(part.at(0).close, 189);
+    EXPECT_DOUBLE_EQ(part.at(29).close, 160);
+
+    // bar statistics and hourly bars of the loaded minutes
+    const auto& hourly = loaded.resample(OhlcTimeFrame::Hourly);
+    ASSERT_EQ(hourly.size(), 2);
+    EXPECT_EQ(hourly.at(0).timepoint, Utils::toDateTime("2024-02-01 00:00Z"));
+    EXPECT_DOUBLE_EQ(hourly.at(0).open, 159.5);
+    EXPECT_DOUBLE_EQ(hourly.at(0).close, 219);
+    EXPECT_DOUBLE_EQ(hourly.at(0).high, 220);
+    EXPECT_DOUBLE_EQ(hourly.at(1).low, 99);
+    EXPECT_DOUBLE_EQ(hourly.at(1).volume, 600);
+    EXPECT_EQ(loaded.returns(1, PriceType::Close).size(), bars.size() - 1);
+
+    std::filesystem::remove_all(root);
+}
+
+TEST(BarStore, mergeChunks)
+{
+    const auto root = std::filesystem::temp_directory_path() / "portopt-bar-store-merge";
+    std::filesystem::remove_all(root);
+    const BarStore store { root };
+    const OhlcList bars = minuteBars();
+    ASSERT_TRUE(store.save("TEST", bars));
+
+    // a later import of the last 30 minutes with one corrected bar and 10 new ones
+    const TimePoint start = Utils::toDateTime("2024-02-01 00:30Z");
+    OhlcVector data;
+    for (int i = 39; i >= 0; --i) { // most recent first
+        const double close = i == 0 ? 1 : 190 + i;
+        Ohlc bar { close, close, close, close, 10 };
+        bar.timepoint = start + std::chrono::minutes { i };
+        bar.valid = true;
+        data.push_back(bar);
+    }
+    ASSERT_TRUE(store.save("TEST", OhlcList { std::move(data), OhlcTimeFrame::Minute }));
+
+    const DateRange all { Utils::toTimePoint("2024-01-01"), Utils::toTimePoint("2024-03-01") };
+    const OhlcList loaded = store.load("TEST", all);
+    ASSERT_EQ(loaded.size(), 130);
+    EXPECT_DOUBLE_EQ(loaded.at(0).close, 229); // new
+    EXPECT_DOUBLE_EQ(loaded.at(39).close, 1); // replaced
+    EXPECT_DOUBLE_EQ(loaded.at(40).close, 189); // kept
+    EXPECT_DOUBLE_EQ(loaded.at(129).close, 100); // January chunk untouched
+
+    // the whole last day of the range is included
+    const DateRange february { Utils::toDateTime("2024-02-01 00:00Z"), Utils::toDateTime("2024-02-01 23:59:59Z") };
+    EXPECT_EQ(store.load("TEST", february).size(), 70);
+    std::filesystem::remove_all(root);
+}
+
+TEST(BarStore, invalidChunk)
+{
+    const auto root = std::filesystem::temp_directory_path() / "portopt-bar-store-invalid";
+    std::filesystem::remove_all(root);
+    const BarStore store { root };
+    ASSERT_TRUE(store.save("TEST", minuteBars()));
+    EXPECT_FALSE(std::filesystem::exists(root / "TEST" / "2024-02.bin.tmp")); // renamed into place
+
+    // a truncated close column in the February chunk, the chunk is skipped instead of read past its end
+    const ColumnFile february { root / "TEST" / "2024-02.bin" };
+    ColumnFileWriter writer;
+    for (const auto* name : { "open", "high", "low", "volume" }) {
+        const auto column = february.float64(name);
+        writer.add(name, std::vector<double> { column.begin(), column.end() });
+    }
+    const auto time = february.uint64("time");
+    writer.add("time", std::vector<std::uint64_t> { time.begin(), time.end() });
+    writer.add("close", std::vector<double> { 1, 2 });
+    ASSERT_TRUE(writer.save(root / "TEST" / "2024-02-bad.bin"));
+    std::filesystem::rename(root / "TEST" / "2024-02-bad.bin", root / "TEST" / "2024-02.bin");
+
+    const DateRange all { Utils::toTimePoint("2024-01-01"), Utils::toTimePoint("2024-03-01") };
+    EXPECT_EQ(store.load("TEST", all).size(), 60); // January only
+    std::filesystem::remove_all(root);
+}
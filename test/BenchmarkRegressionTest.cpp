@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "lib/BenchmarkRegression.hpp"
+#include "lib/Market.hpp"
+#include "lib/ReturnMatrix.hpp"
+#include "lib/Utils.hpp"
+#include "test/TestMarket.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+using namespace portopt;
+
+namespace {
+
+constexpr double epsilon = 1e-9;
+
+Market makeMarket()
+{
+    std::vector<std::vector<double>> prices(4, std::vector<double>(80));
+    for (std::size_t a = 0; a < 4; ++a) {
+        const auto k = static_cast<double>(a);
+        for (std::size_t i = 0; i < 80; ++i) {
+            const auto t = static_cast<double>(i);
+            prices[a][i] = 100 + (10 * std::sin(t * 0.3)) + (k * std::cos(t * (0.5 + k)));
+        }
+    }
+    return portopt::makeMarket(prices);
+}
+
+std::vector<double> series(const ReturnMatrix& returns, std::size_t asset, std::size_t size)
+{
+    return { returns.series(asset), returns.series(asset) + size };
+}
+
+} // anonymous namespace
+
+TEST(BenchmarkRegression, fit)
+{
+    const Market market = makeMarket();
+    const ReturnMatrix& returns = market.returns(1, PriceType::Close);
+    const BenchmarkRegression regression { returns, { "S0", "MISSING", "S3" } };
+    ASSERT_EQ((std::vector<std::string> { "S0", "S3" }), regression.benchmarks());
+    EXPECT_EQ(returns.numPeriods(), regression.length());
+    EXPECT_EQ(252, regression.periodsPerYear());
+
+    const auto& self = regression.fit(0, 0);
+    EXPECT_NEAR(1, self.beta, epsilon);
+    EXPECT_NEAR(0, self.alpha, epsilon);
+    EXPECT_NEAR(1, self.rSquared, epsilon);
+    EXPECT_NEAR(0, self.trackingError, 1e-7);
+
+    const std::size_t n = returns.numPeriods();
+    for (std::size_t a = 0; a < returns.numAssets(); ++a) {
+        for (std::size_t k = 0; k < 2; ++k) {
+            const auto x = series(returns, k == 0 ? 0 : 3, n);
+            const auto y = series(returns, a, n);
+            const auto [slope, intercept] = Utils::linearRegression(x, y);
+            const auto& item = regression.fit(a, k);
+            EXPECT_EQ(n, item.size);
+            EXPECT_NEAR(slope, item.beta, 1e-7);
+            EXPECT_NEAR(intercept, item.alpha, 1e-9);
+            const double correlation = Utils::pearsonCorrelation(x, y);
+            EXPECT_NEAR(correlation * correlation, item.rSquared, 1e-7);
+            std::vector<double> active(n);
+            for (std::size_t t = 0; t < n; ++t) {
+                active[t] = y[t] - x[t];
+            }
+            EXPECT_NEAR(Utils::stdDev(active), item.trackingError, 1e-7);
+        }
+    }
+}
+
+TEST(BenchmarkRegression, rolling)
+{
+    const Market market = makeMarket();
+    const ReturnMatrix& returns = market.returns(1, PriceType::Close);
+    const BenchmarkRegression regression { returns, { "S0" } };
+    constexpr std::size_t window = 20;
+    const auto rolling = regression.rolling(2, 0, window);
+    ASSERT_EQ(returns.numPeriods() - window + 1, rolling.size());
+
+    // the most recent window matches a regression over the last window periods
+    const BenchmarkRegression recent { returns, { "S0" }, window };
+    EXPECT_EQ(window, recent.length());
+    EXPECT_NEAR(recent.fit(2, 0).beta, rolling.front().beta, 1e-7);
+    EXPECT_NEAR(recent.fit(2, 0).alpha, rolling.front().alpha, 1e-9);
+    EXPECT_NEAR(recent.fit(2, 0).rSquared, rolling.front().rSquared, 1e-7);
+    EXPECT_NEAR(recent.fit(2, 0).trackingError, rolling.front().trackingError, 1e-7);
+
+    // and the oldest one the first window periods of the series
+    const std::size_t last = rolling.size() - 1;
+    const std::vector<double> x(returns.series(0) + last, returns.series(0) + last + window);
+    const std::vector<double> y(returns.series(2) + last, returns.series(2) + last + window);
+    EXPECT_NEAR(Utils::linearRegression(x, y).first, rolling.back().beta, 1e-7);
+    EXPECT_TRUE(regression.rolling(2, 0, returns.numPeriods() + 1).empty());
+}
+
+TEST(BenchmarkRegression, tradingPeriods)
+{
+    // S0 and S1 are forward filled over the weekends while S2 also trades on them, the oldest day is a weekday
+    constexpr std::size_t numDays = 141;
+    std::vector<Asset> assets;
+    std::vector<std::vector<double>> weekdays;
+    for (std::size_t a = 0; a < 3; ++a) {
+        const auto k = static_cast<double>(a);
+        std::vector<double> prices(numDays);
+        for (std::size_t i = 0; i < numDays; ++i) {
+            prices[i] = 100 + (10 * std::sin(static_cast<double>(i) * (0.3 + (0.1 * k)))) + (k * std::cos(static_cast<double>(i)));
+        }
+        assets.emplace_back("S" + std::to_string(a), a < 2 ? makeWeekdayOhlc(prices) : makeOhlc(prices), AssetInfo {});
+        weekdays.push_back(weekdayPrices(prices));
+    }
+    const Market calendar { assets };
+    const Market trading = portopt::makeMarket(weekdays); // the same prices without the weekends
+
+    const ReturnMatrix& returns = calendar.returns(1, PriceType::Close);
+    const ReturnMatrix& expected = trading.returns(1, PriceType::Close);
+    ASSERT_EQ(expected.numPeriods(), returns.tradingPeriods().size());
+    EXPECT_FALSE(isWeekend(returns.timepoints()[returns.tradingPeriods().back()]));
+
+    // the weekend moves of S2 are compounded into the next Monday
+    const auto series = returns.tradingSeries(2);
+    for (std::size_t t = 0; t < series.size(); ++t) {
+        EXPECT_NEAR(expected.series(2)[t], series[t], 1e-12);
+    }
+
+    const BenchmarkRegression regression { returns, { "S0" } };
+    const BenchmarkRegression reference { expected, { "S0" } };
+    EXPECT_EQ(reference.length(), regression.length());
+    for (std::size_t a = 1; a < 3; ++a) {
+        EXPECT_NEAR(reference.fit(a, 0).beta, regression.fit(a, 0).beta, 1e-9);
+        EXPECT_NEAR(reference.fit(a, 0).alpha, regression.fit(a, 0).alpha, 1e-12);
+        EXPECT_NEAR(reference.fit(a, 0).trackingError, regression.fit(a, 0).trackingError, 1e-9);
+    }
+    const auto rolling = regression.rolling(2, 0, 20);
+    ASSERT_EQ(reference.rolling(2, 0, 20).size(), rolling.size());
+    EXPECT_NEAR(reference.rolling(2, 0, 20).back().beta, rolling.back().beta, 1e-9);
+}
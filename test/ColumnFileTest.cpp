@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "lib/ColumnFile.hpp"
+#include "lib/CsvFile.hpp"
+#include "lib/EnumUtils.hpp"
+#include "lib/Market.hpp"
+#include "lib/MarketInfo.hpp"
+#include "lib/Utils.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+using namespace portopt;
+
+TEST(ColumnFile, roundTrip)
+{
+    const auto filePath = std::filesystem::temp_directory_path() / "portopt-column-file.bin";
+
+    ColumnFileWriter writer;
+    writer.add("f64", std::vector<double> { 1.5, -2, 1e300 });
+    writer.add("matrix", std::vector<float> { 1, 2, 3, 4, 5, 6 }, 3);
+    writer.add("u64", std::vector<std::uint64_t> { 7, 0, 1ULL << 40 });
+    writer.add("bits", std::vector<bool> { true, false, true, true, false, false, false, false, true });
+    writer.add("text", std::vector<std::string> { "VOO", "", "Vanguard, S&P 500" });
+    ASSERT_TRUE(writer.save(filePath));
+
+    const ColumnFile file { filePath };
+    ASSERT_TRUE(file.isOpen());
+    EXPECT_EQ(5, file.columns().size());
+    for (const auto& column : file.columns()) {
+        EXPECT_EQ(0, column.offset % 64) << column.name;
+    }
+
+    const auto f64 = file.float64("f64");
+    ASSERT_EQ(3, f64.size());
+    EXPECT_EQ(1e300, f64[2]);
+
+    const auto* matrix = file.find("matrix");
+    ASSERT_NE(nullptr, matrix);
+    EXPECT_EQ((std::vector<std::size_t> { 2, 3 }), matrix->shape);
+    const auto values = file.float32("matrix");
+    ASSERT_EQ(6, values.size());
+    EXPECT_EQ(6, values[5]);
+
+    EXPECT_EQ(1ULL << 40, file.uint64("u64")[2]);
+    EXPECT_EQ((std::vector<bool> { true, false, true, true, false, false, false, false, true }), file.bitmap("bits"));
+    EXPECT_EQ((std::vector<std::string_view> { "VOO", "", "Vanguard, S&P 500" }), file.strings("text"));
+
+    EXPECT_TRUE(file.float64("missing").empty());
+    EXPECT_TRUE(file.float64("u64").empty()); // wrong type
+
+    std::filesystem::remove(filePath);
+}
+
+TEST(ColumnFile, corruptColumn)
+{
+    const auto filePath = std::filesystem::temp_directory_path() / "portopt-column-file-corrupt.bin";
+    ColumnFileWriter writer;
+    writer.add("f64", std::vector<double> { 1, 2, 3, 4 });
+    writer.add("text", std::vector<std::string> { "VOO", "BND" });
+    ASSERT_TRUE(writer.save(filePath));
+    ASSERT_TRUE(ColumnFile { filePath }.isOpen());
+
+    // rewrites one schema entry in place, the schema keeps its length
+    const auto corrupt = [&filePath](const std::string& from, const std::string& to) {
+        std::string bytes;
+        {
+            std::ifstream input { filePath, std::ios::binary };
+            bytes.assign(std::istreambuf_iterator<char> { input }, {});
+        }
+        const auto pos = bytes.find(from);
+        ASSERT_NE(std::string::npos, pos) << from;
+        bytes.replace(pos, from.size(), to);
+        std::ofstream output { filePath, std::ios::binary | std::ios::trunc };
+        output << bytes;
+    };
+
+    corrupt("\"shape\":[4]", "\"shape\":[9]"); // more values than the column holds
+    ColumnFile file { filePath };
+    EXPECT_FALSE(file.isOpen());
+    EXPECT_TRUE(file.float64("f64").empty());
+
+    corrupt("\"shape\":[9]", "\"shape\":[2]"); // fewer values than its bytes
+    EXPECT_FALSE(ColumnFile { filePath }.isOpen());
+
+    corrupt("\"shape\":[2]", "\"shape\":[4]");
+    EXPECT_TRUE(ColumnFile { filePath }.isOpen());
+    corrupt("\"dataSize\":6", "\"dataSize\":2"); // string offsets past the characters
+    EXPECT_FALSE(ColumnFile { filePath }.isOpen());
+
+    std::filesystem::remove(filePath);
+}
+
+TEST(ColumnFile, marketInfo)
+{
+    OhlcVector data;
+    const auto today = Utils::toTimePoint("2020-01-31");
+    for (std::size_t i = 0; i < 400; ++i) {
+        Ohlc item { 100.0 + static_cast<double>(i % 7) };
+        item.timepoint = today - std::chrono::days { i };
+        data.push_back(item);
+    }
+    const Market market { { Asset { "A", OhlcList { data }, {} }, Asset { "B", 10, {} } } };
+    const MarketInfo info { market };
+    ASSERT_EQ(2, info.rows().size());
+    EXPECT_EQ(1, info.index("B"));
+    EXPECT_EQ(MarketInfo::npos, info.index("C"));
+
+    const auto filePath = std::filesystem::temp_directory_path() / "portopt-market-info.bin";
+    ASSERT_TRUE(info.saveBinary(filePath));
+    const auto loaded = MarketInfo::load(filePath);
+    ASSERT_EQ(info.rows().size(), loaded.rows().size());
+    for (std::size_t i = 0; i < info.rows().size(); ++i) {
+        const auto& expected = info.rows()[i];
+        const auto& actual = loaded.rows()[i];
+        EXPECT_EQ(expected.symbol, actual.symbol);
+        EXPECT_EQ(expected.historySize, actual.historySize);
+        EXPECT_DOUBLE_EQ(expected.avgRisk, actual.avgRisk);
+        EXPECT_DOUBLE_EQ(expected.return30days, actual.return30days);
+        EXPECT_EQ(expected.risk.values(), actual.risk.values());
+        EXPECT_EQ(expected.tags, actual.tags);
+    }
+    EXPECT_EQ(info.etfs(), loaded.etfs());
+
+    // the CSV report has one column per tag with the same bits as the binary bitmaps
+    const auto csvPath = std::filesystem::temp_directory_path() / "portopt-market-info.csv";
+    info.saveCsv(csvPath);
+    const CsvFile csv { csvPath, true };
+    const ColumnFile file { filePath };
+    ASSERT_EQ(info.rows().size(), csv.data().size());
+    for (std::size_t tag = 0; tag < static_cast<std::size_t>(AssetClass::LastTag); ++tag) {
+        const auto name = "is-" + EnumUtils::to_string(static_cast<AssetClass>(tag));
+        const auto column = std::find(csv.header().begin(), csv.header().end(), name);
+        ASSERT_NE(csv.header().end(), column) << name;
+        const auto bits = file.bitmap(name);
+        ASSERT_EQ(info.rows().size(), bits.size()) << name;
+        for (std::size_t i = 0; i < bits.size(); ++i) {
+            EXPECT_EQ(bits[i] ? "1" : "0", csv.data()[i][static_cast<std::size_t>(column - csv.header().begin())]) << name;
+        }
+    }
+    EXPECT_TRUE(file.bitmap("is-Unclassified")[1]);
+    std::filesystem::remove(csvPath);
+    std::filesystem::remove(filePath);
+}
+
+TEST(ColumnFile, marketInfoShards)
+{
+    std::vector<Asset> assets;
+    const auto today = Utils::toTimePoint("2020-01-31");
+    for (int a = 0; a < 5; ++a) {
+        OhlcVector data;
+        for (std::size_t i = 0; i < 420; ++i) {
+            Ohlc item { 100.0 + static_cast<double>((i * (a + 1)) % 11) };
+            item.timepoint = today - std::chrono::days { i };
+            data.push_back(item);
+        }
+        assets.emplace_back("S" + std::to_string(a), OhlcList { data }, AssetInfo {});
+    }
+    const Market market { assets };
+    const MarketInfo info { market };
+    const auto directory = std::filesystem::temp_directory_path();
+
+    std::vector<MarketInfo> shards;
+    for (std::size_t shard = 0; shard < 3; ++shard) {
+        const auto filePath = directory / ("portopt-market-info-" + std::to_string(shard) + ".bin");
+        ASSERT_TRUE(MarketInfo(market, shard, 3).saveBinary(filePath, ColumnFile::Type::Float64));
+        shards.push_back(MarketInfo::load(filePath));
+        std::filesystem::remove(filePath);
+    }
+    const auto merged = MarketInfo::merge(shards);
+
+    // merging exact shards gives the same CSV as a single process
+    const auto readFile = [](const FilePath& filePath) {
+        std::ifstream file(filePath);
+        return std::string { std::istreambuf_iterator<char>(file), {} };
+    };
+    info.saveCsv(directory / "portopt-market-info-full.csv");
+    merged.saveCsv(directory / "portopt-market-info-merged.csv");
+    EXPECT_EQ(readFile(directory / "portopt-market-info-full.csv"), readFile(directory / "portopt-market-info-merged.csv"));
+    EXPECT_EQ(info.pearson().data(), merged.pearson().data());
+
+    // shards of another split overlap or leave the symbol order
+    EXPECT_TRUE(MarketInfo::merge({ shards[0], shards[0], shards[2] }).rows().empty());
+    EXPECT_TRUE(MarketInfo::merge({ shards[1], shards[0], shards[2] }).rows().empty());
+    std::filesystem::remove(directory / "portopt-market-info-full.csv");
+    std::filesystem::remove(directory / "portopt-market-info-merged.csv");
+}
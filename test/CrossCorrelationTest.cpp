@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "lib/CrossCorrelation.hpp"
+#include "lib/Market.hpp"
+#include "lib/ReturnMatrix.hpp"
+#include "lib/Utils.hpp"
+#include "test/TestMarket.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <random>
+
+using namespace portopt;
+
+constexpr double epsilon = 1e-9;
+
+namespace {
+
+// Pearson correlation of x[t] with y[t + lag] over their overlap
+double laggedPearson(const std::vector<double>& x, const std::vector<double>& y, int lag)
+{
+    const auto n = static_cast<int>(x.size());
+    std::vector<double> a;
+    std::vector<double> b;
+    for (int t = std::max(0, -lag); t < std::min(n, n - lag); ++t) {
+        a.push_back(x[t]);
+        b.push_back(y[t + lag]);
+    }
+    return Utils::pearsonCorrelation(a, b);
+}
+
+} // anonymous namespace
+
+TEST(CrossCorrelation, pearson)
+{
+    std::mt19937_64 rng { 3 };
+    std::normal_distribution<double> normal;
+    for (const std::size_t length : { 2, 3, 17, 64, 100 }) {
+        std::vector<double> x(length);
+        std::vector<double> y(length);
+        for (std::size_t t = 0; t < length; ++t) {
+            x[t] = 50 + normal(rng);
+            y[t] = (t >= 3 ? 0.8 * x[t - 3] : 0) + normal(rng); // y[t + 3] repeats x[t], y moves three entries earlier
+        }
+        const auto lags = CrossCorrelation::pearson(x, y, 10);
+        const int maxLag = static_cast<int>(std::min<std::size_t>(10, length - 2));
+        ASSERT_EQ(2 * maxLag + 1, lags.size());
+        for (int lag = -maxLag; lag <= maxLag; ++lag) {
+            EXPECT_NEAR(laggedPearson(x, y, lag), lags[lag + maxLag], epsilon) << length << " " << lag;
+        }
+        if (length == 100) {
+            const auto best = std::max_element(lags.begin(), lags.end()) - lags.begin();
+            EXPECT_EQ(3, best - maxLag); // y leads x
+        }
+    }
+    EXPECT_EQ(0, CrossCorrelation::pearson(std::vector<double>(20, 1.0), std::vector<double>(20, 2.0), 3)[1]);
+}
+
+TEST(CrossCorrelation, leadLag)
+{
+    // S0 repeats the moves of the leader S2 two days later, S1 and S3 are unrelated noise, S4 follows S2 one day later
+    std::mt19937_64 rng { 5 };
+    std::normal_distribution<double> normal;
+    constexpr std::size_t length = 120;
+    std::vector<double> leader(length + 2);
+    for (auto& value : leader) {
+        value = normal(rng) * 0.01;
+    }
+    const auto prices = [&](const std::function<double(std::size_t)>& move) {
+        std::vector<double> result(length, 100);
+        for (std::size_t t = length - 1; t-- > 0;) {
+            result[t] = result[t + 1] * (1 + move(t));
+        }
+        return result;
+    };
+    std::vector<Asset> assets;
+    assets.emplace_back("S0", makeOhlc(prices([&](std::size_t t) { return leader[t + 2] + (normal(rng) * 0.002); })), AssetInfo {});
+    assets.emplace_back("S1", makeOhlc(prices([&](std::size_t) { return normal(rng) * 0.01; })), AssetInfo {});
+    assets.emplace_back("S2", makeOhlc(prices([&](std::size_t t) { return leader[t]; })), AssetInfo {});
+    assets.emplace_back("S3", makeOhlc(prices([&](std::size_t) { return normal(rng) * 0.01; })), AssetInfo {});
+    assets.emplace_back("S4", makeOhlc(prices([&](std::size_t t) { return leader[t + 1] + (normal(rng) * 0.002); })), AssetInfo {});
+    const Market market { assets };
+    const ReturnMatrix& returns = market.returns(1);
+    ASSERT_EQ(5, returns.numAssets());
+
+    const auto pairs = CrossCorrelation::leadLag(returns, 4, 0.5);
+    ASSERT_EQ(3, pairs.size());
+    for (const auto& pair : pairs) {
+        const auto series = [&](std::size_t a) { return std::vector<double>(returns.series(a), returns.series(a) + returns.numPeriods()); };
+        EXPECT_NEAR(laggedPearson(series(pair.first), series(pair.second), pair.lag), pair.correlation, epsilon);
+        EXPECT_NEAR(laggedPearson(series(pair.first), series(pair.second), 0), pair.zeroLagCorrelation, epsilon);
+        EXPECT_GT(pair.correlation, 0.5);
+        const auto first = returns.symbols()[pair.first];
+        const auto second = returns.symbols()[pair.second];
+        if (first == "S0" && second == "S2") {
+            EXPECT_EQ(2, pair.lag); // S2 leads S0 by two days
+        } else if (first == "S0" && second == "S4") {
+            EXPECT_EQ(1, pair.lag);
+        } else {
+            EXPECT_EQ("S2", first);
+            EXPECT_EQ("S4", second);
+            EXPECT_EQ(-1, pair.lag); // S2 leads S4 by one day
+        }
+    }
+
+    // Asset::correlation compares prices, the other asset offset entries earlier
+    const auto& s0 = market.get("S0");
+    const auto& s2 = market.get("S2");
+    const auto vector0 = s0.ohlc().toVector(50, 0, PriceType::HL2);
+    const auto vector2 = s2.ohlc().toVector(50, 3, PriceType::HL2);
+    EXPECT_NEAR(Utils::pearsonCorrelation(vector0, vector2), s0.correlation(s2, PriceType::HL2, false, 50, 3), epsilon);
+    EXPECT_NEAR(s0.correlation(s2, PriceType::HL2, false, 400, 0), s0.correlation(s2, PriceType::HL2, false, 400), epsilon);
+    EXPECT_EQ(0, s0.correlation(s2, PriceType::HL2, false, 400, length - 1));
+}
+
+TEST(CrossCorrelation, leadLagTradingDays)
+{
+    // S1 repeats the moves of S0 one trading day later, both forward filled over the weekends
+    std::mt19937_64 rng { 9 };
+    std::normal_distribution<double> normal;
+    constexpr std::size_t numDays = 211; // the oldest day is a weekday
+    const auto today = Utils::toTimePoint("2020-01-31");
+    std::vector<double> moves; // of S0 on the trading days, most recent first
+    for (std::size_t i = 0; i < numDays; ++i) {
+        if (!isWeekend(today - std::chrono::days { i })) {
+            moves.push_back(normal(rng) * 0.01);
+        }
+    }
+    std::vector<std::vector<double>> prices(2, std::vector<double>(numDays, 100));
+    std::size_t k = moves.size() - 1; // trading day of the oldest day
+    for (std::size_t i = numDays - 1; i-- > 0;) {
+        if (isWeekend(today - std::chrono::days { i })) {
+            prices[0][i] = prices[0][i + 1];
+            prices[1][i] = prices[1][i + 1];
+            continue;
+        }
+        --k;
+        prices[0][i] = prices[0][i + 1] * (1 + moves[k]);
+        prices[1][i] = prices[1][i + 1] * (1 + (k + 1 < moves.size() ? moves[k + 1] : 0) + (normal(rng) * 0.001));
+    }
+    const Market market { { Asset { "S0", makeWeekdayOhlc(prices[0]), {} }, Asset { "S1", makeWeekdayOhlc(prices[1]), {} } } };
+    const ReturnMatrix& returns = market.returns(1);
+
+    const auto pairs = CrossCorrelation::leadLag(returns, 4, 0.5);
+    ASSERT_EQ(1, pairs.size());
+    EXPECT_EQ(-1, pairs[0].lag); // S0 leads S1 by one trading day
+    const auto x = returns.tradingSeries(pairs[0].first);
+    const auto y = returns.tradingSeries(pairs[0].second);
+    EXPECT_NEAR(laggedPearson(x, y, -1), pairs[0].correlation, epsilon);
+    EXPECT_LT(std::abs(laggedPearson(x, y, -3)), 0.2); // no echo of the Friday to Monday gap
+}
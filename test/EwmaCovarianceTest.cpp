@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "lib/EwmaCovariance.hpp"
+#include "lib/Market.hpp"
+#include "lib/PortfolioBatch.hpp"
+#include "lib/ReturnMatrix.hpp"
+#include "lib/RiskModel.hpp"
+#include "lib/Utils.hpp"
+#include "test/TestMarket.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+
+using namespace portopt;
+
+namespace {
+
+constexpr std::size_t numAssets = 6;
+constexpr std::size_t numPrices = 100;
+constexpr double lambda = 0.9;
+
+const TimePoint lastDate = Utils::toTimePoint("2020-04-30");
+
+// Daily prices of correlated assets, most recent first
+std::vector<std::vector<double>> makePrices()
+{
+    return factorPrices(numAssets, numPrices, 11, { 0.01 }, [](std::size_t asset, std::size_t) { return 0.5 + (0.2 * static_cast<double>(asset)); }, 0.004);
+}
+
+// The prices without the most recent skip days, at most size days of them
+Market makeMarket(std::size_t skip = 0, std::size_t size = numPrices)
+{
+    auto prices = makePrices();
+    for (auto& series : prices) {
+        series.erase(series.begin(), series.begin() + static_cast<std::ptrdiff_t>(skip));
+        series.resize(std::min(series.size(), size));
+    }
+    return portopt::makeMarket(prices, 100, lastDate - std::chrono::days { skip });
+}
+
+// The same with the weekends forward filled, as a daily history of stocks
+Market makeWeekdayMarket(std::size_t skip = 0)
+{
+    std::vector<Asset> assets;
+    const auto prices = makePrices();
+    for (std::size_t a = 0; a < numAssets; ++a) {
+        const std::vector<double> series(prices[a].begin() + static_cast<std::ptrdiff_t>(skip), prices[a].end());
+        assets.emplace_back("S" + std::to_string(100 + a), makeWeekdayOhlc(series, lastDate - std::chrono::days { skip }), AssetInfo {});
+    }
+    return Market { assets };
+}
+
+} // anonymous namespace
+
+TEST(EwmaCovariance, weightedSum)
+{
+    const Market market = makeMarket();
+    const ReturnMatrix& returns = market.returns(1);
+    const EwmaCovariance model { returns, lambda };
+    ASSERT_EQ(numAssets, model.size());
+    EXPECT_EQ(returns.numPeriods(), model.count());
+    EXPECT_EQ(returns.timepoints().front(), model.lastTime());
+
+    // Σ(i,j) = Σ λᵗ r(t,i) r(t,j) / Σ λᵗ with t = 0 the most recent period
+    const std::size_t n = returns.numPeriods();
+    for (std::size_t i = 0; i < numAssets; ++i) {
+        for (std::size_t j = 0; j < numAssets; ++j) {
+            double sum {};
+            double weight {};
+            for (std::size_t t = 0; t < n; ++t) {
+                const double w = std::pow(lambda, static_cast<double>(t));
+                sum += w * returns.series(i)[t] * returns.series(j)[t];
+                weight += w;
+            }
+            EXPECT_NEAR(sum / weight, model.covariance(i, j), 1e-15);
+        }
+    }
+
+    std::vector<double> weights(numAssets, 1.0 / numAssets);
+    const Matrix covariance = model.covariance();
+    double variance {};
+    for (std::size_t i = 0; i < numAssets; ++i) {
+        for (std::size_t j = 0; j < numAssets; ++j) {
+            variance += weights[i] * covariance(i, j) * weights[j];
+        }
+    }
+    EXPECT_NEAR(std::sqrt(variance), model.risk(weights), 1e-12);
+    EXPECT_NEAR(std::sqrt(covariance(2, 2)), model.volatilities()[2], 1e-15);
+}
+
+TEST(EwmaCovariance, incrementalUpdate)
+{
+    const Market older = makeMarket(20);
+    const Market newer = makeMarket();
+    const EwmaCovariance full { newer.returns(1), lambda };
+
+    EwmaCovariance model { older.returns(1), lambda };
+    EXPECT_EQ(20, model.update(newer.returns(1)));
+    EXPECT_EQ(0, model.update(newer.returns(1))); // already up to date
+    EXPECT_EQ(full.count(), model.count());
+    EXPECT_EQ(full.lastTime(), model.lastTime());
+    for (std::size_t i = 0; i < numAssets; ++i) {
+        for (std::size_t j = 0; j < numAssets; ++j) {
+            EXPECT_NEAR(full.covariance(i, j), model.covariance(i, j), 1e-15);
+        }
+    }
+
+    // a single bar given as a vector
+    EwmaCovariance single { older.returns(1), lambda };
+    const ReturnMatrix& returns = newer.returns(1);
+    for (std::size_t t = 20; t-- > 0;) {
+        const double* row = returns.timeMajor().row(t);
+        single.update(std::vector<double>(row, row + numAssets), returns.timepoints()[t]);
+    }
+    EXPECT_EQ(full.lastTime(), single.lastTime());
+    EXPECT_NEAR(full.covariance(1, 4), single.covariance(1, 4), 1e-15);
+}
+
+TEST(EwmaCovariance, tradingDays)
+{
+    // the weekends are neither flat bars nor decay steps: the model matches one over the weekdays only
+    const Market calendar = makeWeekdayMarket();
+    std::vector<std::vector<double>> weekdays;
+    for (const auto& prices : makePrices()) {
+        weekdays.push_back(weekdayPrices(prices, lastDate));
+    }
+    const Market trading = portopt::makeMarket(weekdays, 100, lastDate);
+    const EwmaCovariance full { calendar.returns(1), lambda };
+    const EwmaCovariance expected { trading.returns(1), lambda };
+    EXPECT_EQ(expected.count(), full.count());
+    EXPECT_EQ(lastDate, full.lastTime());
+    for (std::size_t i = 0; i < numAssets; ++i) {
+        for (std::size_t j = 0; j < numAssets; ++j) {
+            EXPECT_NEAR(expected.covariance(i, j), full.covariance(i, j), 1e-15);
+        }
+    }
+
+    // a snapshot that ends on a Saturday stops at the Friday, the update carries on from there
+    EwmaCovariance model { makeWeekdayMarket(5).returns(1), lambda };
+    EXPECT_EQ(lastDate - std::chrono::days { 6 }, model.lastTime());
+    EXPECT_EQ(4, model.update(calendar.returns(1))); // Monday to Thursday
+    EXPECT_EQ(full.count(), model.count());
+    EXPECT_NEAR(full.covariance(2, 3), model.covariance(2, 3), 1e-15);
+}
+
+TEST(EwmaCovariance, gapRebuild)
+{
+    // the newer matrix starts after the model's last bar, applying it would skip the days in between
+    EwmaCovariance model { makeMarket(50).returns(1), lambda };
+    const Market market = makeMarket(0, 30);
+    const ReturnMatrix& recent = market.returns(1);
+    ASSERT_GT(recent.timepoints().back(), model.lastTime());
+    const EwmaCovariance expected { recent, lambda };
+    EXPECT_EQ(recent.numPeriods(), model.update(recent));
+    EXPECT_EQ(expected.count(), model.count());
+    EXPECT_EQ(expected.lastTime(), model.lastTime());
+    EXPECT_EQ(expected.covariance(1, 2), model.covariance(1, 2));
+}
+
+TEST(EwmaCovariance, saveLoad)
+{
+    const Market market = makeMarket();
+    const EwmaCovariance& model = market.ewmaCovariance(lambda);
+    EXPECT_EQ(&model, &market.ewmaCovariance(lambda)); // cached
+
+    const auto filePath = std::filesystem::temp_directory_path() / "EwmaCovarianceTest.bin";
+    ASSERT_TRUE(model.save(filePath));
+    const EwmaCovariance loaded = EwmaCovariance::load(filePath);
+    std::filesystem::remove(filePath);
+
+    EXPECT_EQ(model.symbols(), loaded.symbols());
+    EXPECT_EQ(model.lambda(), loaded.lambda());
+    EXPECT_EQ(model.count(), loaded.count());
+    EXPECT_EQ(model.lastTime(), loaded.lastTime());
+    const std::vector<double> weights { 0.1, 0.2, 0.3, 0.2, 0.1, 0.1 };
+    EXPECT_DOUBLE_EQ(model.risk(weights), loaded.risk(weights));
+
+    EXPECT_TRUE(EwmaCovariance::load("missing-ewma.bin").symbols().empty());
+}
+
+TEST(EwmaCovariance, portfolioBatch)
+{
+    const Market market = makeMarket();
+    const EwmaCovariance& model = market.ewmaCovariance(lambda);
+    const RiskModel& riskModel = market.riskModel();
+
+    Matrix weights { 3, riskModel.size() };
+    for (std::size_t k = 0; k < weights.rows(); ++k) {
+        weights(k, k) = 0.5;
+        weights(k, k + 3) = 0.5;
+    }
+    const auto result = PortfolioBatch::evaluate(market, weights, 0, &model);
+    const auto dense = PortfolioBatch::evaluate(market, weights);
+    ASSERT_EQ(3, result.risks.size());
+    for (std::size_t k = 0; k < weights.rows(); ++k) {
+        std::vector<double> w(model.size());
+        for (std::size_t i = 0; i < riskModel.size(); ++i) {
+            w[model.index(riskModel.symbols()[i])] = weights(k, i);
+        }
+        EXPECT_NEAR(model.risk(w), result.risks[k], 1e-15);
+        EXPECT_NEAR(riskModel.risk(std::vector<double>(weights.row(k), weights.row(k) + weights.cols())), dense.risks[k], 1e-15);
+        EXPECT_EQ(dense.returns[k], result.returns[k]);
+    }
+}
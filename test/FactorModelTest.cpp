@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "lib/FactorModel.hpp"
+#include "lib/Market.hpp"
+#include "lib/ReturnMatrix.hpp"
+#include "lib/Utils.hpp"
+#include "test/TestMarket.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <filesystem>
+
+using namespace portopt;
+
+namespace {
+
+constexpr std::size_t numAssets = 12;
+constexpr std::size_t numPrices = 200;
+
+// Daily returns driven by two common factors, the market and rates, plus a little noise of each asset
+Market makeMarket()
+{
+    const auto loading = [](std::size_t asset, std::size_t factor) {
+        if (factor == 0) {
+            return 0.5 + (0.1 * static_cast<double>(asset)); // beta
+        }
+        return asset % 2 == 0 ? 1.0 : -0.5; // duration
+    };
+    return portopt::makeMarket(factorPrices(numAssets, numPrices, 7, { 0.01, 0.005 }, loading, 0.001), 100);
+}
+
+// sqrt(wᵀΣw) with the dense sample covariance
+double sampleRisk(const ReturnMatrix& returns, const std::vector<double>& weights)
+{
+    const std::size_t n = returns.numPeriods();
+    std::vector<double> portfolio(n);
+    for (std::size_t a = 0; a < returns.numAssets(); ++a) {
+        for (std::size_t t = 0; t < n; ++t) {
+            portfolio[t] += weights[a] * returns.series(a)[t];
+        }
+    }
+    return Utils::stdDev(portfolio);
+}
+
+std::vector<double> makeWeights()
+{
+    std::vector<double> weights(numAssets);
+    for (std::size_t a = 0; a < numAssets; ++a) {
+        weights[a] = (1 + static_cast<double>(a % 5)) / 30;
+    }
+    return weights;
+}
+
+} // anonymous namespace
+
+TEST(FactorModel, allComponents)
+{
+    const Market market = makeMarket();
+    const ReturnMatrix& returns = market.returns(1);
+    const FactorModel model { returns, numAssets };
+    ASSERT_EQ(numAssets, model.numFactors());
+    EXPECT_EQ(returns.symbols(), model.symbols());
+    EXPECT_EQ(3, model.index("S103"));
+
+    // every component kept: the exact sample covariance
+    const auto weights = makeWeights();
+    EXPECT_NEAR(sampleRisk(returns, weights), model.risk(weights), 1e-12);
+    EXPECT_NEAR(1, model.explainedVariance(), 1e-9);
+    for (std::size_t f = 1; f < model.numFactors(); ++f) {
+        EXPECT_GE(model.factorVariances()[f - 1], model.factorVariances()[f]);
+    }
+}
+
+TEST(FactorModel, topComponents)
+{
+    const Market market = makeMarket();
+    const ReturnMatrix& returns = market.returns(1);
+    const FactorModel& model = market.factorModel(2);
+    EXPECT_EQ(&model, &market.factorModel(2)); // cached
+    ASSERT_EQ(2, model.numFactors());
+    EXPECT_GT(model.explainedVariance(), 0.95);
+
+    const auto weights = makeWeights();
+    const double exact = sampleRisk(returns, weights);
+    EXPECT_NEAR(exact, model.risk(weights), exact * 0.01);
+    EXPECT_EQ(2, model.exposures(weights).size());
+
+    // a single asset keeps its own variance through D
+    std::vector<double> single(numAssets);
+    single[model.index("S100")] = 1;
+    EXPECT_NEAR(sampleRisk(returns, single), model.risk(single), sampleRisk(returns, single) * 0.02);
+
+    const auto filePath = std::filesystem::temp_directory_path() / "portopt-factor-model.bin";
+    ASSERT_TRUE(model.save(filePath));
+    const FactorModel loaded = FactorModel::load(filePath);
+    EXPECT_EQ(model.symbols(), loaded.symbols());
+    EXPECT_EQ(model.factorVariances(), loaded.factorVariances());
+    EXPECT_DOUBLE_EQ(model.risk(weights), loaded.risk(weights));
+    std::filesystem::remove(filePath);
+}
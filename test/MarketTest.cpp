@@ -0,0 +1,286 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "lib/ColumnFile.hpp"
+#include "lib/Market.hpp"
+#include "lib/ReturnMatrix.hpp"
+#include "lib/RollingStats.hpp"
+#include "lib/TiledCorrelation.hpp"
+#include "lib/Utils.hpp"
+#include "test/TestMarket.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <filesystem>
+
+using namespace portopt;
+
+constexpr double epsilon = 1e-9;
+
+namespace {
+
+Market makeMarket()
+{
+    return Market { {
+        Asset { "A", makeOhlc({ 104, 103, 101, 102, 100 }), {} },
+        Asset { "B", makeOhlc({ 50, 52, 51, 49, 50, 48 }), {} },
+        Asset { "C", 10, {} }, // no price history
+    } };
+}
+
+} // anonymous namespace
+
+TEST(Market, returnMatrix)
+{
+    const Market market = makeMarket();
+    const ReturnMatrix& returns = market.returns(1);
+    EXPECT_EQ(&returns, &market.returns(1)); // cached
+
+    ASSERT_EQ(2, returns.numAssets());
+    ASSERT_EQ(4, returns.numPeriods()); // aligned on the shortest history
+    EXPECT_EQ(0, returns.index("A"));
+    EXPECT_EQ(1, returns.index("B"));
+    EXPECT_EQ(ReturnMatrix::npos, returns.index("C"));
+
+    EXPECT_NEAR(1.0 / 103, returns.assetMajor()(0, 0), epsilon);
+    EXPECT_NEAR(-2.0 / 52, returns.timeMajor()(0, 1), epsilon);
+    EXPECT_NEAR(2.0 / 100, returns.series(0)[3], epsilon);
+
+    const ReturnMatrix& logReturns = market.returns(2, PriceType::Close, ReturnType::Log);
+    ASSERT_EQ(3, logReturns.numPeriods());
+    EXPECT_NEAR(std::log(104.0 / 101), logReturns.timeMajor()(0, 0), epsilon);
+}
+
+TEST(Market, returnMatrixCutoff)
+{
+    OhlcList stale = makeOhlc({ 10, 11, 12, 13, 14, 15, 16, 17, 18, 19 });
+    OhlcVector staleData;
+    for (std::size_t i = 0; i < stale.size(); ++i) {
+        staleData.push_back(stale.at(i));
+        staleData.back().timepoint -= std::chrono::days { 3 }; // ends three days before the others
+    }
+    const Market market { {
+        Asset { "A", makeOhlc({ 10, 11, 12, 11, 10, 11, 12, 13, 12, 11 }), {} },
+        Asset { "B", makeOhlc({ 20, 21, 20, 19, 20, 21, 22, 21, 20, 19 }), {} },
+        Asset { "S", OhlcList { staleData }, {} },
+        Asset { "Y", makeOhlc({ 5, 6, 5 }), {} }, // young listing
+    } };
+
+    // the young listing is left out instead of truncating A and B, the stale history never lines up
+    const ReturnMatrix& returns = market.returns(1);
+    ASSERT_EQ((std::vector<std::string> { "A", "B" }), returns.symbols());
+    EXPECT_EQ(9, returns.numPeriods());
+
+    const ReturnMatrix all { market, 1, PriceType::HL2, ReturnType::Simple, OhlcTimeFrame::Daily, PriceAdjustment::None, 3 };
+    ASSERT_EQ((std::vector<std::string> { "A", "B", "Y" }), all.symbols());
+    EXPECT_EQ(2, all.numPeriods());
+
+    // each pair keeps its own common history
+    const auto pairs = RollingStats::correlation(market, 2, PriceType::HL2);
+    for (const auto& pair : pairs) {
+        if (pair.symbol1 == "A" && pair.symbol2 == "B") {
+            EXPECT_EQ(8, pair.values.size());
+        } else if (pair.symbol1 == "A" && pair.symbol2 == "Y") {
+            EXPECT_EQ(1, pair.values.size());
+        } else if (pair.symbol2 == "S" || pair.symbol1 == "S") {
+            EXPECT_TRUE(pair.values.empty());
+        }
+    }
+}
+
+TEST(Market, maxDrawdown)
+{
+    const Market market = makeMarket();
+    const auto result = market.maxDrawdown(0, 4);
+    ASSERT_EQ(3, result.size());
+    EXPECT_NEAR((101.0 - 102) / 102 * 100, result.at("A"), epsilon); // oldest first: 102, 101, 103, 104
+    EXPECT_NEAR((50.0 - 52) / 52 * 100, result.at("B"), epsilon); // oldest first: 49, 51, 52, 50
+    EXPECT_EQ(0, result.at("C")); // a single price
+    EXPECT_TRUE(market.maxDrawdown(6, 10).empty());
+}
+
+TEST(Market, monthlyReturns)
+{
+    // 2019-11-23 to 2020-01-31, one price per month
+    std::vector<double> prices(70);
+    for (std::size_t i = 0; i < prices.size(); ++i) {
+        prices[i] = i < 31 ? 120 : (i < 62 ? 110 : 100);
+    }
+    const Market market { { Asset { "A", makeOhlc(prices), {} } } };
+    const ReturnMatrix& monthly = market.returns(1, PriceType::Close, ReturnType::Simple, OhlcTimeFrame::Monthly);
+    EXPECT_EQ(OhlcTimeFrame::Monthly, monthly.timeFrame());
+    ASSERT_EQ(2, monthly.numPeriods());
+    EXPECT_NEAR(10.0 / 110, monthly.series(0)[0], epsilon);
+    EXPECT_NEAR(10.0 / 100, monthly.series(0)[1], epsilon);
+    EXPECT_NE(&monthly, &market.returns(1, PriceType::Close));
+}
+
+TEST(Market, adjustedReturns)
+{
+    OhlcVector data;
+    const auto today = Utils::toTimePoint("2020-01-31");
+    for (const double price : { 51, 50, 100, 98 }) {
+        Ohlc item { price };
+        item.timepoint = today - std::chrono::days { data.size() };
+        data.push_back(item);
+    }
+    data[1].splits = 2;
+    const Market market { { Asset { "A", OhlcList { data }, {} } } };
+    const ReturnMatrix& raw = market.returns(1, PriceType::Close);
+    const ReturnMatrix& adjusted = market.returns(1, PriceType::Close, ReturnType::Simple, OhlcTimeFrame::Daily, PriceAdjustment::Splits);
+    EXPECT_NE(&raw, &adjusted);
+    EXPECT_EQ(PriceAdjustment::Splits, adjusted.adjustment());
+    EXPECT_NEAR(-0.5, raw.series(0)[1], epsilon); // the split looks like a crash
+    EXPECT_NEAR(0, adjusted.series(0)[1], epsilon);
+    EXPECT_NEAR(1.0 / 50, adjusted.series(0)[0], epsilon);
+}
+
+TEST(Market, tiledCorrelation)
+{
+    std::vector<Asset> assets;
+    for (int a = 0; a < 7; ++a) {
+        std::vector<double> prices;
+        for (int i = 0; i < 60; ++i) {
+            prices.push_back(100 + (10 * std::sin(i * 0.3 * (1 + (a % 3)))) + (a * std::cos(i * 0.7)));
+        }
+        assets.emplace_back("S" + std::to_string(a), makeOhlc(prices), AssetInfo {});
+    }
+    const Market market { assets };
+    const ReturnMatrix& returns = market.returns(1);
+
+    const auto cachePath = std::filesystem::temp_directory_path() / "portopt-returns.bin";
+    const auto matrixPath = std::filesystem::temp_directory_path() / "portopt-correlation.bin";
+    ASSERT_TRUE(returns.save(cachePath));
+
+    // the streamed cache holds the same returns as the in-memory matrix
+    const auto streamedPath = std::filesystem::temp_directory_path() / "portopt-returns-streamed.bin";
+    ASSERT_TRUE(ReturnMatrix::saveCache(streamedPath, market, 1));
+    {
+        const ColumnFile saved { cachePath };
+        const ColumnFile streamed { streamedPath };
+        EXPECT_EQ(saved.strings("symbols"), streamed.strings("symbols"));
+        EXPECT_EQ(saved.find("returns")->shape, streamed.find("returns")->shape);
+        const auto expected = saved.float64("returns");
+        const auto actual = streamed.float64("returns");
+        EXPECT_TRUE(std::equal(expected.begin(), expected.end(), actual.begin(), actual.end()));
+    }
+    std::filesystem::remove(streamedPath);
+
+    const TiledCorrelation tiled { cachePath, 3 * 59 * 8 * 3 }; // a few assets per block
+    ASSERT_TRUE(tiled.isOpen());
+    EXPECT_EQ(7, tiled.numAssets());
+    EXPECT_EQ(59, tiled.numPeriods());
+    EXPECT_LT(tiled.blockSize(), 7);
+
+    const auto series = [&](std::size_t a) { return std::vector<double>(returns.series(a), returns.series(a) + returns.numPeriods()); };
+    ASSERT_TRUE(tiled.saveMatrix(matrixPath));
+    const ColumnFile file { matrixPath };
+    const auto matrix = file.float32("correlation");
+    ASSERT_EQ(49, matrix.size());
+    for (std::size_t i = 0; i < 7; ++i) {
+        for (std::size_t j = 0; j < 7; ++j) {
+            const double expected = i == j ? 1 : Utils::pearsonCorrelation(series(i), series(j));
+            EXPECT_NEAR(expected, matrix[(i * 7) + j], 1e-6);
+        }
+    }
+
+    const auto topK = tiled.topK(2);
+    const auto pairs = tiled.pairsAbove(0.5);
+    for (std::size_t i = 0; i < 7; ++i) {
+        ASSERT_EQ(2, topK[i].size());
+        EXPECT_GE(topK[i][0].correlation, topK[i][1].correlation);
+        for (std::size_t j = 0; j < 7; ++j) {
+            if (j != i && j != topK[i][0].index) {
+                EXPECT_LE(Utils::pearsonCorrelation(series(i), series(j)), topK[i][0].correlation + epsilon);
+            }
+        }
+    }
+    for (const auto& pair : pairs) {
+        EXPECT_NEAR(Utils::pearsonCorrelation(series(pair.first), series(pair.second)), pair.correlation, epsilon);
+        EXPECT_GE(pair.correlation, 0.5);
+    }
+    std::size_t expectedPairs {};
+    for (std::size_t i = 0; i < 7; ++i) {
+        for (std::size_t j = i + 1; j < 7; ++j) {
+            expectedPairs += Utils::pearsonCorrelation(series(i), series(j)) >= 0.5 ? 1 : 0;
+        }
+    }
+    EXPECT_EQ(expectedPairs, pairs.size());
+    EXPECT_FALSE(pairs.empty());
+
+    std::filesystem::remove(cachePath);
+    std::filesystem::remove(matrixPath);
+}
+
+TEST(Market, tiledCorrelationShards)
+{
+    std::vector<Asset> assets;
+    for (int a = 0; a < 11; ++a) {
+        std::vector<double> prices;
+        for (int i = 0; i < 40; ++i) {
+            prices.push_back(100 + (10 * std::sin(i * 0.2 * (1 + (a % 4)))) + (a * std::cos(i * 0.9)));
+        }
+        assets.emplace_back("S" + std::to_string(a), makeOhlc(prices), AssetInfo {});
+    }
+    const Market market { assets };
+    const auto directory = std::filesystem::temp_directory_path();
+    const auto cachePath = directory / "portopt-shard-returns.bin";
+    ASSERT_TRUE(market.returns(1).save(cachePath));
+
+    const TiledCorrelation tiled { cachePath, 3 * 39 * 8 * 3 }; // a few assets per block
+    ASSERT_TRUE(tiled.isOpen());
+    ASSERT_TRUE(tiled.saveMatrix(directory / "portopt-shard-full.bin"));
+
+    // more shards than block rows leaves some of them empty
+    for (const std::size_t numShards : { 1, 2, 3, 20 }) {
+        std::vector<FilePath> shardPaths;
+        std::size_t nextRow {};
+        for (std::size_t shard = 0; shard < numShards; ++shard) {
+            const auto rows = tiled.shardRows(shard, numShards);
+            EXPECT_EQ(nextRow, rows.first);
+            EXPECT_EQ(0, rows.first % tiled.blockSize());
+            nextRow = rows.second;
+            shardPaths.push_back(directory / ("portopt-shard-" + std::to_string(shard) + ".bin"));
+            ASSERT_TRUE(tiled.saveShard(shardPaths.back(), shard, numShards));
+        }
+        EXPECT_EQ(11, nextRow);
+
+        ASSERT_TRUE(TiledCorrelation::mergeShards(shardPaths, directory / "portopt-shard-merged.bin"));
+        const ColumnFile full { directory / "portopt-shard-full.bin" };
+        const ColumnFile merged { directory / "portopt-shard-merged.bin" };
+        EXPECT_EQ(full.strings("symbols"), merged.strings("symbols"));
+        const auto expected = full.float32("correlation");
+        const auto actual = merged.float32("correlation");
+        EXPECT_TRUE(std::equal(expected.begin(), expected.end(), actual.begin(), actual.end()));
+
+        if (numShards > 1) { // a missing shard is detected
+            shardPaths.pop_back();
+            EXPECT_FALSE(TiledCorrelation::mergeShards(shardPaths, directory / "portopt-shard-merged.bin"));
+        }
+        for (const auto& shardPath : shardPaths) {
+            std::filesystem::remove(shardPath);
+        }
+    }
+
+    // no shards, or a shard without symbols, merge into nothing
+    EXPECT_FALSE(TiledCorrelation::mergeShards({}, directory / "portopt-shard-merged.bin"));
+    ColumnFileWriter empty;
+    empty.add("symbols", std::vector<std::string> {});
+    empty.add("rows", std::vector<std::uint64_t> { 0, 0 });
+    empty.reserve("correlation", ColumnFile::Type::Float32, { 0, 0 });
+    ASSERT_TRUE(empty.save(directory / "portopt-shard-empty.bin"));
+    EXPECT_FALSE(TiledCorrelation::mergeShards({ directory / "portopt-shard-empty.bin" }, directory / "portopt-shard-merged.bin"));
+
+    // a budget below one asset per block still runs, one asset at a time
+    EXPECT_EQ(1, (TiledCorrelation { cachePath, 1 }).blockSize());
+
+    for (const auto* name : { "portopt-shard-returns.bin", "portopt-shard-full.bin", "portopt-shard-merged.bin", "portopt-shard-19.bin",
+             "portopt-shard-empty.bin" }) {
+        std::filesystem::remove(directory / name);
+    }
+}
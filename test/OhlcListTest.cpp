@@ -6,9 +6,12 @@
  */
 
 #include "lib/OhlcList.hpp"
+#include "lib/Utils.hpp"
 
 #include <gtest/gtest.h>
 
+#include <random>
+
 using namespace portopt;
 
 TEST(OhlcList, sameDay)
@@ -150,3 +153,147 @@ TEST(OhlcList, priceDirection8)
     const OhlcList list { { ohlc0, ohlc1 } };
     EXPECT_EQ(PriceDirection::VeryUp, list.priceDirection(0, 1));
 }
+
+TEST(OhlcList, allTimeHigh)
+{
+    // most recent first
+    const OhlcList list { {
+        Ohlc { 95, 100, 90, 95 },
+        Ohlc { 75, 80, 70, 75 },
+        Ohlc { 115, 120, 110, 115 },
+        Ohlc { 85, 90, 80, 85 },
+        Ohlc { 95, 100, 90, 95 },
+    } };
+
+    EXPECT_EQ(120, list.allTimeHigh(0));
+    EXPECT_EQ(120, list.allTimeHigh(2));
+    EXPECT_EQ(100, list.allTimeHigh(3));
+    EXPECT_EQ(0, list.allTimeHigh(5));
+    EXPECT_EQ((std::vector<double> { 120, 120, 120, 100, 100 }), list.allTimeHigh());
+
+    EXPECT_EQ(100, list.highestHigh(0, 2));
+    EXPECT_EQ(120, list.highestHigh(1, 3));
+    EXPECT_EQ(90, list.highestHigh(3, 4));
+    EXPECT_EQ(70, list.lowestLow(0, 5));
+    EXPECT_EQ(80, list.lowestLow(2, 4));
+
+    EXPECT_EQ(2, list.timeUnderWater(0));
+    EXPECT_EQ(0, list.timeUnderWater(2));
+    EXPECT_EQ(1, list.timeUnderWater(3));
+
+    EXPECT_NEAR(-10, list.drawdown(0, 2), 1e-9);
+    EXPECT_NEAR(-25, list.percentFromAth(0), 1e-9);
+    EXPECT_NEAR((70.0 - 120) / 120 * 100, list.maxDrawdown(0, 5), 1e-9);
+    EXPECT_NEAR(-20, list.maxDrawdown(2, 5), 1e-9);
+}
+
+TEST(OhlcList, maxDrawdown)
+{
+    std::mt19937_64 engine { 3 };
+    std::uniform_real_distribution<double> move { -0.03, 0.03 };
+    OhlcVector data;
+    double price = 100;
+    for (int i = 0; i < 150; ++i) {
+        price *= 1 + move(engine);
+        data.push_back(Ohlc { price, price * 1.01, price * 0.98, price });
+    }
+    const OhlcList list { data };
+
+    // every window against one pass from the oldest entry to the most recent
+    for (size_t begin = 0; begin < data.size(); ++begin) {
+        double peak {};
+        double expected {};
+        for (size_t end = begin + 1; end <= data.size(); ++end) {
+            peak = 0;
+            expected = 0;
+            for (size_t i = end; i-- > begin;) {
+                peak = std::max(peak, data[i].high);
+                expected = std::min(expected, (data[i].low - peak) / peak * 100);
+            }
+            ASSERT_NEAR(expected, list.maxDrawdown(begin, end), 1e-9) << begin << " " << end;
+        }
+    }
+}
+
+TEST(OhlcList, resample)
+{
+    // 2021-01-01 (Friday) to 2021-04-09 (Friday), weekends are forward filled dummies, most recent first
+    OhlcVector data;
+    const auto first = Utils::toTimePoint("2021-01-01");
+    for (int day = 98; day >= 0; --day) {
+        Ohlc item { 100.0 + day, 105.0 + day, 95.0 + day, 101.0 + day, 10 };
+        item.timepoint = first + std::chrono::days { day };
+        item.dummy = (day + 6) % 7 < 2; // Saturday and Sunday
+        item.dividends = day == 20 || day == 25 ? 0.5 : 0;
+        item.splits = day == 10 || day == 12 ? 2 : 0;
+        data.push_back(item);
+    }
+    data[0].high = 1000; // most recent bar, a dummy would be skipped
+    const OhlcList list { data };
+    ASSERT_FALSE(data[0].dummy);
+    EXPECT_EQ(&list, &list.resample(OhlcTimeFrame::Daily));
+
+    const auto& monthly = list.resample(OhlcTimeFrame::Monthly);
+    EXPECT_EQ(&monthly, &list.resample(OhlcTimeFrame::Monthly)); // cached
+    EXPECT_EQ(OhlcTimeFrame::Monthly, monthly.timeFrame());
+    ASSERT_EQ(4, monthly.size());
+    const auto& april = monthly.at(0);
+    EXPECT_EQ(Utils::toTimePoint("2021-04-01"), april.timepoint);
+    EXPECT_EQ(1000, april.high);
+    const auto& january = monthly.at(3);
+    EXPECT_EQ(Utils::toTimePoint("2021-01-01"), january.timepoint);
+    EXPECT_EQ(100, january.open); // January 1st
+    EXPECT_EQ(101 + 28, january.close); // Friday the 29th, the 30th and 31st are a weekend
+    EXPECT_EQ(95, january.low);
+    EXPECT_EQ(105 + 28, january.high);
+    EXPECT_EQ(210, january.volume); // 21 weekdays
+    EXPECT_EQ(1, january.dividends);
+    EXPECT_EQ(4, january.splits);
+    EXPECT_EQ(0, monthly.at(2).splits);
+    EXPECT_FALSE(january.dummy);
+
+    const auto& weekly = list.resample(OhlcTimeFrame::Weekly);
+    EXPECT_EQ(Utils::toTimePoint("2020-12-28"), weekly.at(weekly.size() - 1).timepoint); // Monday before the 1st
+    EXPECT_EQ(Utils::toTimePoint("2021-01-04"), weekly.at(weekly.size() - 2).timepoint);
+    EXPECT_EQ(50, weekly.at(weekly.size() - 2).volume);
+    EXPECT_EQ(2, list.resample(OhlcTimeFrame::Quarterly).size());
+    EXPECT_EQ(12, OhlcList::barsPerYear(monthly.timeFrame()));
+
+    // coarse bars can't be split into finer ones
+    EXPECT_EQ(0, monthly.resample(OhlcTimeFrame::Daily).size());
+    EXPECT_EQ(OhlcTimeFrame::Daily, monthly.resample(OhlcTimeFrame::Daily).timeFrame());
+}
+
+TEST(OhlcList, adjustment)
+{
+    // most recent first: a 2 for 1 split on entry 1, a 1 dividend on entry 2 copied by the forward filled entry 3
+    OhlcVector data;
+    for (const double close : { 52, 50, 100, 100, 100 }) {
+        data.emplace_back(close, close, close, close, 10);
+    }
+    data[1].splits = 2;
+    data[2].dividends = 1;
+    data[3] = data[2];
+    data[3].dummy = true;
+    const OhlcList list { data };
+
+    EXPECT_EQ(1, list.adjustmentFactor(4, PriceAdjustment::None));
+    EXPECT_DOUBLE_EQ(1, list.adjustmentFactor(1, PriceAdjustment::Splits)); // the split day is already in new shares
+    EXPECT_DOUBLE_EQ(0.5, list.adjustmentFactor(2, PriceAdjustment::Splits));
+    EXPECT_DOUBLE_EQ(0.5, list.adjustmentFactor(4, PriceAdjustment::Splits));
+    EXPECT_DOUBLE_EQ(0.5, list.adjustmentFactor(3, PriceAdjustment::Total)); // same factor as the entry it copies
+    EXPECT_DOUBLE_EQ(0.5 * 0.99, list.adjustmentFactor(4, PriceAdjustment::Total));
+    EXPECT_DOUBLE_EQ(49.5, list.adjustedPrice(4, PriceType::Close, PriceAdjustment::Total));
+    EXPECT_DOUBLE_EQ(52 / 49.5, list.totalReturnIndex().front());
+    EXPECT_DOUBLE_EQ(1, list.totalReturnIndex().back());
+
+    EXPECT_EQ(&list, &list.adjusted(PriceAdjustment::None));
+    const auto& splits = list.adjusted(PriceAdjustment::Splits);
+    EXPECT_EQ(&splits, &list.adjusted(PriceAdjustment::Splits)); // cached
+    EXPECT_DOUBLE_EQ(50, splits.at(2).close);
+    EXPECT_DOUBLE_EQ(20, splits.at(2).volume);
+    EXPECT_EQ(0, splits.at(1).splits);
+    EXPECT_DOUBLE_EQ(-0.5, list.priceChange(1, 1, PriceType::Close));
+    EXPECT_DOUBLE_EQ(0, splits.priceChange(1, 1, PriceType::Close));
+    EXPECT_NEAR(50 / 49.5 - 1, list.adjusted(PriceAdjustment::Total).priceChange(2, 2, PriceType::Close), 1e-12);
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "lib/AssetRatio.hpp"
+#include "lib/Market.hpp"
+#include "lib/PairScanner.hpp"
+#include "lib/Utils.hpp"
+#include "test/TestMarket.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <numbers>
+#include <random>
+
+using namespace portopt;
+
+constexpr double epsilon = 1e-9;
+
+namespace {
+
+// B is a random walk, A = exp(0.5) * B^1.5 times a mean reverting AR(1) noise with coefficient 0.8, C is independent
+std::vector<Asset> makeAssets(std::size_t length)
+{
+    std::mt19937_64 rng { 11 };
+    std::normal_distribution<double> normal;
+    std::vector<double> a(length);
+    std::vector<double> b(length);
+    std::vector<double> c(length);
+    double logB = std::log(50);
+    double logC = std::log(80);
+    double noise {};
+    for (std::size_t i = length; i-- > 0;) { // oldest first
+        logB += 0.01 * normal(rng);
+        logC += 0.01 * normal(rng);
+        noise = (0.8 * noise) + (0.01 * normal(rng));
+        b[i] = std::exp(logB);
+        c[i] = std::exp(logC);
+        a[i] = std::exp(0.5 + (1.5 * logB) + noise);
+    }
+    return { Asset { "A", makeOhlc(a), {} }, Asset { "B", makeOhlc(b), {} }, Asset { "C", makeOhlc(c), {} } };
+}
+
+} // anonymous namespace
+
+TEST(AssetRatio, ratio)
+{
+    const Market market { { Asset { "X", makeOhlc({ 10, 12, 9 }), {} }, Asset { "Y", makeOhlc({ 5, 4, 3, 2 }), {} } } };
+    const AssetRatio ratio { market.get("X"), market.get("Y") };
+    ASSERT_EQ(3, ratio.size());
+    EXPECT_DOUBLE_EQ(2, ratio.at(0).close);
+    EXPECT_DOUBLE_EQ(3, ratio.at(1).close);
+    EXPECT_DOUBLE_EQ(3, ratio.at(2).open);
+    EXPECT_EQ(market.get("X").ohlc().at(1).timepoint, ratio.at(1).timepoint);
+    EXPECT_EQ(&ratio.ohlc(), &ratio.ohlc()); // computed once
+    EXPECT_NEAR(-1.0 / 3.0, ratio.ohlc().priceChange(0, 1, PriceType::Close), epsilon); // 2 / 3 - 1
+}
+
+TEST(AssetRatio, cointegration)
+{
+    const Market market { makeAssets(600) };
+    const AssetRatio ratio { market.get("A"), market.get("B") };
+    const auto hedge = ratio.hedgeRatio(600, PriceType::Close);
+    EXPECT_NEAR(1.5, hedge.beta, 0.05);
+    EXPECT_EQ(&ratio.spread(600, PriceType::Close), &ratio.spread(600, PriceType::Close)); // cached
+
+    const auto test = ratio.cointegration(600, PriceType::Close);
+    EXPECT_EQ(600, test.size);
+    EXPECT_TRUE(test.cointegrated());
+    EXPECT_NEAR(-std::numbers::ln2 / std::log(0.8), test.halfLife, 1.5);
+
+    const AssetRatio unrelated { market.get("C"), market.get("B") };
+    EXPECT_FALSE(unrelated.cointegration(600, PriceType::Close).cointegrated());
+
+    // without lags the ADF statistic is the t statistic of a simple regression of dy on y(t-1)
+    const auto& spread = ratio.spread(600, PriceType::Close);
+    const std::vector<double> chronological(spread.rbegin(), spread.rend());
+    std::vector<double> x;
+    std::vector<double> y;
+    for (std::size_t t = 1; t < chronological.size(); ++t) {
+        x.push_back(chronological[t - 1]);
+        y.push_back(chronological[t] - chronological[t - 1]);
+    }
+    const auto [slope, intercept] = Utils::linearRegression(x, y);
+    double rss {};
+    double sxx {};
+    const double meanX = Utils::mean(x);
+    for (std::size_t i = 0; i < x.size(); ++i) {
+        rss += std::pow(y[i] - intercept - (slope * x[i]), 2);
+        sxx += std::pow(x[i] - meanX, 2);
+    }
+    const double tStatistic = slope / std::sqrt(rss / static_cast<double>(x.size() - 2) / sxx);
+    EXPECT_NEAR(tStatistic, Cointegration::adfStatistic(chronological, 0), 1e-6);
+}
+
+TEST(PairScanner, scan)
+{
+    const Market market { makeAssets(600) };
+    const auto pairs = PairScanner::scan(market, { "A", "B", "C", "MISSING" }, 500, 0.5);
+    ASSERT_EQ(1, pairs.size()); // C is rejected by the correlation screen
+    const auto& pair = pairs.front();
+    EXPECT_TRUE((pair.first == "A" && pair.second == "B") || (pair.first == "B" && pair.second == "A"));
+    EXPECT_GT(pair.correlation, 0.5);
+    EXPECT_TRUE(pair.test.cointegrated());
+    EXPECT_EQ(500, pair.test.size);
+
+    const AssetRatio ratio { market.get(pair.first), market.get(pair.second) };
+    EXPECT_DOUBLE_EQ(ratio.cointegration(500, PriceType::Close).adfStatistic, pair.test.adfStatistic);
+}
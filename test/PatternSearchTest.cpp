@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "lib/Market.hpp"
+#include "lib/PatternSearch.hpp"
+#include "lib/Utils.hpp"
+#include "test/TestMarket.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <set>
+
+using namespace portopt;
+
+constexpr double epsilon = 1e-5; // sqrt(2m(1 - correlation)) magnifies rounding near a perfect match
+
+namespace {
+
+// z-normalized Euclidean distance, one window at a time
+double naiveDistance(const std::vector<double>& query, const std::vector<double>& series, std::size_t offset)
+{
+    const std::size_t m = query.size();
+    const auto normalize = [m](std::vector<double> values) {
+        const double mean = Utils::mean(values);
+        double sumSq {};
+        for (const double value : values) {
+            sumSq += (value - mean) * (value - mean);
+        }
+        const double stdDev = std::sqrt(sumSq / static_cast<double>(m));
+        for (auto& value : values) {
+            value = stdDev > 0 ? (value - mean) / stdDev : 0;
+        }
+        return values;
+    };
+    const auto a = normalize(query);
+    const auto b = normalize({ series.begin() + static_cast<std::ptrdiff_t>(offset), series.begin() + static_cast<std::ptrdiff_t>(offset + m) });
+    double sum {};
+    for (std::size_t i = 0; i < m; ++i) {
+        sum += (a[i] - b[i]) * (a[i] - b[i]);
+    }
+    return std::sqrt(sum);
+}
+
+std::vector<double> randomWalk(std::size_t length, std::uint64_t seed)
+{
+    std::mt19937_64 rng { seed };
+    std::normal_distribution<double> normal;
+    std::vector<double> result(length);
+    double price = 100;
+    for (auto& value : result) {
+        price = std::max(1.0, price + normal(rng));
+        value = price;
+    }
+    return result;
+}
+
+} // anonymous namespace
+
+TEST(PatternSearch, distanceProfile)
+{
+    auto series = randomWalk(300, 1);
+    std::fill(series.begin() + 100, series.begin() + 130, 42.0); // flat windows
+    const std::vector<double> query(series.begin() + 200, series.begin() + 220);
+    const PatternSearch search { query, PriceType::Close };
+
+    const auto profile = search.distanceProfile(series);
+    ASSERT_EQ(300 - 20 + 1, profile.size());
+    for (std::size_t i = 0; i < profile.size(); ++i) {
+        const double expected = i >= 100 && i + 20 <= 130 ? std::sqrt(20.0) : naiveDistance(query, series, i);
+        EXPECT_NEAR(expected, profile[i], epsilon) << i;
+    }
+    EXPECT_NEAR(0, profile[200], epsilon);
+
+    const PatternSearch flat { std::vector<double>(20, 7.0), PriceType::Close };
+    const auto flatProfile = flat.distanceProfile(series);
+    EXPECT_NEAR(0, flatProfile[105], epsilon);
+    EXPECT_NEAR(std::sqrt(20.0), flatProfile[0], epsilon);
+    EXPECT_TRUE(search.distanceProfile(std::vector<double>(10, 1.0)).empty());
+}
+
+TEST(PatternSearch, search)
+{
+    // the last 30 days of A repeat, scaled and shifted, 150 days ago in A and 80 days ago in B
+    auto a = randomWalk(400, 2);
+    auto b = randomWalk(350, 3);
+    for (std::size_t i = 0; i < 30; ++i) {
+        a[150 + i] = (a[i] * 0.5) + 20;
+        b[80 + i] = (a[i] * 2) + 5;
+    }
+    const Market market { { Asset { "A", makeOhlc(a), {} }, Asset { "B", makeOhlc(b), {} } } };
+    const auto query = market.get("A").ohlc().toVector(30, 0, PriceType::Close);
+    const PatternSearch search { query, PriceType::Close, 10 };
+
+    const auto own = search.search(market.get("A"), 5, 30);
+    ASSERT_EQ(5, own.size());
+    EXPECT_EQ("A", own[0].symbol);
+    EXPECT_EQ(150, own[0].offset);
+    EXPECT_NEAR(0, own[0].distance, epsilon);
+    for (std::size_t i = 0; i < own.size(); ++i) {
+        EXPECT_GE(own[i].offset, 30);
+        EXPECT_NEAR(naiveDistance(query, a, own[i].offset), own[i].distance, epsilon);
+        for (std::size_t j = 0; j < i; ++j) {
+            EXPECT_GT(own[i].offset > own[j].offset ? own[i].offset - own[j].offset : own[j].offset - own[i].offset, 10);
+            EXPECT_GE(own[i].distance, own[j].distance);
+        }
+    }
+
+    const auto all = search.search(market, 3, 30);
+    ASSERT_EQ(3, all.size());
+    EXPECT_NEAR(0, all[0].distance, epsilon);
+    EXPECT_NEAR(0, all[1].distance, epsilon);
+    EXPECT_EQ(std::set<std::string>({ "A", "B" }), std::set<std::string>({ all[0].symbol, all[1].symbol }));
+    EXPECT_EQ(all[0].symbol == "A" ? 150 : 80, all[0].offset);
+    EXPECT_GT(all[2].distance, epsilon);
+}
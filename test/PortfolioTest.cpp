@@ -8,10 +8,17 @@
 #include "lib/Portfolio.hpp"
 #include "lib/Asset.hpp"
 #include "lib/Market.hpp"
+#include "lib/FactorModel.hpp"
+#include "lib/PortfolioBatch.hpp"
+#include "lib/RiskModel.hpp"
 #include "lib/Utils.hpp"
+#include "test/TestMarket.hpp"
 
 #include <gtest/gtest.h>
 
+#include <cmath>
+#include <set>
+
 using namespace portopt;
 
 constexpr double epsilon = 1e-3;
@@ -63,3 +70,181 @@ TEST(Portfolio, riskreturn2)
     EXPECT_NEAR(0.071, Utils::avgRisk(market, portfolio), epsilon);
     EXPECT_NEAR(0.10, Utils::avgReturn(market, portfolio), epsilon);
 }
+
+TEST(Portfolio, riskContributions)
+{
+    AssetInfo info1;
+    info1.avgRisk = 0.20;
+    info1.avgReturn = 0.10;
+    info1.correlation["B"] = 0.5;
+    const Asset asset1 { "A", 1, info1 };
+
+    AssetInfo info2;
+    info2.avgRisk = 0.10;
+    info2.avgReturn = 0.05;
+    info2.correlation["A"] = 0.5;
+    const Asset asset2 { "B", 1, info2 };
+
+    const Market market { { asset1, asset2 } };
+
+    Portfolio portfolio;
+    portfolio.set(asset1.symbol(), 50);
+    portfolio.set(asset2.symbol(), 50);
+    portfolio.set("CASH", 100);
+
+    const auto& model = market.riskModel();
+    const auto weights = model.weights(market, portfolio);
+    ASSERT_EQ(2, weights.size());
+    EXPECT_NEAR(0.25, weights.at(model.index("A")), epsilon);
+    EXPECT_NEAR(0.25, weights.at(model.index("B")), epsilon);
+
+    // σ² = 0.25²·0.2² + 0.25²·0.1² + 2·0.25²·0.2·0.1·0.5
+    const double volatility = std::sqrt(0.0025 + 0.000625 + 0.00125);
+    const auto result = model.contributions(weights);
+    EXPECT_NEAR(volatility, result.volatility, epsilon);
+    EXPECT_NEAR(volatility, Utils::avgRisk(market, portfolio), epsilon);
+    EXPECT_NEAR(volatility, result.component.at(0) + result.component.at(1), epsilon);
+    EXPECT_NEAR((0.25 * 0.2 + 0.25 * 0.1) / volatility, result.diversificationRatio, epsilon);
+    EXPECT_NEAR(0.0375, model.expectedReturn(weights), epsilon);
+}
+
+TEST(Portfolio, holdingsRiskModel)
+{
+    std::vector<Asset> assets;
+    for (const std::string symbol : { "A", "B", "C" }) {
+        AssetInfo info;
+        info.avgRisk = symbol == "A" ? 0.2 : 0.1;
+        for (const std::string other : { "A", "B", "C" }) {
+            info.correlation[other] = 0.3;
+        }
+        assets.emplace_back(symbol, 1, info);
+    }
+    const Market market { assets };
+
+    const RiskModel model { market, { "A", "C", "CASH" } };
+    ASSERT_EQ((std::vector<std::string> { "A", "C" }), model.symbols());
+    const auto& full = market.riskModel();
+    EXPECT_EQ(full.covariance()(0, 2), model.covariance()(0, 1));
+    EXPECT_EQ(model.covariance()(0, 1), model.covariance()(1, 0));
+    EXPECT_NEAR(0.04, model.covariance()(0, 0), epsilon);
+
+    Portfolio portfolio;
+    portfolio.set("A", 50);
+    portfolio.set("C", 50);
+    EXPECT_NEAR(Utils::avgRisk(market, portfolio, full), Utils::avgRisk(market, portfolio), epsilon);
+    EXPECT_EQ(0, Utils::avgRisk(market, Portfolio {}));
+}
+
+TEST(Portfolio, riskBackend)
+{
+    constexpr std::size_t numAssets = 30;
+    auto prices = factorPrices(numAssets, 60, 5, { 0.01 }, [](std::size_t, std::size_t) { return 1.0; }, 0.005);
+    prices.push_back({ 101, 100, 102, 99, 100 }); // too young for the return matrix behind the factor model
+    const Market market = makeMarket(prices);
+    const std::string young = "S" + std::to_string(numAssets);
+
+    // the dense model is the default however many holdings there are
+    Portfolio all;
+    std::set<std::string> symbols;
+    for (const auto& [symbol, asset] : market.assets()) {
+        if (symbol != young) {
+            all.set(symbol, 1);
+            symbols.insert(symbol);
+        }
+    }
+    all.set("CASH", 3);
+    EXPECT_EQ(Utils::avgRisk(market, all, RiskModel { market, symbols }), Utils::avgRisk(market, all));
+    EXPECT_EQ(Utils::avgRisk(market, all), Utils::avgRisk(market, all, Utils::RiskBackend::Dense));
+    EXPECT_EQ(Utils::avgRisk(market, all, market.factorModel(Utils::defaultFactors)), Utils::avgRisk(market, all, Utils::RiskBackend::Factor));
+
+    // a holding the factor model leaves out fails instead of being dropped from the risk
+    all.set(young, 1);
+    EXPECT_TRUE(std::isnan(Utils::avgRisk(market, all, Utils::RiskBackend::Factor)));
+    EXPECT_FALSE(std::isnan(Utils::avgRisk(market, all)));
+}
+
+TEST(Portfolio, batch)
+{
+    AssetInfo info1;
+    info1.avgRisk = 0.20;
+    info1.avgReturn = 0.10;
+    info1.correlation["B"] = -0.3;
+    const Asset asset1 { "A", 1, info1 };
+
+    AssetInfo info2;
+    info2.avgRisk = 0.10;
+    info2.avgReturn = 0.05;
+    info2.correlation["A"] = -0.3;
+    const Asset asset2 { "B", 1, info2 };
+
+    const Market market { { asset1, asset2 } };
+
+    Matrix weights { 11, 2 };
+    for (std::size_t k = 0; k < weights.rows(); ++k) {
+        weights(k, 0) = static_cast<double>(k) / 10;
+        weights(k, 1) = 1 - weights(k, 0);
+    }
+    const auto result = PortfolioBatch::evaluate(market, weights);
+    ASSERT_EQ(11, result.risks.size());
+    ASSERT_EQ(11, result.returns.size());
+    EXPECT_TRUE(result.historicalRisks.empty());
+
+    for (std::size_t k = 0; k < weights.rows(); ++k) {
+        Portfolio portfolio;
+        portfolio.set(asset1.symbol(), weights(k, 0) * 100);
+        portfolio.set(asset2.symbol(), weights(k, 1) * 100);
+        EXPECT_NEAR(Utils::avgRisk(market, portfolio), result.risks[k], epsilon);
+        EXPECT_NEAR(Utils::avgReturn(market, portfolio), result.returns[k], epsilon);
+    }
+}
+
+TEST(Portfolio, batchBlocks)
+{
+    // more portfolios than one block of rows, each one matches the risk model
+    std::vector<Asset> assets;
+    for (const std::string symbol : { "A", "B", "C" }) {
+        AssetInfo info;
+        info.avgRisk = symbol == "A" ? 0.2 : 0.1;
+        for (const std::string other : { "A", "B", "C" }) {
+            info.correlation[other] = symbol == other ? 1 : -0.2;
+        }
+        assets.emplace_back(symbol, 1, info);
+    }
+    const Market market { assets };
+    const RiskModel& model = market.riskModel();
+
+    Matrix weights { 10'000, 3 };
+    for (std::size_t k = 0; k < weights.rows(); ++k) {
+        weights(k, 0) = static_cast<double>(k % 101) / 100;
+        weights(k, 1) = static_cast<double>(k % 7) / 10;
+        weights(k, 2) = 1 - weights(k, 0);
+    }
+    const auto result = PortfolioBatch::evaluate(market, weights);
+    ASSERT_EQ(weights.rows(), result.risks.size());
+    for (std::size_t k = 0; k < weights.rows(); ++k) {
+        EXPECT_NEAR(model.risk({ weights.row(k), weights.row(k) + 3 }), result.risks[k], 1e-12);
+    }
+}
+
+TEST(Portfolio, batchHistoricalRisk)
+{
+    // returns of A: 0.1, 0.2, -0.2 and of B: 0.1, -0.1, 0.25
+    const Market market { { Asset { "A", makeOhlc({ 132, 120, 100, 125 }), {} }, Asset { "B", makeOhlc({ 99, 90, 100, 80 }), {} } } };
+
+    Matrix weights { 2, 2 };
+    weights(0, 0) = 0.5;
+    weights(0, 1) = 0.5;
+    weights(1, 0) = 1;
+    const auto result = PortfolioBatch::evaluate(market, weights, 1);
+    ASSERT_EQ(2, result.historicalRisks.size());
+
+    // 50/50 mix rebalanced every period: 0.1, 0.05, 0.025
+    const double mean = (0.1 + 0.05 + 0.025) / 3;
+    const double mixed = std::sqrt((std::pow(0.1 - mean, 2) + std::pow(0.05 - mean, 2) + std::pow(0.025 - mean, 2)) / 3);
+    EXPECT_NEAR(mixed, result.historicalRisks[0], epsilon);
+    EXPECT_NEAR(0.031180478223, result.historicalRisks[0], 1e-12);
+
+    const double meanA = (0.1 + 0.2 - 0.2) / 3;
+    const double riskA = std::sqrt((std::pow(0.1 - meanA, 2) + std::pow(0.2 - meanA, 2) + std::pow(-0.2 - meanA, 2)) / 3);
+    EXPECT_NEAR(riskA, result.historicalRisks[1], epsilon);
+}
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "lib/Market.hpp"
+#include "lib/Portfolio.hpp"
+#include "lib/Retirement.hpp"
+#include "lib/Utils.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+using namespace portopt;
+
+TEST(Retirement, deterministic)
+{
+    RetirementPlan plan;
+    plan.currentAge = 60;
+    plan.retirementAge = 61;
+    plan.socialSecurityAge = 62;
+    plan.deathAge = 63;
+    plan.rateOfReturnBefore = 0;
+    plan.rateOfReturnAfter = 0;
+
+    const auto savings = Retirement::deterministic(plan);
+    ASSERT_EQ(4, savings.size());
+    EXPECT_DOUBLE_EQ(500'000, savings[0]);
+    EXPECT_DOUBLE_EQ(560'000, savings[1]); // + 12 * 5000
+    EXPECT_DOUBLE_EQ(500'000, savings[2]); // - 12 * 5000
+    EXPECT_DOUBLE_EQ(452'000, savings[3]); // - 12 * 4000
+}
+
+TEST(Retirement, monteCarlo)
+{
+    const RetirementPlan plan; // default plan, 4% before and 2% after retirement
+    const std::vector<double> constant(120, 0.04 / 12); // every path is the same
+
+    RetirementPlan fixedRate = plan;
+    fixedRate.rateOfReturnAfter = fixedRate.rateOfReturnBefore;
+    const auto expected = Retirement::deterministic(fixedRate);
+
+    const auto result = Retirement::monteCarlo(plan, constant, 1000);
+    EXPECT_EQ(1000, result.numPaths);
+    ASSERT_EQ(expected.size(), result.bands.size());
+    ASSERT_EQ(expected.size(), result.ages.size());
+    EXPECT_EQ(plan.currentAge, result.ages.front());
+    EXPECT_EQ(plan.deathAge, result.ages.back());
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_NEAR(expected[i], result.bands[i][0], 1e-6 * std::abs(expected[i]));
+        EXPECT_NEAR(expected[i], result.bands[i][4], 1e-6 * std::abs(expected[i]));
+    }
+    EXPECT_DOUBLE_EQ(expected.back() >= 0 ? 1 : 0, result.successProbability);
+
+    // random returns, reproducible from the seed and ordered bands
+    std::vector<double> returns;
+    for (int i = 0; i < 240; ++i) {
+        returns.push_back(0.005 + 0.04 * std::sin(i * 1.7));
+    }
+    const auto a = Retirement::monteCarlo(plan, returns, 5000, 12, 42);
+    const auto b = Retirement::monteCarlo(plan, returns, 5000, 12, 42);
+    EXPECT_DOUBLE_EQ(a.successProbability, b.successProbability);
+    EXPECT_GT(a.successProbability, 0);
+    EXPECT_LE(a.successProbability, 1);
+    for (std::size_t i = 0; i < a.bands.size(); ++i) {
+        EXPECT_EQ(a.bands[i], b.bands[i]);
+        EXPECT_TRUE(std::is_sorted(a.bands[i].begin(), a.bands[i].end()));
+    }
+}
+
+TEST(Retirement, monthlyReturns)
+{
+    OhlcVector data; // price doubles every 30 days, most recent first
+    const auto today = Utils::toTimePoint("2020-12-31");
+    for (std::size_t i = 0; i < 91; ++i) {
+        Ohlc item { std::pow(2.0, 3.0 - static_cast<double>(i) / 30) };
+        item.timepoint = today - std::chrono::days { i };
+        data.push_back(item);
+    }
+    const Market market { { Asset { "A", OhlcList { data }, {} } } };
+
+    Portfolio portfolio;
+    portfolio.set("A", 1);
+    portfolio.set("CASH", 0);
+    const auto returns = Retirement::monthlyReturns(market, portfolio);
+    ASSERT_EQ(3, returns.size());
+    for (const double value : returns) {
+        EXPECT_NEAR(1, value, 1e-9);
+    }
+}
+
+namespace {
+
+// age when savings first run out after retirement, 0 if they never do
+double depletionAge(const RetirementPlan& plan)
+{
+    double savings = plan.currentSavings;
+    for (int month = plan.currentAge * 12; month < plan.deathAge * 12; ++month) {
+        if (month < plan.retirementAge * 12) {
+            savings = savings * (1 + plan.rateOfReturnBefore / 1200) + plan.monthlySavings;
+            continue;
+        }
+        if (savings > 0) {
+            savings *= 1 + plan.rateOfReturnAfter / 1200;
+        }
+        savings -= plan.monthlyExpenses;
+        if (month >= plan.socialSecurityAge * 12) {
+            savings += plan.socialSecurity;
+        }
+        if (savings <= 0) {
+            return (month + 1) / 12.0;
+        }
+    }
+    return 0;
+}
+
+} // anonymous namespace
+
+TEST(Retirement, closedForm)
+{
+    RetirementPlan plan;
+    for (const int retirementAge : { 30, 42, 67, 75, 90 }) {
+        for (const double expenses : { 0.0, 2000.0, 5000.0, 9000.0 }) {
+            for (const double social : { 0.0, 1000.0, 9500.0 }) {
+                for (const double rate : { -3.0, 0.0, 2.0, 7.0 }) {
+                    plan.retirementAge = retirementAge;
+                    plan.monthlyExpenses = expenses;
+                    plan.socialSecurity = social;
+                    plan.rateOfReturnBefore = rate + 2;
+                    plan.rateOfReturnAfter = rate;
+                    const double expected = Retirement::deterministic(plan).back();
+                    const auto actual = Retirement::evaluate(plan);
+                    EXPECT_NEAR(expected, actual.endBalance, 1e-6 * std::max(1.0, std::abs(expected)))
+                        << retirementAge << " " << expenses << " " << social << " " << rate;
+                    EXPECT_NEAR(depletionAge(plan), actual.depletionAge, 1e-9)
+                        << retirementAge << " " << expenses << " " << social << " " << rate;
+                }
+            }
+        }
+    }
+}
+
+TEST(Retirement, sweep)
+{
+    RetirementPlan plan;
+    plan.currentAge = 60;
+    plan.currentSavings = 120'000;
+    plan.monthlySavings = 0;
+    plan.socialSecurity = 0;
+
+    RetirementGrid grid;
+    grid.retirementAges = { 60, 65 };
+    grid.monthlySavings = { 0, 1000 };
+    grid.monthlyExpenses = { 1000, 2000 };
+    grid.ratesOfReturn = { { 0, 0 }, { 5, 3 } };
+    ASSERT_EQ(16, grid.size());
+
+    const auto scenarios = Retirement::sweep(plan, grid);
+    ASSERT_EQ(16, scenarios.size());
+    EXPECT_EQ(60, scenarios[0].retirementAge);
+    EXPECT_DOUBLE_EQ(1000, scenarios[0].monthlyExpenses);
+    EXPECT_DOUBLE_EQ(0, scenarios[0].rateOfReturnAfter);
+    EXPECT_DOUBLE_EQ(70, scenarios[0].depletionAge); // 120 months of expenses
+    EXPECT_DOUBLE_EQ(120'000 - 30 * 12 * 1000, scenarios[0].endBalance);
+    EXPECT_DOUBLE_EQ(65, scenarios[2].depletionAge); // 2000 per month
+    EXPECT_DOUBLE_EQ(3, scenarios[1].rateOfReturnAfter);
+    EXPECT_EQ(65, scenarios[15].retirementAge);
+    EXPECT_DOUBLE_EQ(1000, scenarios[15].monthlySavings);
+}
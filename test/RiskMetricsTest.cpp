@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "lib/Market.hpp"
+#include "lib/Portfolio.hpp"
+#include "lib/ReturnMatrix.hpp"
+#include "lib/RiskMetrics.hpp"
+#include "lib/Utils.hpp"
+#include "test/TestMarket.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+using namespace portopt;
+
+namespace {
+
+constexpr double epsilon = 1e-9;
+
+} // anonymous namespace
+
+TEST(RiskMetrics, normalQuantile)
+{
+    EXPECT_NEAR(0, RiskMetrics::normalQuantile(0.5), epsilon);
+    EXPECT_NEAR(1.959963985, RiskMetrics::normalQuantile(0.975), 1e-8);
+    EXPECT_NEAR(-1.644853627, RiskMetrics::normalQuantile(0.05), 1e-8);
+    EXPECT_NEAR(-3.090232306, RiskMetrics::normalQuantile(0.001), 1e-8);
+    EXPECT_DOUBLE_EQ(-2, RiskMetrics::cornishFisher(-2, 0, 0));
+    EXPECT_LT(RiskMetrics::cornishFisher(-2, -1, 3), -2); // fat left tail
+}
+
+TEST(RiskMetrics, drawdown)
+{
+    // oldest to most recent: +10%, -50%, +20%, +25%, the value never gets back to 1.1
+    const std::vector<double> returns { 0.25, 0.2, -0.5, 0.1 };
+    const RiskStats risk = RiskMetrics::compute(returns, 252);
+    EXPECT_EQ(4, risk.size);
+    EXPECT_NEAR(0.5, risk.maxDrawdown, epsilon);
+    EXPECT_EQ(3, risk.drawdownDuration);
+    EXPECT_NEAR(0.0125, risk.mean, epsilon);
+    EXPECT_NEAR(Utils::stdDev(returns), risk.stdDev, epsilon);
+    EXPECT_NEAR(0.25, risk.downsideDeviation, epsilon); // sqrt(0.5^2 / 4)
+    EXPECT_NEAR(0.0125 * std::sqrt(252) / 0.25, risk.sortino, epsilon);
+    EXPECT_NEAR((std::pow(0.825, 252 / 4.0) - 1) / 0.5, risk.calmar, epsilon);
+    EXPECT_LT(risk.skewness, 0);
+}
+
+TEST(RiskMetrics, valueAtRisk)
+{
+    // -5% to +4.9% in steps of 0.1%, in a scrambled order
+    std::vector<double> returns(100);
+    for (std::size_t i = 0; i < returns.size(); ++i) {
+        returns[(i * 37) % 100] = (static_cast<double>(i) / 1000) - 0.05;
+    }
+    const RiskStats risk = RiskMetrics::compute(returns, 252);
+    ASSERT_EQ(0.95, RiskStats::confidenceLevels[0]);
+    EXPECT_NEAR(0.045, risk.var[0], epsilon); // 6th smallest
+    EXPECT_NEAR(0.0475, risk.cvar[0], epsilon);
+    EXPECT_NEAR(0.049, risk.var[1], epsilon);
+    EXPECT_NEAR(0.0495, risk.cvar[1], epsilon);
+
+    // symmetric, so only the kurtosis moves the Cornish-Fisher quantiles: thin tails, less than the normal 99% VaR
+    EXPECT_NEAR(0, risk.skewness, 1e-6);
+    EXPECT_NEAR(-1.2, risk.excessKurtosis, 1e-3);
+    const double normalVar = -(risk.mean + RiskMetrics::normalQuantile(0.01) * risk.stdDev);
+    EXPECT_LT(risk.cornishFisherVar[1], normalVar);
+    EXPECT_GT(risk.cornishFisherCvar[0], risk.cornishFisherVar[0]);
+    EXPECT_GT(risk.cornishFisherCvar[1], risk.cornishFisherCvar[0]);
+
+    const auto values = risk.values();
+    ASSERT_EQ(RiskStats::names().size(), values.size());
+    EXPECT_EQ(values, RiskStats::fromValues(values).values());
+}
+
+TEST(RiskMetrics, market)
+{
+    std::vector<Asset> assets;
+    for (int a = 0; a < 3; ++a) {
+        OhlcVector data;
+        const auto today = Utils::toTimePoint("2020-01-31");
+        const auto price = [a](std::size_t i) { return 100 + (10 * std::sin(static_cast<double>(i) * 0.3 * (a + 1))); };
+        for (std::size_t i = 0; i < 50; ++i) {
+            const bool dummy = a == 0 && i % 7 == 3;
+            Ohlc item { price(dummy ? i + 1 : i) }; // a dummy copies the older entry, like the forward filling
+            item.timepoint = today - std::chrono::days { i };
+            item.dummy = dummy;
+            data.push_back(item);
+        }
+        assets.emplace_back("S" + std::to_string(a), OhlcList { data }, AssetInfo {});
+    }
+    const Market market { assets };
+
+    const ReturnMatrix& returns = market.returns(1, PriceType::Close);
+    const auto batch = RiskMetrics::compute(returns);
+    ASSERT_EQ(3, batch.size());
+    // dummies are skipped instead of counted as flat days, by both overloads
+    const RiskStats real = RiskMetrics::compute(market.get("S0").ohlc());
+    EXPECT_EQ(49 - 7, real.size);
+    EXPECT_EQ(49, RiskMetrics::compute(market.get("S1").ohlc()).size);
+    for (std::size_t a = 0; a < batch.size(); ++a) {
+        const auto single = RiskMetrics::compute(market.get(returns.symbols()[a]).ohlc(), PriceType::Close);
+        EXPECT_EQ(single.size, batch[a].size);
+        const auto expected = single.values();
+        const auto actual = batch[a].values();
+        for (std::size_t i = 0; i < expected.size(); ++i) {
+            EXPECT_NEAR(expected[i], actual[i], 1e-12) << RiskStats::names()[i];
+        }
+    }
+    EXPECT_EQ(RiskStats::names().size(), real.values().size());
+    EXPECT_EQ(real.values(), RiskStats::fromValues(real.values()).values());
+}
+
+TEST(RiskMetrics, portfolio)
+{
+    // two stocks forward filled over the weekends and some cash, which keeps its value on every day
+    constexpr std::size_t numDays = 50;
+    std::vector<std::vector<double>> prices(2, std::vector<double>(numDays));
+    for (std::size_t i = 0; i < numDays; ++i) {
+        prices[0][i] = 100 + (10 * std::sin(static_cast<double>(i) * 0.3));
+        prices[1][i] = 50 + (5 * std::cos(static_cast<double>(i) * 0.7));
+    }
+    const Market market { { Asset { "S0", makeWeekdayOhlc(prices[0]), {} }, Asset { "S1", makeWeekdayOhlc(prices[1]), {} } } };
+    Portfolio portfolio;
+    portfolio.set("S0", 10);
+    portfolio.set("S1", 5);
+    portfolio.set("CASH", 1000);
+
+    const auto weekdays0 = weekdayPrices(prices[0]);
+    const auto weekdays1 = weekdayPrices(prices[1]);
+    std::vector<double> returns;
+    for (std::size_t i = 0; i + 1 < weekdays0.size(); ++i) {
+        const double today = (10 * weekdays0[i]) + (5 * weekdays1[i]) + 1000;
+        const double yesterday = (10 * weekdays0[i + 1]) + (5 * weekdays1[i + 1]) + 1000;
+        returns.push_back((today - yesterday) / yesterday);
+    }
+    const RiskStats expected = RiskMetrics::compute(returns, 252);
+    const RiskStats actual = RiskMetrics::compute(market, portfolio, numDays - 1);
+    ASSERT_EQ(returns.size(), actual.size);
+    const auto expectedValues = expected.values();
+    const auto actualValues = actual.values();
+    for (std::size_t i = 0; i < expectedValues.size(); ++i) {
+        EXPECT_NEAR(expectedValues[i], actualValues[i], 1e-12) << RiskStats::names()[i];
+    }
+    EXPECT_GT(actual.stdDev, 0);
+
+    Portfolio cash;
+    cash.set("CASH", 1000);
+    EXPECT_EQ(0, RiskMetrics::compute(market, cash, numDays - 1).size);
+}
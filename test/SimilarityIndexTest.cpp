@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#include "lib/SimilarityIndex.hpp"
+#include "lib/Utils.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+
+using namespace portopt;
+
+constexpr double epsilon = 1e-9;
+
+namespace {
+
+// random walks around a few common factors, so some pairs are highly correlated
+SimilarityIndex makeIndex(std::vector<std::vector<double>>& series)
+{
+    std::mt19937_64 rng { 7 };
+    std::normal_distribution<double> normal;
+    constexpr std::size_t length = 150;
+
+    std::vector<std::vector<double>> factors(4, std::vector<double>(length));
+    for (auto& factor : factors) {
+        double value {};
+        for (auto& item : factor) {
+            item = value += normal(rng);
+        }
+    }
+
+    std::vector<std::string> symbols;
+    for (std::size_t i = 0; i < 60; ++i) {
+        const double noise = (i % 3 == 0) ? 0.1 : (i % 3 == 1 ? 1 : 5);
+        std::vector<double> values(length);
+        double value {};
+        for (std::size_t t = 0; t < length; ++t) {
+            value += noise * normal(rng);
+            values[t] = factors[i % factors.size()][t] + value;
+        }
+        symbols.push_back("S" + std::to_string(i));
+        series.push_back(values);
+    }
+    symbols.emplace_back("FLAT");
+    series.emplace_back(length, 1.0); // constant series never match
+    return SimilarityIndex { symbols, series, 4 };
+}
+
+} // anonymous namespace
+
+TEST(SimilarityIndex, topK)
+{
+    std::vector<std::vector<double>> series;
+    const auto index = makeIndex(series);
+    EXPECT_EQ(61, index.size());
+    EXPECT_EQ(3, index.index("S3"));
+    EXPECT_EQ(SimilarityIndex::npos, index.index("XYZ"));
+    EXPECT_NEAR(Utils::pearsonCorrelation(series[0], series[4]), index.correlation(0, 4), epsilon);
+
+    const auto all = index.allTopK(5, 0.5);
+    for (std::size_t q = 0; q < 60; ++q) {
+        std::vector<double> expected;
+        for (std::size_t j = 0; j < 60; ++j) {
+            const double correlation = Utils::pearsonCorrelation(series[q], series[j]);
+            if (j != q && correlation >= 0.5) {
+                expected.push_back(correlation);
+            }
+        }
+        std::sort(expected.rbegin(), expected.rend());
+        expected.resize(std::min<std::size_t>(5, expected.size()));
+
+        for (const auto& matches : { all[q], index.topK(q, 5, 0.5) }) {
+            ASSERT_EQ(expected.size(), matches.size()) << q;
+            for (std::size_t m = 0; m < matches.size(); ++m) {
+                EXPECT_NEAR(expected[m], matches[m].correlation, epsilon);
+                EXPECT_NE(q, matches[m].index);
+            }
+        }
+    }
+    EXPECT_EQ(3, index.allTopK(3)[7].size()); // no threshold
+    EXPECT_TRUE(index.topK(60, 3).empty()); // constant series
+}
+
+TEST(SimilarityIndex, pairsAbove)
+{
+    std::vector<std::vector<double>> series;
+    const auto index = makeIndex(series);
+
+    for (const double tau : { 0.99, 0.9, 0.5 }) {
+        std::size_t expected {};
+        for (std::size_t i = 0; i < 60; ++i) {
+            for (std::size_t j = i + 1; j < 60; ++j) {
+                expected += Utils::pearsonCorrelation(series[i], series[j]) >= tau ? 1 : 0;
+            }
+        }
+        const auto pairs = index.pairsAbove(tau);
+        EXPECT_EQ(expected, pairs.size()) << tau;
+        for (std::size_t p = 0; p < pairs.size(); ++p) {
+            EXPECT_LT(pairs[p].first, pairs[p].second);
+            EXPECT_NEAR(Utils::pearsonCorrelation(series[pairs[p].first], series[pairs[p].second]), pairs[p].correlation, epsilon);
+            if (p > 0) {
+                EXPECT_GE(pairs[p - 1].correlation, pairs[p].correlation);
+            }
+        }
+    }
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2021  Faraz Fallahi <fffaraz@gmail.com>
+ *
+ * Use of this source code is governed by an MIT-style
+ * license that can be found in the LICENSE file
+ */
+
+#pragma once
+
+#include "lib/Market.hpp"
+#include "lib/Utils.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+// Synthetic price histories shared by the tests
+namespace portopt {
+
+// daily prices ending on lastDate, prices[0] is the most recent
+inline OhlcList makeOhlc(const std::vector<double>& prices, TimePoint lastDate = Utils::toTimePoint("2020-01-31"))
+{
+    OhlcVector data;
+    for (std::size_t i = 0; i < prices.size(); ++i) {
+        Ohlc item { prices[i] };
+        item.timepoint = lastDate - std::chrono::days { i };
+        data.push_back(item);
+    }
+    return OhlcList { data };
+}
+
+inline bool isWeekend(TimePoint tp)
+{
+    const std::chrono::weekday day { std::chrono::floor<std::chrono::days>(tp) };
+    return day == std::chrono::Saturday || day == std::chrono::Sunday;
+}
+
+// makeOhlc with the Saturdays and Sundays forward filled, each one a dummy copy of the older entry
+inline OhlcList makeWeekdayOhlc(const std::vector<double>& prices, TimePoint lastDate = Utils::toTimePoint("2020-01-31"))
+{
+    OhlcVector data(prices.size());
+    for (std::size_t i = prices.size(); i-- > 0;) { // oldest first
+        const TimePoint timepoint = lastDate - std::chrono::days { i };
+        const bool dummy = isWeekend(timepoint) && i + 1 < prices.size();
+        data[i] = Ohlc { dummy ? data[i + 1].close : prices[i] };
+        data[i].timepoint = timepoint;
+        data[i].dummy = dummy;
+    }
+    return OhlcList { data };
+}
+
+// the prices of the weekdays only, as dated by makeOhlc
+inline std::vector<double> weekdayPrices(const std::vector<double>& prices, TimePoint lastDate = Utils::toTimePoint("2020-01-31"))
+{
+    std::vector<double> result;
+    for (std::size_t i = 0; i < prices.size(); ++i) {
+        if (!isWeekend(lastDate - std::chrono::days { i })) {
+            result.push_back(prices[i]);
+        }
+    }
+    return result;
+}
+
+// prices compounded from 100 by the returns, both most recent first
+inline std::vector<double> pricesFromReturns(const std::vector<double>& returns)
+{
+    std::vector<double> prices(returns.size());
+    double price = 100;
+    for (std::size_t i = returns.size(); i-- > 0;) { // oldest first
+        price *= 1 + returns[i];
+        prices[i] = price;
+    }
+    return prices;
+}
+
+// prices of numAssets assets from seeded daily returns, each the sum of loading(asset, f) times the common factor f
+// drawn with volatilities[f], plus noise of its own, both most recent first
+inline std::vector<std::vector<double>> factorPrices(std::size_t numAssets, std::size_t numPeriods, std::uint64_t seed, const std::vector<double>& volatilities,
+    const std::function<double(std::size_t asset, std::size_t factor)>& loading, double noise)
+{
+    std::mt19937_64 engine { seed };
+    std::normal_distribution<double> normal;
+    std::vector<std::vector<double>> returns(numAssets, std::vector<double>(numPeriods));
+    std::vector<double> factors(volatilities.size());
+    for (std::size_t t = 0; t < numPeriods; ++t) {
+        for (std::size_t f = 0; f < factors.size(); ++f) {
+            factors[f] = volatilities[f] * normal(engine);
+        }
+        for (std::size_t a = 0; a < numAssets; ++a) {
+            for (std::size_t f = 0; f < factors.size(); ++f) {
+                returns[a][t] += loading(a, f) * factors[f];
+            }
+            returns[a][t] += noise * normal(engine);
+        }
+    }
+    std::vector<std::vector<double>> prices;
+    for (const auto& series : returns) {
+        prices.push_back(pricesFromReturns(series));
+    }
+    return prices;
+}
+
+// assets "S<firstSymbol>", "S<firstSymbol + 1>", ... with the daily prices of makeOhlc
+inline Market makeMarket(const std::vector<std::vector<double>>& prices, std::size_t firstSymbol = 0, TimePoint lastDate = Utils::toTimePoint("2020-01-31"))
+{
+    std::vector<Asset> assets;
+    for (std::size_t a = 0; a < prices.size(); ++a) {
+        assets.emplace_back("S" + std::to_string(firstSymbol + a), makeOhlc(prices[a], lastDate), AssetInfo {});
+    }
+    return Market { assets };
+}
+
+} // namespace portopt
@@ -5,10 +5,17 @@
  * license that can be found in the LICENSE file
  */
 
+#include "lib/ReportWriter.hpp"
+#include "lib/RollingStats.hpp"
 #include "lib/Utils.hpp"
 
 #include <gtest/gtest.h>
 
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
 using namespace portopt;
 
 constexpr double epsilon = 1e-3;
@@ -105,3 +112,88 @@ TEST(Utils, pow)
     EXPECT_EQ(4, Utils::powi(2, 2));
     EXPECT_EQ(8, Utils::powi(2, 3));
 }
+
+TEST(Utils, parallelFor)
+{
+    std::vector<int> values(1000);
+    Utils::parallelFor(values.size(), [&values](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            values[i] += static_cast<int>(i);
+        }
+    });
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        EXPECT_EQ(static_cast<int>(i), values[i]);
+    }
+}
+
+TEST(Utils, rollingStats)
+{
+    const std::vector<double> x { 1, 3, 2, 5, 4, 6, 8, 7, 9, 3, 1, 2 };
+    const std::vector<double> y { 2, 1, 4, 3, 6, 5, 7, 9, 8, 2, 3, 1 };
+    const std::size_t window = 5;
+
+    const auto mean = RollingStats::mean(x, window);
+    const auto stdDev = RollingStats::stdDev(x, window);
+    const auto correlation = RollingStats::correlation(x, y, window);
+    const auto beta = RollingStats::beta(x, y, window);
+    ASSERT_EQ(x.size() - window + 1, mean.size());
+    ASSERT_EQ(mean.size(), correlation.size());
+
+    for (std::size_t i = 0; i < mean.size(); ++i) {
+        const std::vector<double> wx(x.begin() + i, x.begin() + i + window);
+        const std::vector<double> wy(y.begin() + i, y.begin() + i + window);
+        EXPECT_NEAR(Utils::mean(wx), mean[i], epsilon);
+        EXPECT_NEAR(Utils::stdDev(wx), stdDev[i], epsilon);
+        EXPECT_NEAR(Utils::pearsonCorrelation(wx, wy), correlation[i], epsilon);
+        EXPECT_NEAR(Utils::linearRegression(wy, wx).first, beta[i], epsilon);
+    }
+}
+
+TEST(Utils, reportWriter)
+{
+    // same text as the std::ostream formatting it replaces
+    const std::vector<double> values { 0, -0.0, 1, -1.5, 0.1, 1.0 / 3, 123456, 1234567, 1e-5, 12.345678, -0.004, 3.33e+06, 1e300 };
+    for (const double value : values) {
+        std::ostringstream general;
+        general << value;
+        std::ostringstream fixed;
+        fixed << std::fixed << std::setprecision(2) << value;
+
+        ReportBuffer buffer;
+        buffer.append(value);
+        EXPECT_EQ(general.str(), buffer.view());
+        buffer.clear();
+        buffer.appendFixed(value, 2);
+        EXPECT_EQ(fixed.str(), buffer.view());
+    }
+
+    ReportBuffer buffer;
+    buffer.appendDate(Utils::toTimePoint("2020-02-09"));
+    buffer.append(',');
+    buffer.append(true);
+    buffer.append(std::size_t { 42 });
+    EXPECT_EQ("2020-02-09,142", buffer.view());
+
+    const auto filePath = std::filesystem::temp_directory_path() / "portopt-report-writer.csv";
+    {
+        ReportWriter writer { filePath };
+        ASSERT_TRUE(writer.isOpen());
+        writer << "row\n";
+        writer.writeRows(10000, [](ReportBuffer& row, std::size_t i) {
+            row.append(i);
+            row.append('\n');
+        });
+        writer << "end\n";
+    }
+    std::ifstream file { filePath };
+    std::string line;
+    std::getline(file, line);
+    EXPECT_EQ("row", line);
+    for (std::size_t i = 0; i < 10000; ++i) {
+        std::getline(file, line);
+        ASSERT_EQ(std::to_string(i), line);
+    }
+    std::getline(file, line);
+    EXPECT_EQ("end", line);
+    std::filesystem::remove(filePath);
+}